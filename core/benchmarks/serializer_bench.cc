@@ -0,0 +1,155 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "benchmark_helpers.h"
+#include "prometheus/counter.h"
+#include "prometheus/family.h"
+#include "prometheus/gauge.h"
+#include "prometheus/histogram.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/openmetrics_serializer.h"
+#include "prometheus/protobuf_serializer.h"
+#include "prometheus/registry.h"
+#include "prometheus/text_serializer.h"
+
+namespace {
+
+// Mix of families as found in a typical service: request counters and
+// latency histograms with a few labels each and some gauges.
+void FillRegistry(prometheus::Registry& registry, std::size_t series) {
+  using prometheus::BuildCounter;
+  using prometheus::BuildGauge;
+  using prometheus::BuildHistogram;
+  using prometheus::Histogram;
+
+  auto& requests = BuildCounter()
+                       .Name("http_requests_total")
+                       .Help("Number of HTTP requests")
+                       .Labels({{"service", "benchmark"}})
+                       .Register(registry);
+  auto& latencies = BuildHistogram()
+                        .Name("http_request_duration_seconds")
+                        .Help("Latency of HTTP requests")
+                        .Register(registry);
+  auto& connections = BuildGauge()
+                          .Name("open_connections")
+                          .Help("Number of open connections")
+                          .Register(registry);
+
+  const auto buckets = Histogram::BucketBoundaries{
+      0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+  for (std::size_t i = 0; i < series; ++i) {
+    auto labels = GenerateRandomLabels(3);
+    requests.Add(labels).Increment(i * 17);
+    connections.Add(labels).Set(i / 7.0);
+
+    auto& histogram = latencies.Add(labels, buckets);
+    for (std::size_t j = 0; j < 10; ++j) {
+      histogram.Observe((i + j) * 0.013);
+    }
+  }
+}
+
+// Discards everything, so only the cost of serializing is measured
+class CountingBuffer : public std::streambuf {
+ public:
+  std::size_t size() const { return size_; }
+
+ protected:
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    size_ += static_cast<std::size_t>(count);
+    return count;
+  }
+
+  int_type overflow(int_type ch) override {
+    ++size_;
+    return ch;
+  }
+
+ private:
+  std::size_t size_ = 0;
+};
+
+}  // namespace
+
+static void BM_TextSerializer_Serialize(benchmark::State& state) {
+  prometheus::Registry registry;
+  FillRegistry(registry, state.range(0));
+  const auto families = registry.Collect();
+  const prometheus::TextSerializer serializer;
+
+  std::size_t bytes = 0;
+  while (state.KeepRunning()) {
+    auto body = serializer.Serialize(families);
+    bytes += body.size();
+    benchmark::DoNotOptimize(body);
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_TextSerializer_Serialize)->Range(1, 4096);
+
+static void BM_TextSerializer_CollectIntoSink(benchmark::State& state) {
+  prometheus::Registry registry;
+  FillRegistry(registry, state.range(0));
+  const prometheus::TextSerializer serializer;
+  CountingBuffer buffer;
+  std::ostream out{&buffer};
+
+  while (state.KeepRunning()) {
+    registry.Collect(*serializer.MakeSink(out));
+  }
+  state.SetBytesProcessed(buffer.size());
+}
+BENCHMARK(BM_TextSerializer_CollectIntoSink)->Range(1, 4096);
+
+static void BM_ProtobufSerializer_Serialize(benchmark::State& state) {
+  prometheus::Registry registry;
+  FillRegistry(registry, state.range(0));
+  const auto families = registry.Collect();
+  const prometheus::ProtobufSerializer serializer;
+
+  std::size_t bytes = 0;
+  while (state.KeepRunning()) {
+    auto body = serializer.Serialize(families);
+    bytes += body.size();
+    benchmark::DoNotOptimize(body);
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_ProtobufSerializer_Serialize)->Range(1, 4096);
+
+static void BM_ProtobufSerializer_CollectIntoSink(benchmark::State& state) {
+  prometheus::Registry registry;
+  FillRegistry(registry, state.range(0));
+  const prometheus::ProtobufSerializer serializer;
+  CountingBuffer buffer;
+  std::ostream out{&buffer};
+
+  while (state.KeepRunning()) {
+    registry.Collect(*serializer.MakeSink(out));
+  }
+  state.SetBytesProcessed(buffer.size());
+}
+BENCHMARK(BM_ProtobufSerializer_CollectIntoSink)->Range(1, 4096);
+
+static void BM_OpenMetricsSerializer_CollectIntoSink(benchmark::State& state) {
+  prometheus::Registry registry;
+  FillRegistry(registry, state.range(0));
+  const prometheus::OpenMetricsSerializer serializer;
+  CountingBuffer buffer;
+  std::ostream out{&buffer};
+
+  while (state.KeepRunning()) {
+    auto sink = serializer.MakeSink(out);
+    registry.Collect(*sink);
+    sink->Finish();
+  }
+  state.SetBytesProcessed(buffer.size());
+}
+BENCHMARK(BM_OpenMetricsSerializer_CollectIntoSink)->Range(1, 4096);
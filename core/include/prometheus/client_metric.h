@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -26,10 +27,19 @@ struct PROMETHEUS_CPP_CORE_EXPORT ClientMetric {
   };
   std::vector<Label> label;
 
+  // Exemplar
+
+  struct Exemplar {
+    std::vector<Label> label;
+    double value = 0.0;
+    std::int64_t timestamp_ms = 0;
+  };
+
   // Counter
 
   struct Counter {
     double value = 0.0;
+    std::shared_ptr<const Exemplar> exemplar;
   };
   Counter counter;
 
@@ -66,6 +76,7 @@ struct PROMETHEUS_CPP_CORE_EXPORT ClientMetric {
   struct Bucket {
     std::uint64_t cumulative_count = 0;
     double upper_bound = 0.0;
+    std::shared_ptr<const Exemplar> exemplar;
   };
 
   struct Histogram {
@@ -85,6 +96,10 @@ struct PROMETHEUS_CPP_CORE_EXPORT ClientMetric {
   // Timestamp
 
   std::int64_t timestamp_ms = 0;
+
+  // Creation time of counters, summaries and histograms, 0 if unknown
+
+  std::int64_t created_timestamp_ms = 0;
 };
 
 }  // namespace prometheus
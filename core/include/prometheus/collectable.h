@@ -6,6 +6,7 @@
 
 namespace prometheus {
 struct MetricFamily;
+class MetricSink;
 }
 
 namespace prometheus {
@@ -20,6 +21,13 @@ class PROMETHEUS_CPP_CORE_EXPORT Collectable {
 
   /// \brief Returns a list of metrics and their samples.
   virtual std::vector<MetricFamily> Collect() const = 0;
+
+  /// \brief Pushes all metrics and their samples into the given sink.
+  ///
+  /// In contrast to Collect() nothing has to be materialized, so the samples
+  /// can be serialized while they are being collected. The default
+  /// implementation feeds the result of Collect() into the sink.
+  virtual void Collect(MetricSink& sink) const;
 };
 
 }  // namespace prometheus
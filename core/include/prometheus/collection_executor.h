@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "prometheus/detail/core_export.h"
+
+namespace prometheus {
+
+/// \brief Runs a task, e.g., by posting it to a thread pool.
+using Executor = std::function<void(std::function<void()>)>;
+
+/// \brief Dedicated threads collecting, serializing and compressing metrics.
+///
+/// Keeps monitoring work off the threads and cores of the application's hot
+/// path: the threads can be pinned to housekeeping cores and run with a
+/// lower priority. Hand AsExecutor() to an Exposer endpoint or a Gateway,
+/// they pass the rendered result back to their own threads for sending.
+class PROMETHEUS_CPP_CORE_EXPORT CollectionExecutor {
+ public:
+  struct Options {
+    std::size_t num_threads = 1;
+    /// CPUs the threads may run on, empty for all.
+    std::vector<int> cpus;
+    /// Nice value of the threads, 0 to keep the one of the process.
+    int nice = 0;
+    /// Lets the threads run with the SCHED_IDLE policy, i.e., only on
+    /// otherwise idle CPUs.
+    bool idle_priority = false;
+  };
+
+  /// \brief Starts the threads.
+  ///
+  /// Affinity, nice value and idle priority are only supported on Linux.
+  /// Throws std::runtime_error if they are requested on other platforms or
+  /// cannot be applied, e.g., because a CPU does not exist or a negative
+  /// nice value is not permitted.
+  explicit CollectionExecutor(const Options& options);
+  CollectionExecutor();
+
+  /// \brief Runs the pending tasks and stops the threads.
+  ~CollectionExecutor();
+
+  CollectionExecutor(const CollectionExecutor&) = delete;
+  CollectionExecutor(CollectionExecutor&&) = delete;
+  CollectionExecutor& operator=(const CollectionExecutor&) = delete;
+  CollectionExecutor& operator=(CollectionExecutor&&) = delete;
+
+  /// \brief Queues the task for one of the threads.
+  ///
+  /// Tasks are expected to pass on their errors themselves, e.g., through a
+  /// std::promise as Exposer endpoints and the Gateway do. An exception
+  /// escaping a task is dropped without being reported, so the thread goes
+  /// on with the next task.
+  void Post(std::function<void()> task);
+
+  /// \brief Returns an executor posting to this one, which has to outlive
+  /// its users.
+  Executor AsExecutor();
+
+ private:
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable pending_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace prometheus
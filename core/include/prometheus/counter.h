@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include "prometheus/client_metric.h"
 #include "prometheus/detail/builder.h"  // IWYU pragma: export
 #include "prometheus/detail/core_export.h"
+#include "prometheus/detail/exemplar_slot.h"
 #include "prometheus/gauge.h"
+#include "prometheus/labels.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 
 namespace prometheus {
@@ -21,6 +27,10 @@ namespace prometheus {
 /// Do not use a counter to expose a value that can decrease - instead use a
 /// Gauge.
 ///
+/// Increments can carry an exemplar, e.g., the id of the trace that caused
+/// them. Only the latest exemplar is kept, it is exposed by serializers that
+/// support exemplars like the OpenMetricsSerializer.
+///
 /// The class is thread-safe. No concurrent call to any API of this type causes
 /// a data race.
 class PROMETHEUS_CPP_CORE_EXPORT Counter {
@@ -28,7 +38,7 @@ class PROMETHEUS_CPP_CORE_EXPORT Counter {
   static const MetricType metric_type{MetricType::Counter};
 
   /// \brief Create a counter that starts at 0.
-  Counter() = default;
+  Counter();
 
   /// \brief Increment the counter by 1.
   void Increment();
@@ -38,6 +48,16 @@ class PROMETHEUS_CPP_CORE_EXPORT Counter {
   /// The counter will not change if the given amount is negative.
   void Increment(double);
 
+  /// \brief Increment the counter by a given amount and attach an exemplar.
+  ///
+  /// The exemplar replaces the one of earlier increments. Storing it takes no
+  /// lock. The counter will not change if the given amount is negative.
+  ///
+  /// \param exemplar_labels Labels of the exemplar, e.g., a trace id.
+  /// \throw std::invalid_argument on invalid exemplar labels or if they are
+  /// longer than 128 characters in total.
+  void Increment(double, const Labels& exemplar_labels);
+
   /// \brief Reset the counter to 0
   void Reset();
 
@@ -49,8 +69,16 @@ class PROMETHEUS_CPP_CORE_EXPORT Counter {
   /// Collect is called by the Registry when collecting metrics.
   ClientMetric Collect() const;
 
+  /// \brief Get the current value of the counter as compact record.
+  ///
+  /// Collect is called by the Family when streaming metrics into a
+  /// MetricSink.
+  void Collect(MetricRecord& record, MetricRecordArena& arena) const;
+
  private:
   Gauge gauge_{0.0};
+  detail::ExemplarSlot exemplar_;
+  std::atomic<std::int64_t> created_timestamp_ms_;
 };
 
 /// \brief Return a builder to configure and register a Counter metric.
@@ -75,6 +103,8 @@ class PROMETHEUS_CPP_CORE_EXPORT Counter {
 ///
 /// - Name(const std::string&) to set the metric name,
 /// - Help(const std::string&) to set an additional description.
+/// - Unit(const std::string&) to set the unit of the values, e.g., "seconds",
+///   which the name has to end with.
 /// - Labels(const Labels&) to assign a set of
 ///   key-value pairs (= labels) to the metric.
 ///
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+
+#include "prometheus/client_metric.h"
+#include "prometheus/detail/core_export.h"
+#include "prometheus/labels.h"
+
+// IWYU pragma: private, include "prometheus/counter.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Holds the latest exemplar of a counter or histogram bucket.
+///
+/// Storing an exemplar swaps a shared pointer with std::atomic_store(), no
+/// lock is taken on the observe path. Load() hands out the stored exemplar
+/// with std::atomic_load(), so concurrent readers share it and it is never
+/// deleted while being read.
+class PROMETHEUS_CPP_CORE_EXPORT ExemplarSlot {
+ public:
+  ExemplarSlot() = default;
+
+  ExemplarSlot(const ExemplarSlot&) = delete;
+  ExemplarSlot& operator=(const ExemplarSlot&) = delete;
+
+  /// \brief Replaces the stored exemplar.
+  void Store(std::unique_ptr<ClientMetric::Exemplar> exemplar);
+
+  /// \brief Removes the stored exemplar.
+  void Clear();
+
+  /// \brief Returns the stored exemplar, nullptr if there is none.
+  std::shared_ptr<const ClientMetric::Exemplar> Load() const;
+
+ private:
+  // accessed with std::atomic_load() and std::atomic_store()
+  std::shared_ptr<const ClientMetric::Exemplar> exemplar_;
+};
+
+/// \brief Creates an exemplar with the current time as timestamp.
+///
+/// \param labels Labels of the exemplar, e.g., a trace id.
+/// \param value The observed value.
+/// \throw std::invalid_argument on invalid label names or if the labels are
+/// longer than 128 characters in total.
+PROMETHEUS_CPP_CORE_EXPORT std::unique_ptr<ClientMetric::Exemplar>
+MakeExemplar(const Labels& labels, double value);
+
+}  // namespace detail
+}  // namespace prometheus
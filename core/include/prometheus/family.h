@@ -13,6 +13,7 @@
 #include "prometheus/detail/utils.h"
 #include "prometheus/labels.h"
 #include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
 
 // IWYU pragma: no_include "prometheus/counter.h"
 // IWYU pragma: no_include "prometheus/gauge.h"
@@ -22,6 +23,12 @@
 
 namespace prometheus {
 
+class Registry;
+
+namespace detail {
+class MetricSnapshot;
+}  // namespace detail
+
 /// \brief A metric of type T with a set of labeled dimensions.
 ///
 /// One of Prometheus main feature is a multi-dimensional data model with time
@@ -92,6 +99,17 @@ class PROMETHEUS_CPP_CORE_EXPORT Family : public Collectable {
   Family(const std::string& name, const std::string& help,
          const Labels& constant_labels);
 
+  /// \brief Create a new metric with a unit.
+  ///
+  /// \copydetails Family(const std::string&, const std::string&, const Labels&)
+  ///
+  /// \param unit Unit of the values, e.g., "seconds" or "bytes". The name has
+  /// to end with an underscore followed by the unit, for counters the unit
+  /// comes before the "_total" suffix.
+  /// \throw std::invalid_argument if the name does not end with the unit.
+  Family(const std::string& name, const std::string& help,
+         const Labels& constant_labels, const std::string& unit);
+
   /// \brief Add a new dimensional data.
   ///
   /// Each new set of labels adds a new dimensional data and is exposed in
@@ -142,15 +160,27 @@ class PROMETHEUS_CPP_CORE_EXPORT Family : public Collectable {
   /// \return Zero or more samples for each dimensional data.
   std::vector<MetricFamily> Collect() const override;
 
+  /// \brief Pushes the current value of each dimensional data into the sink.
+  ///
+  /// The samples are copied into the arena of the sink while the family is
+  /// locked and handed to the sink afterwards, so concurrent calls to Add()
+  /// or Remove() do not wait for the sink.
+  void Collect(MetricSink& sink) const override;
+
  private:
+  friend class Registry;
+
   std::unordered_map<Labels, std::unique_ptr<T>, detail::LabelHasher> metrics_;
 
   const std::string name_;
   const std::string help_;
   const Labels constant_labels_;
+  // passed to sinks, built once to not copy name and help on every collection
+  MetricFamily header_;
   mutable std::mutex mutex_;
 
   ClientMetric CollectMetric(const Labels& labels, T* metric) const;
+  void Snapshot(detail::MetricSnapshot& snapshot) const;
   T& Add(const Labels& labels, std::unique_ptr<T> object);
 };
 
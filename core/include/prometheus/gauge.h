@@ -5,6 +5,7 @@
 #include "prometheus/client_metric.h"
 #include "prometheus/detail/builder.h"  // IWYU pragma: export
 #include "prometheus/detail/core_export.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 
 namespace prometheus {
@@ -57,6 +58,12 @@ class PROMETHEUS_CPP_CORE_EXPORT Gauge {
   /// Collect is called by the Registry when collecting metrics.
   ClientMetric Collect() const;
 
+  /// \brief Get the current value of the gauge as compact record.
+  ///
+  /// Collect is called by the Family when streaming metrics into a
+  /// MetricSink.
+  void Collect(MetricRecord& record, MetricRecordArena& arena) const;
+
  private:
   void Change(double);
   std::atomic<double> value_{0.0};
@@ -84,6 +91,8 @@ class PROMETHEUS_CPP_CORE_EXPORT Gauge {
 ///
 /// - Name(const std::string&) to set the metric name,
 /// - Help(const std::string&) to set an additional description.
+/// - Unit(const std::string&) to set the unit of the values, e.g., "seconds",
+///   which the name has to end with.
 /// - Labels(const Labels&) to assign a set of
 ///   key-value pairs (= labels) to the metric.
 ///
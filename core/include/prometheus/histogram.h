@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <mutex>
 #include <vector>
 
@@ -7,7 +8,10 @@
 #include "prometheus/counter.h"
 #include "prometheus/detail/builder.h"  // IWYU pragma: export
 #include "prometheus/detail/core_export.h"
+#include "prometheus/detail/exemplar_slot.h"
 #include "prometheus/gauge.h"
+#include "prometheus/labels.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 
 namespace prometheus {
@@ -57,6 +61,16 @@ class PROMETHEUS_CPP_CORE_EXPORT Histogram {
   /// sum of all observations is incremented.
   void Observe(double value);
 
+  /// \brief Observe the given amount and attach an exemplar to its bucket.
+  ///
+  /// Each bucket keeps the exemplar of its latest observation. Storing it
+  /// takes no lock beyond the one taken by Observe(double).
+  ///
+  /// \param exemplar_labels Labels of the exemplar, e.g., a trace id.
+  /// \throw std::invalid_argument on invalid exemplar labels or if they are
+  /// longer than 128 characters in total.
+  void Observe(double value, const Labels& exemplar_labels);
+
   /// \brief Observe multiple data points.
   ///
   /// Increments counters given a count for each bucket. (i.e. the caller of
@@ -76,11 +90,23 @@ class PROMETHEUS_CPP_CORE_EXPORT Histogram {
   /// Collect is called by the Registry when collecting metrics.
   ClientMetric Collect() const;
 
+  /// \brief Get the current value of the histogram as compact record.
+  ///
+  /// Collect is called by the Family when streaming metrics into a
+  /// MetricSink. Buckets are stored in the given arena.
+  void Collect(MetricRecord& record, MetricRecordArena& arena) const;
+
  private:
   BucketBoundaries bucket_boundaries_;
   mutable std::mutex mutex_;
-  std::vector<Counter> bucket_counts_;
+  // plain counts guarded by mutex_, buckets need no exemplar or timestamp of
+  // their own
+  std::vector<double> bucket_counts_;
+  std::vector<detail::ExemplarSlot> bucket_exemplars_;
   Gauge sum_;
+  std::int64_t created_timestamp_ms_;
+
+  std::size_t BucketIndex(double value) const;
 };
 
 /// \brief Return a builder to configure and register a Histogram metric.
@@ -105,6 +131,8 @@ class PROMETHEUS_CPP_CORE_EXPORT Histogram {
 ///
 /// - Name(const std::string&) to set the metric name,
 /// - Help(const std::string&) to set an additional description.
+/// - Unit(const std::string&) to set the unit of the values, e.g., "seconds",
+///   which the name has to end with.
 /// - Labels(const Labels&) to assign a set of
 ///   key-value pairs (= labels) to the metric.
 ///
@@ -3,6 +3,7 @@
 #include "prometheus/client_metric.h"
 #include "prometheus/detail/builder.h"  // IWYU pragma: export
 #include "prometheus/detail/core_export.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 
 namespace prometheus {
@@ -34,6 +35,12 @@ class PROMETHEUS_CPP_CORE_EXPORT Info {
   ///
   /// Collect is called by the Registry when collecting metrics.
   ClientMetric Collect() const;
+
+  /// \brief Get the current value of the info as compact record.
+  ///
+  /// Collect is called by the Family when streaming metrics into a
+  /// MetricSink.
+  void Collect(MetricRecord& record, MetricRecordArena& arena) const;
 };
 
 /// \brief Return a builder to configure and register a Info metric.
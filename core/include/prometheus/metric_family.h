@@ -12,7 +12,13 @@ namespace prometheus {
 struct PROMETHEUS_CPP_CORE_EXPORT MetricFamily {
   std::string name;
   std::string help;
+  // unit of the values, e.g., "seconds", the name has to end with it
+  std::string unit;
   MetricType type = MetricType::Untyped;
+  // labels shared by all metrics, serializers put them in front of the labels
+  // of each metric, only set by streamed collection, the list based
+  // Collect() copies them into the labels of each metric instead
+  std::vector<ClientMetric::Label> constant_label;
   std::vector<ClientMetric> metric;
 };
 }  // namespace prometheus
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "prometheus/client_metric.h"
+#include "prometheus/detail/core_export.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_type.h"
+
+namespace prometheus {
+
+/// \brief Compact, non-owning representation of a single collected time
+/// series.
+///
+/// In contrast to ClientMetric a MetricRecord only holds the sample of the
+/// metric type it belongs to. Which member of the sample is valid is given by
+/// the MetricFamily::type of the enclosing family:
+///
+/// - MetricType::Counter, Gauge, Info and Untyped use value,
+/// - MetricType::Summary uses summary,
+/// - MetricType::Histogram uses histogram.
+///
+/// Labels, quantiles, buckets and exemplars are not stored in the record but
+/// referenced, usually from a MetricRecordArena owned by the collecting
+/// family. A record is therefore only valid as long as the referenced storage
+/// is not modified.
+struct PROMETHEUS_CPP_CORE_EXPORT MetricRecord {
+  struct LabelRef {
+    const std::string* name;
+    const std::string* value;
+  };
+
+  struct Summary {
+    std::uint64_t sample_count;
+    double sample_sum;
+    const ClientMetric::Quantile* quantile;
+    std::size_t quantile_count;
+  };
+
+  struct Histogram {
+    std::uint64_t sample_count;
+    double sample_sum;
+    const ClientMetric::Bucket* bucket;
+    std::size_t bucket_count;
+  };
+
+  const LabelRef* label = nullptr;
+  std::size_t label_count = 0;
+
+  union {
+    double value = 0.0;
+    Summary summary;
+    Histogram histogram;
+  };
+
+  std::int64_t timestamp_ms = 0;
+
+  /// Exemplar of a counter, nullptr if there is none.
+  const ClientMetric::Exemplar* exemplar = nullptr;
+
+  /// Creation time of counters, summaries and histograms, 0 if unknown.
+  std::int64_t created_timestamp_ms = 0;
+};
+
+/// \brief Storage for the labels, quantiles, buckets and exemplars referenced
+/// by a MetricRecord.
+///
+/// Collecting a family reuses the same arena for every time series, so after
+/// the first series no more memory has to be allocated. Families and
+/// registries also keep the copies of their series in it, which they take
+/// under their locks and hand to the sink after unlocking.
+struct PROMETHEUS_CPP_CORE_EXPORT MetricRecordArena {
+  std::vector<MetricRecord::LabelRef> label;
+  std::vector<ClientMetric::Quantile> quantile;
+  std::vector<ClientMetric::Bucket> bucket;
+  std::vector<std::shared_ptr<const ClientMetric::Exemplar>> exemplar;
+  /// Copied families, their number of series, their series and the names
+  /// and values of the labels of the series.
+  std::vector<MetricFamily> family;
+  std::vector<std::size_t> family_size;
+  std::vector<MetricRecord> record;
+  std::vector<std::string> label_text;
+
+  /// \brief Drops all content but keeps the allocated memory.
+  void Clear();
+};
+
+/// \brief Returns a record referencing the given metric.
+///
+/// Quantiles and buckets are referenced in place, the label references are
+/// stored in the arena.
+PROMETHEUS_CPP_CORE_EXPORT MetricRecord
+MakeMetricRecord(const ClientMetric& metric, MetricType type,
+                 MetricRecordArena& arena);
+
+/// \brief Returns a self-contained copy of the given record.
+PROMETHEUS_CPP_CORE_EXPORT ClientMetric
+MakeClientMetric(const MetricRecord& record, MetricType type);
+
+}  // namespace prometheus
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "prometheus/detail/core_export.h"
+#include "prometheus/labels.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+
+namespace prometheus {
+
+/// \brief Receives collected metrics one time series at a time.
+///
+/// A MetricSink is driven by Collectable::Collect(MetricSink&). For every
+/// metric family BeginFamily() is called once, followed by one AddMetric() call
+/// per time series and a final EndFamily() call.
+///
+/// The family passed to BeginFamily() stays valid until EndFamily() returns,
+/// all other references are only valid for the duration of the call. A sink
+/// that needs to keep data around has to copy it.
+class PROMETHEUS_CPP_CORE_EXPORT MetricSink {
+ public:
+  virtual ~MetricSink() = default;
+
+  /// \brief Starts a new metric family.
+  ///
+  /// Only the header of the family (name, help, type and constant labels) is
+  /// set, its list of metrics is always empty.
+  virtual void BeginFamily(const MetricFamily& family) = 0;
+
+  /// \brief Adds a time series to the current metric family.
+  ///
+  /// The sample of the record is interpreted according to the type of the
+  /// current family.
+  virtual void AddMetric(const MetricRecord& metric) = 0;
+
+  /// \brief Finishes the current metric family.
+  virtual void EndFamily() = 0;
+
+  /// \brief Completes the output once the collection returned normally.
+  ///
+  /// Called by whoever created the sink, wrapping sinks do not forward it.
+  /// Sinks writing a trailer, like the "# EOF" of OpenMetrics, write it here,
+  /// so output cut short by a throwing collectable is never marked complete.
+  virtual void Finish() {}
+
+  /// \brief Returns whether the sink wants the metric family of that name.
+  ///
+  /// Collectables should not even collect the families a sink does not want,
+  /// e.g., when a scrape only asks for some families. Asking is optional, so
+  /// a sink still has to cope with families it does not want.
+  virtual bool WantsFamily(const std::string& /* name */) const {
+    return true;
+  }
+
+  /// \brief Returns scratch storage for building the records passed to
+  /// AddMetric().
+  ///
+  /// Collectables should use it instead of storage of their own, so a
+  /// long-lived arena set with SetArena() can be reused over many
+  /// collections without allocating memory again. The content of the arena is
+  /// undefined whenever a collectable starts using it.
+  MetricRecordArena& GetArena() { return arena_ ? *arena_ : own_arena_; }
+
+  /// \brief Replaces the arena returned by GetArena().
+  ///
+  /// \param arena Arena outliving the sink or nullptr to use the sink's own.
+  void SetArena(MetricRecordArena* arena) { arena_ = arena; }
+
+ private:
+  MetricRecordArena own_arena_;
+  MetricRecordArena* arena_ = nullptr;
+};
+
+/// \brief A MetricSink materializing everything it receives.
+///
+/// Adapts the streaming Collectable::Collect(MetricSink&) to the list based
+/// Collectable::Collect().
+class PROMETHEUS_CPP_CORE_EXPORT MetricFamilyCollector : public MetricSink {
+ public:
+  void BeginFamily(const MetricFamily& family) override;
+  void AddMetric(const MetricRecord& metric) override;
+  void EndFamily() override;
+
+  /// \brief Returns all collected families and leaves the collector empty.
+  std::vector<MetricFamily> TakeFamilies();
+
+ private:
+  std::vector<MetricFamily> families_;
+};
+
+/// \brief Forwards everything to another sink, adding labels to every metric.
+///
+/// Attaches labels to everything collected from a registry or endpoint, e.g.,
+/// external labels identifying the process. Labels are only referenced, so
+/// neither they nor the forwarded metrics are copied. If a family or a metric
+/// already has a label of the same name, the existing label wins.
+class PROMETHEUS_CPP_CORE_EXPORT ExternalLabelsSink : public MetricSink {
+ public:
+  /// \param sink Sink receiving the labeled metrics.
+  /// \param labels Labels to add, must outlive this sink.
+  ExternalLabelsSink(MetricSink& sink, const Labels& labels);
+
+  void BeginFamily(const MetricFamily& family) override;
+  void AddMetric(const MetricRecord& metric) override;
+  void EndFamily() override;
+  bool WantsFamily(const std::string& name) const override;
+
+ private:
+  MetricSink& sink_;
+  const Labels& labels_;
+  // labels not yet set by the current family
+  std::vector<MetricRecord::LabelRef> family_label_;
+  // labels of the current metric
+  std::vector<MetricRecord::LabelRef> label_;
+};
+
+/// \brief Feeds a list of metric families into a sink, leaving out the
+/// families the sink does not want.
+PROMETHEUS_CPP_CORE_EXPORT void WriteToSink(
+    MetricSink& sink, const std::vector<MetricFamily>& families);
+
+}  // namespace prometheus
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "prometheus/detail/core_export.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
+#include "prometheus/serializer.h"
+
+namespace prometheus {
+
+/// \brief Writes the OpenMetrics text format.
+///
+/// In addition to the Prometheus text format, units, exemplars and the
+/// creation time of counters, histograms and summaries (as "_created"
+/// samples) are exposed. The output is terminated by "# EOF", which a sink
+/// returned by MakeSink() only writes in MetricSink::Finish().
+///
+/// See https://github.com/OpenObservability/OpenMetrics for the format.
+class PROMETHEUS_CPP_CORE_EXPORT OpenMetricsSerializer : public Serializer {
+ public:
+  /// \brief Content type of the format, to be used in HTTP headers.
+  static const char* const kContentType;
+
+  std::string Serialize(
+      const std::vector<MetricFamily>& metrics) const override;
+  void Serialize(std::ostream& out,
+                 const std::vector<MetricFamily>& metrics) const override;
+
+  /// \brief Returns a sink writing each time series as soon as it arrives.
+  std::unique_ptr<MetricSink> MakeSink(std::ostream& out) const override;
+};
+
+}  // namespace prometheus
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "prometheus/detail/core_export.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
+#include "prometheus/serializer.h"
+
+namespace prometheus {
+
+/// \brief Writes the protobuf exposition format.
+///
+/// Every family is encoded as an io.prometheus.client.MetricFamily message,
+/// preceded by its length as varint ("encoding=delimited"). The messages are
+/// encoded directly, no protobuf library is needed.
+class PROMETHEUS_CPP_CORE_EXPORT ProtobufSerializer : public Serializer {
+ public:
+  /// \brief Content type of the format, to be used in HTTP headers.
+  static const char* const kContentType;
+
+  std::string Serialize(
+      const std::vector<MetricFamily>& metrics) const override;
+  void Serialize(std::ostream& out,
+                 const std::vector<MetricFamily>& metrics) const override;
+
+  /// \brief Returns a sink writing each metric family as soon as it is
+  /// complete.
+  std::unique_ptr<MetricSink> MakeSink(std::ostream& out) const override;
+};
+
+}  // namespace prometheus
@@ -10,6 +10,7 @@
 #include "prometheus/family.h"
 #include "prometheus/labels.h"
 #include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
 
 namespace prometheus {
 
@@ -81,6 +82,14 @@ class PROMETHEUS_CPP_CORE_EXPORT Registry : public Collectable {
   /// \return Zero or more metrics and their samples.
   std::vector<MetricFamily> Collect() const override;
 
+  /// \brief Pushes all metrics and their samples into the given sink.
+  ///
+  /// The samples are copied into the arena of the sink while the registry
+  /// is locked and handed to the sink afterwards, so adding or removing
+  /// metrics does not wait for the sink. The arena keeps its memory, so
+  /// repeated collections do not allocate again.
+  void Collect(MetricSink& sink) const override;
+
   /// \brief Removes a metrics family from the registry.
   ///
   /// Please note that this operation invalidates the previously
@@ -104,9 +113,14 @@ class PROMETHEUS_CPP_CORE_EXPORT Registry : public Collectable {
   template <typename T>
   bool NameExistsInOtherType(const std::string& name) const;
 
+  template <typename T>
+  static void SnapshotAll(
+      detail::MetricSnapshot& snapshot, const MetricSink& sink,
+      const std::vector<std::unique_ptr<Family<T>>>& families);
+
   template <typename T>
   Family<T>& Add(const std::string& name, const std::string& help,
-                 const Labels& labels);
+                 const Labels& labels, const std::string& unit);
 
   const InsertBehavior insert_behavior_;
   std::vector<std::unique_ptr<Family<Counter>>> counters_;
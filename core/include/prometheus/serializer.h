@@ -1,11 +1,13 @@
 #pragma once
 
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "prometheus/detail/core_export.h"
 #include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
 
 namespace prometheus {
 
@@ -15,6 +17,12 @@ class PROMETHEUS_CPP_CORE_EXPORT Serializer {
   virtual std::string Serialize(const std::vector<MetricFamily>&) const;
   virtual void Serialize(std::ostream& out,
                          const std::vector<MetricFamily>& metrics) const = 0;
+
+  /// \brief Returns a sink writing everything it receives to the stream.
+  ///
+  /// The sink must not outlive the given stream. The default implementation
+  /// buffers one metric family at a time and passes it to Serialize().
+  virtual std::unique_ptr<MetricSink> MakeSink(std::ostream& out) const;
 };
 
 }  // namespace prometheus
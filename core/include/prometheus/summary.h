@@ -10,6 +10,7 @@
 #include "prometheus/detail/ckms_quantiles.h"
 #include "prometheus/detail/core_export.h"
 #include "prometheus/detail/time_window_quantiles.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 
 namespace prometheus {
@@ -88,12 +89,19 @@ class PROMETHEUS_CPP_CORE_EXPORT Summary {
   /// Collect is called by the Registry when collecting metrics.
   ClientMetric Collect() const;
 
+  /// \brief Get the current value of the summary as compact record.
+  ///
+  /// Collect is called by the Family when streaming metrics into a
+  /// MetricSink. Quantiles are stored in the given arena.
+  void Collect(MetricRecord& record, MetricRecordArena& arena) const;
+
  private:
   Quantiles quantiles_;
   mutable std::mutex mutex_;
   std::uint64_t count_{};
   double sum_{};
   detail::TimeWindowQuantiles quantile_values_;
+  const std::int64_t created_timestamp_ms_;
 };
 
 /// \brief Return a builder to configure and register a Summary metric.
@@ -118,6 +126,8 @@ class PROMETHEUS_CPP_CORE_EXPORT Summary {
 ///
 /// - Name(const std::string&) to set the metric name,
 /// - Help(const std::string&) to set an additional description.
+/// - Unit(const std::string&) to set the unit of the values, e.g., "seconds",
+///   which the name has to end with.
 /// - Labels(const Labels&) to assign a set of
 ///   key-value pairs (= labels) to the metric.
 ///
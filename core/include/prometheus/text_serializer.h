@@ -1,19 +1,30 @@
 #pragma once
 
 #include <iosfwd>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "prometheus/detail/core_export.h"
 #include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
 #include "prometheus/serializer.h"
 
 namespace prometheus {
 
 class PROMETHEUS_CPP_CORE_EXPORT TextSerializer : public Serializer {
  public:
-  using Serializer::Serialize;
+  /// \brief Content type of the format, to be used in HTTP headers.
+  static const char* const kContentType;
+
+  /// \brief Writes the text exposition format directly into a string.
+  std::string Serialize(
+      const std::vector<MetricFamily>& metrics) const override;
   void Serialize(std::ostream& out,
                  const std::vector<MetricFamily>& metrics) const override;
+
+  /// \brief Returns a sink writing each time series as soon as it arrives.
+  std::unique_ptr<MetricSink> MakeSink(std::ostream& out) const override;
 };
 
 }  // namespace prometheus
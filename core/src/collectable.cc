@@ -0,0 +1,12 @@
+#include "prometheus/collectable.h"
+
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+
+void Collectable::Collect(MetricSink& sink) const {
+  WriteToSink(sink, Collect());
+}
+
+}  // namespace prometheus
@@ -0,0 +1,147 @@
+#include "prometheus/collection_executor.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace prometheus {
+
+namespace {
+
+// Applies the options to the calling thread
+void ConfigureThread(const CollectionExecutor::Options& options) {
+#ifdef __linux__
+  if (!options.cpus.empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (auto cpu : options.cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        throw std::runtime_error("invalid CPU " + std::to_string(cpu));
+      }
+      CPU_SET(cpu, &cpus);
+    }
+    const auto error = ::pthread_setaffinity_np(::pthread_self(),
+                                                sizeof(cpus), &cpus);
+    if (error != 0) {
+      throw std::runtime_error(std::string{"cannot set CPU affinity: "} +
+                               std::strerror(error));
+    }
+  }
+  if (options.idle_priority) {
+    sched_param parameter{};
+    const auto error =
+        ::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &parameter);
+    if (error != 0) {
+      throw std::runtime_error(std::string{"cannot set SCHED_IDLE: "} +
+                               std::strerror(error));
+    }
+  }
+  if (options.nice != 0) {
+    // on Linux the nice value is a property of the thread, not the process
+    const auto thread_id = static_cast<id_t>(::syscall(SYS_gettid));
+    if (::setpriority(PRIO_PROCESS, thread_id, options.nice) != 0) {
+      throw std::runtime_error(std::string{"cannot set nice value: "} +
+                               std::strerror(errno));
+    }
+  }
+#else
+  if (!options.cpus.empty() || options.nice != 0 || options.idle_priority) {
+    throw std::runtime_error(
+        "thread affinity and priority are only supported on Linux");
+  }
+#endif
+}
+
+}  // namespace
+
+CollectionExecutor::CollectionExecutor() : CollectionExecutor(Options{}) {}
+
+CollectionExecutor::CollectionExecutor(const Options& options) {
+  const auto num_threads = options.num_threads > 0 ? options.num_threads : 1;
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    // threads report whether they could be configured before serving
+    std::promise<void> configured;
+    auto result = configured.get_future();
+    threads_.emplace_back([this, &options, &configured] {
+      try {
+        ConfigureThread(options);
+      } catch (...) {
+        configured.set_exception(std::current_exception());
+        return;
+      }
+      configured.set_value();
+      Run();
+    });
+    try {
+      result.get();
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+      }
+      pending_.notify_all();
+      for (auto& thread : threads_) {
+        thread.join();
+      }
+      throw;
+    }
+  }
+}
+
+CollectionExecutor::~CollectionExecutor() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  pending_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void CollectionExecutor::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    tasks_.push_back(std::move(task));
+  }
+  pending_.notify_one();
+}
+
+Executor CollectionExecutor::AsExecutor() {
+  return [this](std::function<void()> task) { Post(std::move(task)); };
+}
+
+void CollectionExecutor::Run() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      pending_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    try {
+      task();
+    } catch (...) {
+      // tasks pass their results and errors on themselves, an exception
+      // escaping one must not end the thread and with it the process
+    }
+  }
+}
+
+}  // namespace prometheus
@@ -1,7 +1,13 @@
 #include "prometheus/counter.h"
 
+#include <utility>
+
+#include "detail/clock.h"
+
 namespace prometheus {
 
+Counter::Counter() : created_timestamp_ms_{detail::CurrentTimeMs()} {}
+
 void Counter::Increment() { gauge_.Increment(); }
 
 void Counter::Increment(const double val) {
@@ -11,14 +17,41 @@ void Counter::Increment(const double val) {
   gauge_.Increment(val);
 }
 
+void Counter::Increment(const double val, const Labels& exemplar_labels) {
+  if (val < 0.0) {
+    return;
+  }
+  auto exemplar = detail::MakeExemplar(exemplar_labels, val);
+  gauge_.Increment(val);
+  exemplar_.Store(std::move(exemplar));
+}
+
 double Counter::Value() const { return gauge_.Value(); }
 
-void Counter::Reset() { gauge_.Set(0); }
+void Counter::Reset() {
+  gauge_.Set(0);
+  exemplar_.Clear();
+  created_timestamp_ms_ = detail::CurrentTimeMs();
+}
 
 ClientMetric Counter::Collect() const {
   ClientMetric metric;
   metric.counter.value = Value();
+  metric.counter.exemplar = exemplar_.Load();
+  metric.created_timestamp_ms = created_timestamp_ms_;
   return metric;
 }
 
+void Counter::Collect(MetricRecord& record, MetricRecordArena& arena) const {
+  record.value = Value();
+  record.created_timestamp_ms = created_timestamp_ms_;
+  record.exemplar = nullptr;
+
+  auto exemplar = exemplar_.Load();
+  if (exemplar) {
+    record.exemplar = exemplar.get();
+    arena.exemplar.push_back(std::move(exemplar));
+  }
+}
+
 }  // namespace prometheus
@@ -30,9 +30,15 @@ Builder<T>& Builder<T>::Help(const std::string& help) {
   return *this;
 }
 
+template <typename T>
+Builder<T>& Builder<T>::Unit(const std::string& unit) {
+  unit_ = unit;
+  return *this;
+}
+
 template <typename T>
 Family<T>& Builder<T>::Register(Registry& registry) {
-  return registry.Add<T>(name_, help_, labels_);
+  return registry.Add<T>(name_, help_, labels_, unit_);
 }
 
 template class PROMETHEUS_CPP_CORE_EXPORT Builder<Counter>;
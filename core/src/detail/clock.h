@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace prometheus {
+
+namespace detail {
+
+/// \brief Returns the wall clock time in milliseconds since the Unix epoch.
+inline std::int64_t CurrentTimeMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace detail
+
+}  // namespace prometheus
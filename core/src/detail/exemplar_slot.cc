@@ -0,0 +1,64 @@
+#include "prometheus/detail/exemplar_slot.h"
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "clock.h"
+#include "prometheus/check_names.h"
+#include "prometheus/detail/future_std.h"
+#include "prometheus/metric_type.h"
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+
+// Combined length of label names and values allowed by OpenMetrics
+const std::size_t kMaxExemplarLabelLength = 128;
+
+}  // namespace
+
+void ExemplarSlot::Store(std::unique_ptr<ClientMetric::Exemplar> exemplar) {
+  std::atomic_store(&exemplar_, std::shared_ptr<const ClientMetric::Exemplar>{
+                                    std::move(exemplar)});
+}
+
+void ExemplarSlot::Clear() {
+  std::atomic_store(&exemplar_,
+                    std::shared_ptr<const ClientMetric::Exemplar>{});
+}
+
+std::shared_ptr<const ClientMetric::Exemplar> ExemplarSlot::Load() const {
+  return std::atomic_load(&exemplar_);
+}
+
+std::unique_ptr<ClientMetric::Exemplar> MakeExemplar(const Labels& labels,
+                                                     const double value) {
+  auto exemplar = detail::make_unique<ClientMetric::Exemplar>();
+  exemplar->label.reserve(labels.size());
+
+  std::size_t length = 0;
+  for (auto& label_pair : labels) {
+    if (!CheckLabelName(label_pair.first, MetricType::Counter)) {
+      throw std::invalid_argument("Invalid exemplar label name");
+    }
+    length += label_pair.first.size() + label_pair.second.size();
+
+    auto label = ClientMetric::Label{};
+    label.name = label_pair.first;
+    label.value = label_pair.second;
+    exemplar->label.push_back(std::move(label));
+  }
+  if (length > kMaxExemplarLabelLength) {
+    throw std::invalid_argument("Exemplar labels are too long");
+  }
+
+  exemplar->value = value;
+  exemplar->timestamp_ms = CurrentTimeMs();
+  return exemplar;
+}
+
+}  // namespace detail
+}  // namespace prometheus
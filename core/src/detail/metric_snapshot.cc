@@ -0,0 +1,63 @@
+#include "metric_snapshot.h"
+
+#include <cstddef>
+
+namespace prometheus {
+
+namespace detail {
+
+MetricSnapshot::MetricSnapshot(MetricRecordArena& arena) : arena_(arena) {
+  arena_.Clear();
+}
+
+void MetricSnapshot::BeginFamily(const MetricFamily& header) {
+  arena_.family.push_back(header);
+  arena_.family_size.push_back(0);
+}
+
+void MetricSnapshot::AddMetric(const Labels& labels,
+                               const MetricRecord& record) {
+  for (const auto& label_pair : labels) {
+    arena_.label_text.push_back(label_pair.first);
+    arena_.label_text.push_back(label_pair.second);
+  }
+  arena_.record.push_back(record);
+  arena_.record.back().label_count = labels.size();
+  ++arena_.family_size.back();
+}
+
+void MetricSnapshot::WriteTo(MetricSink& sink) {
+  // the storage does not grow anymore, so the records can reference it
+  arena_.label.clear();
+  for (std::size_t i = 0; i < arena_.label_text.size(); i += 2) {
+    arena_.label.push_back(MetricRecord::LabelRef{&arena_.label_text[i],
+                                                  &arena_.label_text[i + 1]});
+  }
+
+  std::size_t record = 0;
+  std::size_t label = 0;
+  std::size_t quantile = 0;
+  std::size_t bucket = 0;
+  for (std::size_t i = 0; i < arena_.family.size(); ++i) {
+    const auto& family = arena_.family[i];
+    sink.BeginFamily(family);
+    for (std::size_t j = 0; j < arena_.family_size[i]; ++j, ++record) {
+      auto& metric = arena_.record[record];
+      metric.label = arena_.label.data() + label;
+      label += metric.label_count;
+      if (family.type == MetricType::Summary) {
+        metric.summary.quantile = arena_.quantile.data() + quantile;
+        quantile += metric.summary.quantile_count;
+      } else if (family.type == MetricType::Histogram) {
+        metric.histogram.bucket = arena_.bucket.data() + bucket;
+        bucket += metric.histogram.bucket_count;
+      }
+      sink.AddMetric(metric);
+    }
+    sink.EndFamily();
+  }
+}
+
+}  // namespace detail
+
+}  // namespace prometheus
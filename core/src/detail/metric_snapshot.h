@@ -0,0 +1,45 @@
+#pragma once
+
+#include "prometheus/labels.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+
+namespace detail {
+
+/// \brief Copy of the time series of families, taken while they are locked.
+///
+/// Families and registries fill it under their locks and hand it to the
+/// sink after unlocking, so a sink writing to a slow client does not block
+/// adding or removing metrics. Everything is kept in the arena of the sink,
+/// so its memory is reused by the next collection.
+class MetricSnapshot {
+ public:
+  /// \param arena Arena of the sink, its content is replaced.
+  explicit MetricSnapshot(MetricRecordArena& arena);
+
+  /// \brief Returns the arena the quantiles and buckets of the records are
+  /// collected into.
+  MetricRecordArena& Arena() { return arena_; }
+
+  /// \brief Starts a family, the header is copied.
+  void BeginFamily(const MetricFamily& header);
+
+  /// \brief Adds a time series to the current family.
+  ///
+  /// The labels are copied. The quantiles or buckets of the record have to
+  /// be the last ones collected into the arena.
+  void AddMetric(const Labels& labels, const MetricRecord& record);
+
+  /// \brief Hands the families to the sink.
+  void WriteTo(MetricSink& sink);
+
+ private:
+  MetricRecordArena& arena_;
+};
+
+}  // namespace detail
+
+}  // namespace prometheus
@@ -0,0 +1,478 @@
+#include "text_output.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace prometheus {
+
+namespace detail {
+
+namespace {
+
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Integral doubles below this limit are printed as integers by "%.15g", too
+const double kMaxIntegralDouble = 1e15;
+
+// Writes the digits right-aligned into buffer and returns the first digit
+char* FormatDigits(std::uint64_t value, char* end) {
+  auto pos = end;
+  while (value >= 100) {
+    const auto pair = static_cast<std::size_t>(value % 100) * 2;
+    value /= 100;
+    *--pos = kDigitPairs[pair + 1];
+    *--pos = kDigitPairs[pair];
+  }
+  if (value >= 10) {
+    const auto pair = static_cast<std::size_t>(value) * 2;
+    *--pos = kDigitPairs[pair + 1];
+    *--pos = kDigitPairs[pair];
+  } else {
+    *--pos = static_cast<char>('0' + value);
+  }
+  return pos;
+}
+
+// Significant digits of a decimal number and the exponent of the first one
+const int kMaxDigits = 17;
+
+struct Decimal {
+  char digits[kMaxDigits];
+  int count;
+  int exponent;
+};
+
+#if __cpp_lib_to_chars >= 201611L
+void ToShortestDecimal(double value, Decimal& decimal) {
+  char buffer[32];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                              std::chars_format::scientific);
+
+  // the output looks like "d.ddde+dd"
+  const char* pos = buffer;
+  decimal.count = 0;
+  for (; *pos != 'e'; ++pos) {
+    if (*pos != '.') {
+      decimal.digits[decimal.count++] = *pos;
+    }
+  }
+  ++pos;
+  const auto negative = *pos++ == '-';
+  decimal.exponent = 0;
+  for (; pos != result.ptr; ++pos) {
+    decimal.exponent = decimal.exponent * 10 + (*pos - '0');
+  }
+  if (negative) {
+    decimal.exponent = -decimal.exponent;
+  }
+}
+#else
+// Pre-C++17 fallback: Grisu2 as described in "Printing Floating-Point Numbers
+// Quickly and Accurately with Integers" by Florian Loitsch. The digits always
+// parse back to the same value and are the shortest ones in almost all cases.
+
+// Floating-point number f * 2^e without hidden bit or sign
+struct DiyFp {
+  std::uint64_t f;
+  int e;
+};
+
+DiyFp Subtract(const DiyFp& x, const DiyFp& y) { return DiyFp{x.f - y.f, x.e}; }
+
+// Returns the upper 64 bits of the 128 bit product, rounded
+DiyFp Multiply(const DiyFp& x, const DiyFp& y) {
+  const std::uint64_t mask = 0xFFFFFFFFu;
+  const auto x_lo = x.f & mask;
+  const auto x_hi = x.f >> 32;
+  const auto y_lo = y.f & mask;
+  const auto y_hi = y.f >> 32;
+
+  const auto p0 = x_lo * y_lo;
+  const auto p1 = x_lo * y_hi;
+  const auto p2 = x_hi * y_lo;
+  const auto p3 = x_hi * y_hi;
+
+  auto q = (p0 >> 32) + (p1 & mask) + (p2 & mask);
+  q += std::uint64_t{1} << 31;
+
+  return DiyFp{p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32), x.e + y.e + 64};
+}
+
+DiyFp Normalize(DiyFp x) {
+  while ((x.f >> 63) == 0) {
+    x.f <<= 1;
+    --x.e;
+  }
+  return x;
+}
+
+// The value and the boundaries of the interval of real numbers rounding to it
+struct Boundaries {
+  DiyFp w;
+  DiyFp minus;
+  DiyFp plus;
+};
+
+Boundaries ComputeBoundaries(double value) {
+  const int kBias = 1023 + 52;
+  const std::uint64_t kHiddenBit = std::uint64_t{1} << 52;
+
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const auto biased_exponent = static_cast<int>(bits >> 52);
+  const auto fraction = bits & (kHiddenBit - 1);
+
+  const auto v = biased_exponent == 0
+                     ? DiyFp{fraction, 1 - kBias}
+                     : DiyFp{fraction + kHiddenBit, biased_exponent - kBias};
+
+  // the lower boundary is closer if the fraction is zero, except for the
+  // smallest normalized number
+  const auto lower_boundary_is_closer = fraction == 0 && biased_exponent > 1;
+  const auto plus = Normalize(DiyFp{2 * v.f + 1, v.e - 1});
+  auto minus = lower_boundary_is_closer ? DiyFp{4 * v.f - 1, v.e - 2}
+                                        : DiyFp{2 * v.f - 1, v.e - 1};
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+
+  return Boundaries{Normalize(v), minus, plus};
+}
+
+// Products with the cached power of ten have a binary exponent in this range
+const int kAlpha = -60;
+const int kGamma = -32;
+
+// 10^k = f * 2^e
+struct CachedPower {
+  std::uint64_t f;
+  int e;
+  int k;
+};
+
+// Normalized approximations of 10^k for k = -300, -292, ..., 324
+const CachedPower kCachedPowers[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324}
+};
+
+const int kCachedPowersMinDecExp = -300;
+const int kCachedPowersDecStep = 8;
+
+// Returns a cached power c such that kAlpha <= c.e + e + 64 <= kGamma
+const CachedPower& GetCachedPower(int e) {
+  // k = ceil((kAlpha - e - 1) * log10(2)), 78913 / 2^18 approximates log10(2)
+  const int f = kAlpha - e - 1;
+  const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+  const int index =
+      (-kCachedPowersMinDecExp + k + (kCachedPowersDecStep - 1)) /
+      kCachedPowersDecStep;
+  return kCachedPowers[index];
+}
+
+// Returns the number of decimal digits of n and sets pow10 to the largest
+// power of ten less than or equal to n
+int FindLargestPow10(std::uint32_t n, std::uint32_t& pow10) {
+  int digits = 10;
+  pow10 = 1000000000;
+  while (digits > 1 && n < pow10) {
+    pow10 /= 10;
+    --digits;
+  }
+  return digits;
+}
+
+// Moves the last digit towards the exact value while staying in the interval
+void Round(Decimal& decimal, std::uint64_t dist, std::uint64_t delta,
+           std::uint64_t rest, std::uint64_t ten_k) {
+  while (rest < dist && delta - rest >= ten_k &&
+         (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    --decimal.digits[decimal.count - 1];
+    rest += ten_k;
+  }
+}
+
+// Generates the shortest digits of a number in [minus, plus] close to w and
+// returns the decimal exponent of the last digit relative to the input
+int GenerateDigits(Decimal& decimal, const DiyFp& minus, const DiyFp& w,
+                   const DiyFp& plus) {
+  auto delta = Subtract(plus, minus).f;
+  auto dist = Subtract(plus, w).f;
+
+  const auto shift = -plus.e;
+  const auto one = std::uint64_t{1} << shift;
+
+  auto p1 = static_cast<std::uint32_t>(plus.f >> shift);
+  auto p2 = plus.f & (one - 1);
+
+  std::uint32_t pow10;
+  auto n = FindLargestPow10(p1, pow10);
+
+  decimal.count = 0;
+  while (n > 0) {
+    decimal.digits[decimal.count++] = static_cast<char>('0' + p1 / pow10);
+    p1 %= pow10;
+    --n;
+
+    const auto rest = (std::uint64_t{p1} << shift) + p2;
+    if (rest <= delta) {
+      Round(decimal, dist, delta, rest, std::uint64_t{pow10} << shift);
+      return n;
+    }
+    pow10 /= 10;
+  }
+
+  // a double never needs more than 17 digits
+  auto m = 0;
+  do {
+    p2 *= 10;
+    decimal.digits[decimal.count++] = static_cast<char>('0' + (p2 >> shift));
+    p2 &= one - 1;
+    ++m;
+    delta *= 10;
+    dist *= 10;
+  } while (p2 > delta && decimal.count < kMaxDigits);
+  Round(decimal, dist, delta, p2, one);
+  return -m;
+}
+
+void ToShortestDecimal(double value, Decimal& decimal) {
+  const auto boundaries = ComputeBoundaries(value);
+  const auto& cached = GetCachedPower(boundaries.plus.e);
+  const auto c = DiyFp{cached.f, cached.e};
+
+  const auto w = Multiply(boundaries.w, c);
+  auto minus = Multiply(boundaries.minus, c);
+  auto plus = Multiply(boundaries.plus, c);
+
+  // account for the error of the multiplications
+  ++minus.f;
+  --plus.f;
+
+  const auto last_exponent = GenerateDigits(decimal, minus, w, plus) - cached.k;
+  decimal.exponent = last_exponent + decimal.count - 1;
+}
+
+// Grisu2 misses the shortest digits if they lie close to the boundary of the
+// interval, which shows as a run of nines or zeros, e.g., 0.6825599999999999
+// instead of 0.68256. In that case the digits rounded to 15 places are tried,
+// which are never ambiguous for a double.
+void Shorten(double value, Decimal& decimal) {
+  const auto run = decimal.digits[13];
+  if (decimal.count < 16 || decimal.digits[14] != run ||
+      (run != '0' && run != '9')) {
+    return;
+  }
+
+  auto rounded = decimal;
+  rounded.count = 15;
+  if (decimal.digits[15] >= '5') {
+    auto i = rounded.count - 1;
+    for (; i >= 0 && rounded.digits[i] == '9'; --i) {
+      rounded.digits[i] = '0';
+    }
+    if (i >= 0) {
+      ++rounded.digits[i];
+    } else {
+      rounded.digits[0] = '1';
+      ++rounded.exponent;
+    }
+  }
+  while (rounded.count > 1 && rounded.digits[rounded.count - 1] == '0') {
+    --rounded.count;
+  }
+
+  // without a decimal point strtod does not depend on the locale
+  auto number = std::string(rounded.digits, rounded.count);
+  number.push_back('e');
+  AppendInteger(number,
+                std::int64_t{rounded.exponent - (rounded.count - 1)});
+  if (std::strtod(number.c_str(), nullptr) == value) {
+    decimal = rounded;
+  }
+}
+#endif
+
+// Writes the decimal like printf's "%g" would with a precision of the number
+// of digits, but at least 15
+void AppendDecimal(std::string& out, const Decimal& decimal) {
+  const auto count = decimal.count;
+  const auto exponent = decimal.exponent;
+  const auto digits = decimal.digits;
+
+  if (exponent < -4 || exponent >= std::max(count, 15)) {
+    out.push_back(digits[0]);
+    if (count > 1) {
+      out.push_back('.');
+      out.append(digits + 1, count - 1);
+    }
+    out.push_back('e');
+    out.push_back(exponent < 0 ? '-' : '+');
+    const auto magnitude = static_cast<std::uint64_t>(std::abs(exponent));
+    if (magnitude < 10) {
+      out.push_back('0');
+    }
+    AppendInteger(out, magnitude);
+  } else if (exponent < 0) {
+    out.append("0.");
+    out.append(-exponent - 1, '0');
+    out.append(digits, count);
+  } else if (exponent + 1 >= count) {
+    out.append(digits, count);
+    out.append(exponent + 1 - count, '0');
+  } else {
+    out.append(digits, exponent + 1);
+    out.push_back('.');
+    out.append(digits + exponent + 1, count - exponent - 1);
+  }
+}
+
+}  // namespace
+
+void AppendInteger(std::string& out, std::uint64_t value) {
+  char buffer[20];
+  auto end = buffer + sizeof(buffer);
+  out.append(FormatDigits(value, end), end);
+}
+
+void AppendInteger(std::string& out, std::int64_t value) {
+  if (value < 0) {
+    out.push_back('-');
+    // negate in unsigned arithmetic to cope with the minimum value
+    AppendInteger(out, std::uint64_t{0} - static_cast<std::uint64_t>(value));
+  } else {
+    AppendInteger(out, static_cast<std::uint64_t>(value));
+  }
+}
+
+void AppendDouble(std::string& out, double value) {
+  if (std::signbit(value)) {
+    out.push_back('-');
+    value = -value;
+  }
+  if (value < kMaxIntegralDouble && std::trunc(value) == value) {
+    AppendInteger(out, static_cast<std::uint64_t>(value));
+    return;
+  }
+
+  auto decimal = Decimal{};
+  ToShortestDecimal(value, decimal);
+#if !(__cpp_lib_to_chars >= 201611L)
+  Shorten(value, decimal);
+#endif
+  AppendDecimal(out, decimal);
+}
+
+void AppendEscaped(std::string& out, const std::string& value) {
+  // copy runs of characters not needing escaping at once
+  auto first = value.data();
+  const auto last = first + value.size();
+  for (auto pos = first; pos != last; ++pos) {
+    if (*pos == '\n' || *pos == '\\' || *pos == '"') {
+      out.append(first, pos);
+      out.push_back('\\');
+      out.push_back(*pos == '\n' ? 'n' : *pos);
+      first = pos + 1;
+    }
+  }
+  out.append(first, last);
+}
+
+}  // namespace detail
+
+}  // namespace prometheus
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace prometheus {
+
+namespace detail {
+
+/// \brief Append the decimal representation of an integer.
+///
+/// \param out The buffer to append to.
+/// \param value The integer to append.
+void AppendInteger(std::string& out, std::uint64_t value);
+
+/// \brief Append the decimal representation of an integer.
+///
+/// \param out The buffer to append to.
+/// \param value The integer to append.
+void AppendInteger(std::string& out, std::int64_t value);
+
+/// \brief Append the shortest representation of a finite double that parses
+/// back to the same value.
+///
+/// The output does not depend on the current locale and looks like printf's
+/// "%g" with just enough precision, so integral values are written without a
+/// decimal point or exponent.
+///
+/// \param out The buffer to append to.
+/// \param value The finite value to append.
+void AppendDouble(std::string& out, double value);
+
+/// \brief Append a label value or help text, escaping backslashes, double
+/// quotes and line feeds.
+///
+/// \param out The buffer to append to.
+/// \param value The text to append.
+void AppendEscaped(std::string& out, const std::string& value);
+
+}  // namespace detail
+
+}  // namespace prometheus
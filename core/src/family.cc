@@ -4,29 +4,66 @@
 #include <cassert>
 #include <map>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
+#include "detail/metric_snapshot.h"
 #include "prometheus/check_names.h"
 #include "prometheus/counter.h"
 #include "prometheus/gauge.h"
 #include "prometheus/histogram.h"
 #include "prometheus/info.h"
+#include "prometheus/metric_type.h"
 #include "prometheus/summary.h"
 
 namespace prometheus {
 
+namespace {
+
+bool EndsWith(const std::string& value, const std::string& suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+}  // namespace
+
 template <typename T>
 Family<T>::Family(const std::string& name, const std::string& help,
                   const Labels& constant_labels)
+    : Family(name, help, constant_labels, {}) {}
+
+template <typename T>
+Family<T>::Family(const std::string& name, const std::string& help,
+                  const Labels& constant_labels, const std::string& unit)
     : name_(name), help_(help), constant_labels_(constant_labels) {
   if (!CheckMetricName(name_)) {
     throw std::invalid_argument("Invalid metric name");
   }
+  if (!unit.empty()) {
+    auto base_name = name_;
+    if (T::metric_type == MetricType::Counter &&
+        EndsWith(base_name, "_total")) {
+      base_name.resize(base_name.size() - 6);
+    }
+    if (!EndsWith(base_name, "_" + unit)) {
+      throw std::invalid_argument("Metric name must end with its unit");
+    }
+  }
+  header_.name = name_;
+  header_.help = help_;
+  header_.unit = unit;
+  header_.type = T::metric_type;
+  header_.constant_label.reserve(constant_labels_.size());
   for (auto& label_pair : constant_labels_) {
     auto& label_name = label_pair.first;
     if (!CheckLabelName(label_name, T::metric_type)) {
       throw std::invalid_argument("Invalid label name");
     }
+    auto label = ClientMetric::Label{};
+    label.name = label_name;
+    label.value = label_pair.second;
+    header_.constant_label.push_back(std::move(label));
   }
 }
 
@@ -93,10 +130,13 @@ std::vector<MetricFamily> Family<T>::Collect() const {
     return {};
   }
 
+  // constant labels are copied into every metric, as list based consumers
+  // read all labels of a metric from ClientMetric::label
   auto family = MetricFamily{};
-  family.name = name_;
-  family.help = help_;
-  family.type = T::metric_type;
+  family.name = header_.name;
+  family.help = header_.help;
+  family.unit = header_.unit;
+  family.type = header_.type;
   family.metric.reserve(metrics_.size());
   for (const auto& m : metrics_) {
     family.metric.push_back(std::move(CollectMetric(m.first, m.second.get())));
@@ -104,6 +144,33 @@ std::vector<MetricFamily> Family<T>::Collect() const {
   return {family};
 }
 
+template <typename T>
+void Family<T>::Collect(MetricSink& sink) const {
+  if (!sink.WantsFamily(name_)) {
+    return;
+  }
+
+  detail::MetricSnapshot snapshot{sink.GetArena()};
+  Snapshot(snapshot);
+  snapshot.WriteTo(sink);
+}
+
+template <typename T>
+void Family<T>::Snapshot(detail::MetricSnapshot& snapshot) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  if (metrics_.empty()) {
+    return;
+  }
+
+  snapshot.BeginFamily(header_);
+  auto record = MetricRecord{};
+  for (const auto& m : metrics_) {
+    m.second->Collect(record, snapshot.Arena());
+    snapshot.AddMetric(m.first, record);
+  }
+}
+
 template <typename T>
 ClientMetric Family<T>::CollectMetric(const Labels& metric_labels,
                                       T* metric) const {
@@ -42,4 +42,8 @@ ClientMetric Gauge::Collect() const {
   return metric;
 }
 
+void Gauge::Collect(MetricRecord& record, MetricRecordArena&) const {
+  record.value = Value();
+}
+
 }  // namespace prometheus
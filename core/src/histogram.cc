@@ -9,6 +9,8 @@
 #include <stdexcept>
 #include <utility>
 
+#include "detail/clock.h"
+
 namespace prometheus {
 
 namespace {
@@ -23,7 +25,10 @@ bool is_strict_sorted(ForwardIterator first, ForwardIterator last) {
 }  // namespace
 
 Histogram::Histogram(const BucketBoundaries& buckets)
-    : bucket_boundaries_{buckets}, bucket_counts_{buckets.size() + 1} {
+    : bucket_boundaries_{buckets},
+      bucket_counts_(buckets.size() + 1),
+      bucket_exemplars_(buckets.size() + 1),
+      created_timestamp_ms_{detail::CurrentTimeMs()} {
   if (!is_strict_sorted(begin(bucket_boundaries_), end(bucket_boundaries_))) {
     throw std::invalid_argument("Bucket Boundaries must be strictly sorted");
   }
@@ -31,21 +36,38 @@ Histogram::Histogram(const BucketBoundaries& buckets)
 
 Histogram::Histogram(BucketBoundaries&& buckets)
     : bucket_boundaries_{std::move(buckets)},
-      bucket_counts_{bucket_boundaries_.size() + 1} {
+      bucket_counts_(bucket_boundaries_.size() + 1),
+      bucket_exemplars_(bucket_boundaries_.size() + 1),
+      created_timestamp_ms_{detail::CurrentTimeMs()} {
   if (!is_strict_sorted(begin(bucket_boundaries_), end(bucket_boundaries_))) {
     throw std::invalid_argument("Bucket Boundaries must be strictly sorted");
   }
 }
 
-void Histogram::Observe(const double value) {
-  const auto bucket_index = static_cast<std::size_t>(
+std::size_t Histogram::BucketIndex(const double value) const {
+  return static_cast<std::size_t>(
       std::distance(bucket_boundaries_.begin(),
                     std::lower_bound(bucket_boundaries_.begin(),
                                      bucket_boundaries_.end(), value)));
+}
+
+void Histogram::Observe(const double value) {
+  const auto bucket_index = BucketIndex(value);
 
   std::lock_guard<std::mutex> lock(mutex_);
   sum_.Increment(value);
-  bucket_counts_[bucket_index].Increment();
+  bucket_counts_[bucket_index] += 1;
+}
+
+void Histogram::Observe(const double value, const Labels& exemplar_labels) {
+  auto exemplar = detail::MakeExemplar(exemplar_labels, value);
+  const auto bucket_index = BucketIndex(value);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sum_.Increment(value);
+    bucket_counts_[bucket_index] += 1;
+  }
+  bucket_exemplars_[bucket_index].Store(std::move(exemplar));
 }
 
 void Histogram::ObserveMultiple(const std::vector<double>& bucket_increments,
@@ -60,16 +82,20 @@ void Histogram::ObserveMultiple(const std::vector<double>& bucket_increments,
   sum_.Increment(sum_of_values);
 
   for (std::size_t i{0}; i < bucket_counts_.size(); ++i) {
-    bucket_counts_[i].Increment(bucket_increments[i]);
+    if (bucket_increments[i] > 0.0) {
+      bucket_counts_[i] += bucket_increments[i];
+    }
   }
 }
 
 void Histogram::Reset() {
   std::lock_guard<std::mutex> lock(mutex_);
   for (std::size_t i = 0; i < bucket_counts_.size(); ++i) {
-    bucket_counts_[i].Reset();
+    bucket_counts_[i] = 0;
+    bucket_exemplars_[i].Clear();
   }
   sum_.Set(0);
+  created_timestamp_ms_ = detail::CurrentTimeMs();
 }
 
 ClientMetric Histogram::Collect() const {
@@ -80,18 +106,43 @@ ClientMetric Histogram::Collect() const {
   auto cumulative_count = 0ULL;
   metric.histogram.bucket.reserve(bucket_counts_.size());
   for (std::size_t i{0}; i < bucket_counts_.size(); ++i) {
-    cumulative_count += bucket_counts_[i].Value();
+    cumulative_count += bucket_counts_[i];
     auto bucket = ClientMetric::Bucket{};
     bucket.cumulative_count = cumulative_count;
     bucket.upper_bound = (i == bucket_boundaries_.size()
                               ? std::numeric_limits<double>::infinity()
                               : bucket_boundaries_[i]);
+    bucket.exemplar = bucket_exemplars_[i].Load();
     metric.histogram.bucket.push_back(std::move(bucket));
   }
   metric.histogram.sample_count = cumulative_count;
   metric.histogram.sample_sum = sum_.Value();
+  metric.created_timestamp_ms = created_timestamp_ms_;
 
   return metric;
 }
 
+void Histogram::Collect(MetricRecord& record,
+                        MetricRecordArena& arena) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const auto first_bucket = arena.bucket.size();
+  auto cumulative_count = 0ULL;
+  for (std::size_t i{0}; i < bucket_counts_.size(); ++i) {
+    cumulative_count += bucket_counts_[i];
+    auto bucket = ClientMetric::Bucket{};
+    bucket.cumulative_count = cumulative_count;
+    bucket.upper_bound = (i == bucket_boundaries_.size()
+                              ? std::numeric_limits<double>::infinity()
+                              : bucket_boundaries_[i]);
+    bucket.exemplar = bucket_exemplars_[i].Load();
+    arena.bucket.push_back(std::move(bucket));
+  }
+  record.histogram.sample_count = cumulative_count;
+  record.histogram.sample_sum = sum_.Value();
+  record.created_timestamp_ms = created_timestamp_ms_;
+  record.histogram.bucket = arena.bucket.data() + first_bucket;
+  record.histogram.bucket_count = bucket_counts_.size();
+}
+
 }  // namespace prometheus
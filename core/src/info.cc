@@ -8,4 +8,8 @@ ClientMetric Info::Collect() const {
   return metric;
 }
 
+void Info::Collect(MetricRecord& record, MetricRecordArena&) const {
+  record.value = 1;
+}
+
 }  // namespace prometheus
@@ -0,0 +1,112 @@
+#include "prometheus/metric_record.h"
+
+#include <memory>
+#include <utility>
+
+namespace prometheus {
+
+void MetricRecordArena::Clear() {
+  label.clear();
+  quantile.clear();
+  bucket.clear();
+  exemplar.clear();
+  family.clear();
+  family_size.clear();
+  record.clear();
+  label_text.clear();
+}
+
+MetricRecord MakeMetricRecord(const ClientMetric& metric, MetricType type,
+                              MetricRecordArena& arena) {
+  auto record = MetricRecord{};
+
+  const auto first_label = arena.label.size();
+  for (const auto& label : metric.label) {
+    arena.label.push_back(MetricRecord::LabelRef{&label.name, &label.value});
+  }
+  record.label = arena.label.data() + first_label;
+  record.label_count = metric.label.size();
+
+  switch (type) {
+    case MetricType::Counter:
+      record.value = metric.counter.value;
+      record.exemplar = metric.counter.exemplar.get();
+      break;
+    case MetricType::Gauge:
+      record.value = metric.gauge.value;
+      break;
+    case MetricType::Info:
+      record.value = metric.info.value;
+      break;
+    case MetricType::Untyped:
+      record.value = metric.untyped.value;
+      break;
+    case MetricType::Summary:
+      record.summary.sample_count = metric.summary.sample_count;
+      record.summary.sample_sum = metric.summary.sample_sum;
+      record.summary.quantile = metric.summary.quantile.data();
+      record.summary.quantile_count = metric.summary.quantile.size();
+      break;
+    case MetricType::Histogram:
+      record.histogram.sample_count = metric.histogram.sample_count;
+      record.histogram.sample_sum = metric.histogram.sample_sum;
+      record.histogram.bucket = metric.histogram.bucket.data();
+      record.histogram.bucket_count = metric.histogram.bucket.size();
+      break;
+  }
+
+  record.timestamp_ms = metric.timestamp_ms;
+  record.created_timestamp_ms = metric.created_timestamp_ms;
+  return record;
+}
+
+ClientMetric MakeClientMetric(const MetricRecord& record, MetricType type) {
+  auto metric = ClientMetric{};
+
+  metric.label.reserve(record.label_count);
+  for (std::size_t i = 0; i < record.label_count; ++i) {
+    auto label = ClientMetric::Label{};
+    label.name = *record.label[i].name;
+    label.value = *record.label[i].value;
+    metric.label.push_back(std::move(label));
+  }
+
+  switch (type) {
+    case MetricType::Counter:
+      metric.counter.value = record.value;
+      if (record.exemplar) {
+        metric.counter.exemplar =
+            std::make_shared<ClientMetric::Exemplar>(*record.exemplar);
+      }
+      break;
+    case MetricType::Gauge:
+      metric.gauge.value = record.value;
+      break;
+    case MetricType::Info:
+      metric.info.value = record.value;
+      break;
+    case MetricType::Untyped:
+      metric.untyped.value = record.value;
+      break;
+    case MetricType::Summary:
+      metric.summary.sample_count = record.summary.sample_count;
+      metric.summary.sample_sum = record.summary.sample_sum;
+      metric.summary.quantile.assign(
+          record.summary.quantile,
+          record.summary.quantile + record.summary.quantile_count);
+      break;
+    case MetricType::Histogram:
+      metric.histogram.sample_count = record.histogram.sample_count;
+      metric.histogram.sample_sum = record.histogram.sample_sum;
+      metric.histogram.bucket.assign(
+          record.histogram.bucket,
+          record.histogram.bucket + record.histogram.bucket_count);
+      break;
+  }
+
+  metric.timestamp_ms = record.timestamp_ms;
+  metric.created_timestamp_ms = record.created_timestamp_ms;
+  return metric;
+}
+
+}  // namespace prometheus
@@ -0,0 +1,97 @@
+#include "prometheus/metric_sink.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace prometheus {
+
+void MetricFamilyCollector::BeginFamily(const MetricFamily& family) {
+  families_.push_back(family);
+}
+
+void MetricFamilyCollector::AddMetric(const MetricRecord& metric) {
+  auto& family = families_.back();
+  family.metric.push_back(MakeClientMetric(metric, family.type));
+}
+
+void MetricFamilyCollector::EndFamily() {}
+
+std::vector<MetricFamily> MetricFamilyCollector::TakeFamilies() {
+  auto families = std::move(families_);
+  families_.clear();
+  return families;
+}
+
+ExternalLabelsSink::ExternalLabelsSink(MetricSink& sink, const Labels& labels)
+    : sink_(sink), labels_(labels) {
+  SetArena(&sink_.GetArena());
+}
+
+void ExternalLabelsSink::BeginFamily(const MetricFamily& family) {
+  family_label_.clear();
+  for (const auto& label_pair : labels_) {
+    auto same_name = [&label_pair](const ClientMetric::Label& label) {
+      return label.name == label_pair.first;
+    };
+    if (std::none_of(family.constant_label.begin(),
+                     family.constant_label.end(), same_name)) {
+      family_label_.push_back(
+          MetricRecord::LabelRef{&label_pair.first, &label_pair.second});
+    }
+  }
+
+  sink_.BeginFamily(family);
+}
+
+void ExternalLabelsSink::AddMetric(const MetricRecord& metric) {
+  const auto* first = metric.label;
+  const auto* last = metric.label + metric.label_count;
+
+  label_.clear();
+  for (const auto& label : family_label_) {
+    auto same_name = [&label](const MetricRecord::LabelRef& candidate) {
+      return *candidate.name == *label.name;
+    };
+    if (std::none_of(first, last, same_name)) {
+      label_.push_back(label);
+    }
+  }
+  label_.insert(label_.end(), first, last);
+
+  auto labeled = metric;
+  labeled.label = label_.data();
+  labeled.label_count = label_.size();
+  sink_.AddMetric(labeled);
+}
+
+void ExternalLabelsSink::EndFamily() { sink_.EndFamily(); }
+
+bool ExternalLabelsSink::WantsFamily(const std::string& name) const {
+  return sink_.WantsFamily(name);
+}
+
+void WriteToSink(MetricSink& sink, const std::vector<MetricFamily>& families) {
+  auto header = MetricFamily{};
+  auto& arena = sink.GetArena();
+
+  for (const auto& family : families) {
+    if (!sink.WantsFamily(family.name)) {
+      continue;
+    }
+
+    header.name = family.name;
+    header.help = family.help;
+    header.unit = family.unit;
+    header.type = family.type;
+    header.constant_label = family.constant_label;
+
+    sink.BeginFamily(header);
+    for (const auto& metric : family.metric) {
+      arena.Clear();
+      sink.AddMetric(MakeMetricRecord(metric, family.type, arena));
+    }
+    sink.EndFamily();
+  }
+}
+
+}  // namespace prometheus
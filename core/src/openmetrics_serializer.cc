@@ -0,0 +1,367 @@
+#include "prometheus/openmetrics_serializer.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "detail/text_output.h"
+#include "prometheus/client_metric.h"
+#include "prometheus/detail/future_std.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_type.h"
+
+namespace prometheus {
+
+const char* const OpenMetricsSerializer::kContentType =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+namespace {
+
+// Streams are written in chunks of at least this size
+const std::size_t kFlushThreshold = 64 * 1024;
+
+const char kEof[] = "# EOF\n";
+
+// Counter samples get a "_total" suffix, which is not part of the family name
+std::string MetricName(const MetricFamily& family) {
+  const std::string suffix = "_total";
+  auto& name = family.name;
+  if (family.type == MetricType::Counter && name.size() > suffix.size() &&
+      name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+    return name.substr(0, name.size() - suffix.size());
+  }
+  return name;
+}
+
+// Write a double as a string, with proper formatting for infinity and NaN
+void WriteValue(std::string& out, double value) {
+  if (std::isnan(value)) {
+    out.append("NaN");
+  } else if (std::isinf(value)) {
+    out.append(value < 0 ? "-Inf" : "+Inf");
+  } else {
+    detail::AppendDouble(out, value);
+  }
+}
+
+void WriteValue(std::string& out, std::uint64_t value) {
+  detail::AppendInteger(out, value);
+}
+
+// Bucket bounds and quantiles must be written as floats, i.e., "1.0"
+void WriteFloatLabelValue(std::string& out, double value) {
+  const auto first = out.size();
+  WriteValue(out, value);
+  if (out.find_first_of(".eIN", first) == std::string::npos) {
+    out.append(".0");
+  }
+}
+
+void WriteTimestamp(std::string& out, std::int64_t timestamp_ms) {
+  WriteValue(out, static_cast<double>(timestamp_ms) / 1000.0);
+}
+
+void WriteLabel(std::string& out, const char* prefix, const std::string& name,
+                const std::string& value) {
+  out.append(prefix);
+  out.append(name);
+  out.append("=\"");
+  detail::AppendEscaped(out, value);
+  out.push_back('"');
+}
+
+// Write a line header: metric name and labels
+void WriteHead(std::string& out, const std::string& name,
+               const MetricFamily& family, const MetricRecord& metric,
+               const char* suffix, const char* extraLabelName = nullptr,
+               double extraLabelValue = 0.0) {
+  out.append(name);
+  out.append(suffix);
+  if (!family.constant_label.empty() || metric.label_count != 0 ||
+      extraLabelName) {
+    out.push_back('{');
+    const char* prefix = "";
+
+    for (auto& lp : family.constant_label) {
+      WriteLabel(out, prefix, lp.name, lp.value);
+      prefix = ",";
+    }
+    for (std::size_t i = 0; i < metric.label_count; ++i) {
+      auto& lp = metric.label[i];
+      WriteLabel(out, prefix, *lp.name, *lp.value);
+      prefix = ",";
+    }
+    if (extraLabelName) {
+      out.append(prefix);
+      out.append(extraLabelName);
+      out.append("=\"");
+      WriteFloatLabelValue(out, extraLabelValue);
+      out.push_back('"');
+    }
+    out.push_back('}');
+  }
+  out.push_back(' ');
+}
+
+// Write a line trailer: timestamp and exemplar
+void WriteTail(std::string& out, const MetricRecord& metric,
+               const ClientMetric::Exemplar* exemplar = nullptr) {
+  if (metric.timestamp_ms != 0) {
+    out.push_back(' ');
+    WriteTimestamp(out, metric.timestamp_ms);
+  }
+  if (exemplar) {
+    out.append(" # {");
+    const char* prefix = "";
+    for (auto& lp : exemplar->label) {
+      WriteLabel(out, prefix, lp.name, lp.value);
+      prefix = ",";
+    }
+    out.append("} ");
+    WriteValue(out, exemplar->value);
+    if (exemplar->timestamp_ms != 0) {
+      out.push_back(' ');
+      WriteTimestamp(out, exemplar->timestamp_ms);
+    }
+  }
+  out.push_back('\n');
+}
+
+void WriteCreated(std::string& out, const std::string& name,
+                  const MetricFamily& family, const MetricRecord& metric) {
+  if (metric.created_timestamp_ms != 0) {
+    WriteHead(out, name, family, metric, "_created");
+    WriteTimestamp(out, metric.created_timestamp_ms);
+    WriteTail(out, metric);
+  }
+}
+
+void SerializeCounter(std::string& out, const std::string& name,
+                      const MetricFamily& family, const MetricRecord& metric) {
+  WriteHead(out, name, family, metric, "_total");
+  WriteValue(out, metric.value);
+  WriteTail(out, metric, metric.exemplar);
+  WriteCreated(out, name, family, metric);
+}
+
+void SerializeValue(std::string& out, const std::string& name,
+                    const char* suffix, const MetricFamily& family,
+                    const MetricRecord& metric) {
+  WriteHead(out, name, family, metric, suffix);
+  WriteValue(out, metric.value);
+  WriteTail(out, metric);
+}
+
+void SerializeSummary(std::string& out, const std::string& name,
+                      const MetricFamily& family, const MetricRecord& metric) {
+  auto& sum = metric.summary;
+  for (std::size_t i = 0; i < sum.quantile_count; ++i) {
+    auto& q = sum.quantile[i];
+    WriteHead(out, name, family, metric, "", "quantile", q.quantile);
+    WriteValue(out, q.value);
+    WriteTail(out, metric);
+  }
+
+  WriteHead(out, name, family, metric, "_sum");
+  WriteValue(out, sum.sample_sum);
+  WriteTail(out, metric);
+
+  WriteHead(out, name, family, metric, "_count");
+  WriteValue(out, sum.sample_count);
+  WriteTail(out, metric);
+
+  WriteCreated(out, name, family, metric);
+}
+
+void SerializeHistogram(std::string& out, const std::string& name,
+                        const MetricFamily& family,
+                        const MetricRecord& metric) {
+  auto& hist = metric.histogram;
+  double last = -std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < hist.bucket_count; ++i) {
+    auto& b = hist.bucket[i];
+    WriteHead(out, name, family, metric, "_bucket", "le", b.upper_bound);
+    last = b.upper_bound;
+    WriteValue(out, b.cumulative_count);
+    WriteTail(out, metric, b.exemplar.get());
+  }
+
+  if (last != std::numeric_limits<double>::infinity()) {
+    WriteHead(out, name, family, metric, "_bucket", "le",
+              std::numeric_limits<double>::infinity());
+    WriteValue(out, hist.sample_count);
+    WriteTail(out, metric);
+  }
+
+  WriteHead(out, name, family, metric, "_count");
+  WriteValue(out, hist.sample_count);
+  WriteTail(out, metric);
+
+  WriteHead(out, name, family, metric, "_sum");
+  WriteValue(out, hist.sample_sum);
+  WriteTail(out, metric);
+
+  WriteCreated(out, name, family, metric);
+}
+
+void WriteMetadata(std::string& out, const char* keyword,
+                   const std::string& name, const std::string& value) {
+  out.append(keyword);
+  out.append(name);
+  out.push_back(' ');
+  out.append(value);
+  out.push_back('\n');
+}
+
+void SerializeFamilyHeader(std::string& out, const std::string& name,
+                           const MetricFamily& family) {
+  switch (family.type) {
+    case MetricType::Counter:
+      WriteMetadata(out, "# TYPE ", name, "counter");
+      break;
+    case MetricType::Gauge:
+      WriteMetadata(out, "# TYPE ", name, "gauge");
+      break;
+    case MetricType::Info:
+      WriteMetadata(out, "# TYPE ", name, "info");
+      break;
+    case MetricType::Summary:
+      WriteMetadata(out, "# TYPE ", name, "summary");
+      break;
+    case MetricType::Untyped:
+      WriteMetadata(out, "# TYPE ", name, "unknown");
+      break;
+    case MetricType::Histogram:
+      WriteMetadata(out, "# TYPE ", name, "histogram");
+      break;
+  }
+  if (!family.unit.empty()) {
+    WriteMetadata(out, "# UNIT ", name, family.unit);
+  }
+  if (!family.help.empty()) {
+    out.append("# HELP ");
+    out.append(name);
+    out.push_back(' ');
+    detail::AppendEscaped(out, family.help);
+    out.push_back('\n');
+  }
+}
+
+void SerializeMetric(std::string& out, const std::string& name,
+                     const MetricFamily& family, const MetricRecord& metric) {
+  switch (family.type) {
+    case MetricType::Counter:
+      SerializeCounter(out, name, family, metric);
+      break;
+    case MetricType::Gauge:
+      SerializeValue(out, name, "", family, metric);
+      break;
+    case MetricType::Info:
+      SerializeValue(out, name, "_info", family, metric);
+      break;
+    case MetricType::Summary:
+      SerializeSummary(out, name, family, metric);
+      break;
+    case MetricType::Untyped:
+      SerializeValue(out, name, "", family, metric);
+      break;
+    case MetricType::Histogram:
+      SerializeHistogram(out, name, family, metric);
+      break;
+  }
+}
+
+void SerializeFamily(std::string& out, const MetricFamily& family,
+                     MetricRecordArena& arena) {
+  const auto name = MetricName(family);
+  SerializeFamilyHeader(out, name, family);
+  for (auto& metric : family.metric) {
+    arena.Clear();
+    SerializeMetric(out, name, family,
+                    MakeMetricRecord(metric, family.type, arena));
+  }
+}
+
+void Flush(std::ostream& out, std::string& buffer) {
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  buffer.clear();
+}
+
+class OpenMetricsSink : public MetricSink {
+ public:
+  explicit OpenMetricsSink(std::ostream& out) : out_(out) {
+    buffer_.reserve(kFlushThreshold);
+  }
+
+  ~OpenMetricsSink() override { Flush(out_, buffer_); }
+
+  OpenMetricsSink(const OpenMetricsSink&) = delete;
+  OpenMetricsSink& operator=(const OpenMetricsSink&) = delete;
+
+  void BeginFamily(const MetricFamily& family) override {
+    family_ = &family;
+    name_ = MetricName(family);
+    SerializeFamilyHeader(buffer_, name_, family);
+  }
+
+  void AddMetric(const MetricRecord& metric) override {
+    SerializeMetric(buffer_, name_, *family_, metric);
+    if (buffer_.size() >= kFlushThreshold) {
+      Flush(out_, buffer_);
+    }
+  }
+
+  void EndFamily() override { family_ = nullptr; }
+
+  void Finish() override {
+    buffer_.append(kEof);
+    Flush(out_, buffer_);
+  }
+
+ private:
+  std::ostream& out_;
+  std::string buffer_;
+  const MetricFamily* family_ = nullptr;
+  std::string name_;
+};
+
+}  // namespace
+
+std::string OpenMetricsSerializer::Serialize(
+    const std::vector<MetricFamily>& metrics) const {
+  std::string out;
+  auto arena = MetricRecordArena{};
+
+  for (auto& family : metrics) {
+    SerializeFamily(out, family, arena);
+  }
+  out.append(kEof);
+  return out;
+}
+
+void OpenMetricsSerializer::Serialize(
+    std::ostream& out, const std::vector<MetricFamily>& metrics) const {
+  std::string buffer;
+  auto arena = MetricRecordArena{};
+
+  for (auto& family : metrics) {
+    SerializeFamily(buffer, family, arena);
+    if (buffer.size() >= kFlushThreshold) {
+      Flush(out, buffer);
+    }
+  }
+  buffer.append(kEof);
+  Flush(out, buffer);
+}
+
+std::unique_ptr<MetricSink> OpenMetricsSerializer::MakeSink(
+    std::ostream& out) const {
+  return detail::make_unique<OpenMetricsSink>(out);
+}
+
+}  // namespace prometheus
@@ -0,0 +1,381 @@
+#include "prometheus/protobuf_serializer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "prometheus/detail/future_std.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_type.h"
+
+namespace prometheus {
+
+const char* const ProtobufSerializer::kContentType =
+    "application/vnd.google.protobuf; "
+    "proto=io.prometheus.client.MetricFamily; encoding=delimited";
+
+namespace {
+
+// Streams are written in chunks of at least this size
+const std::size_t kFlushThreshold = 64 * 1024;
+
+// Field numbers and enum values of io.prometheus.client in metrics.proto
+namespace field {
+const int kLabelPairName = 1;
+const int kLabelPairValue = 2;
+
+const int kValue = 1;  // of Gauge, Counter and Untyped
+
+const int kQuantileQuantile = 1;
+const int kQuantileValue = 2;
+
+const int kSummarySampleCount = 1;
+const int kSummarySampleSum = 2;
+const int kSummaryQuantile = 3;
+
+const int kBucketCumulativeCount = 1;
+const int kBucketUpperBound = 2;
+
+const int kHistogramSampleCount = 1;
+const int kHistogramSampleSum = 2;
+const int kHistogramBucket = 3;
+
+const int kMetricLabel = 1;
+const int kMetricGauge = 2;
+const int kMetricCounter = 3;
+const int kMetricSummary = 4;
+const int kMetricUntyped = 5;
+const int kMetricTimestampMs = 6;
+const int kMetricHistogram = 7;
+
+const int kFamilyName = 1;
+const int kFamilyHelp = 2;
+const int kFamilyType = 3;
+const int kFamilyMetric = 4;
+}  // namespace field
+
+enum ProtoMetricType : std::uint64_t {
+  kCounter = 0,
+  kGauge = 1,
+  kSummary = 2,
+  kUntyped = 3,
+  kHistogram = 4,
+};
+
+enum WireType : std::uint64_t {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+};
+
+// Encoded size of a tag with a field number below 16
+const std::size_t kTagSize = 1;
+const std::size_t kDoubleFieldSize = kTagSize + 8;
+
+std::size_t VarintSize(std::uint64_t value) {
+  std::size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+std::size_t LengthDelimitedSize(std::size_t size) {
+  return kTagSize + VarintSize(size) + size;
+}
+
+void WriteVarint(std::string& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void WriteTag(std::string& out, int field, WireType type) {
+  WriteVarint(out, (static_cast<std::uint64_t>(field) << 3) | type);
+}
+
+void WriteVarintField(std::string& out, int field, std::uint64_t value) {
+  WriteTag(out, field, kVarint);
+  WriteVarint(out, value);
+}
+
+void WriteDoubleField(std::string& out, int field, double value) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  WriteTag(out, field, kFixed64);
+  char bytes[8];
+  for (auto& byte : bytes) {
+    byte = static_cast<char>(bits & 0xFF);
+    bits >>= 8;
+  }
+  out.append(bytes, sizeof(bytes));
+}
+
+void WriteLengthDelimited(std::string& out, int field, std::size_t size) {
+  WriteTag(out, field, kLengthDelimited);
+  WriteVarint(out, size);
+}
+
+void WriteStringField(std::string& out, int field, const std::string& value) {
+  WriteLengthDelimited(out, field, value.size());
+  out.append(value);
+}
+
+std::size_t LabelPairSize(const std::string& name, const std::string& value) {
+  return LengthDelimitedSize(name.size()) + LengthDelimitedSize(value.size());
+}
+
+void WriteLabelPair(std::string& out, const std::string& name,
+                    const std::string& value) {
+  WriteLengthDelimited(out, field::kMetricLabel, LabelPairSize(name, value));
+  WriteStringField(out, field::kLabelPairName, name);
+  WriteStringField(out, field::kLabelPairValue, value);
+}
+
+const std::size_t kQuantileSize = 2 * kDoubleFieldSize;
+
+std::size_t BucketSize(const ClientMetric::Bucket& bucket) {
+  return kTagSize + VarintSize(bucket.cumulative_count) + kDoubleFieldSize;
+}
+
+// Size of the type specific message, i.e., Counter, Summary, ...
+std::size_t ValueSize(MetricType type, const MetricRecord& metric) {
+  switch (type) {
+    case MetricType::Counter:
+    case MetricType::Gauge:
+    case MetricType::Info:
+    case MetricType::Untyped:
+      return kDoubleFieldSize;
+    case MetricType::Summary: {
+      auto& sum = metric.summary;
+      return kTagSize + VarintSize(sum.sample_count) + kDoubleFieldSize +
+             sum.quantile_count * LengthDelimitedSize(kQuantileSize);
+    }
+    case MetricType::Histogram: {
+      auto& hist = metric.histogram;
+      auto size =
+          kTagSize + VarintSize(hist.sample_count) + kDoubleFieldSize;
+      for (std::size_t i = 0; i < hist.bucket_count; ++i) {
+        size += LengthDelimitedSize(BucketSize(hist.bucket[i]));
+      }
+      return size;
+    }
+  }
+  return 0;
+}
+
+void WriteValue(std::string& out, MetricType type, const MetricRecord& metric,
+                std::size_t size) {
+  switch (type) {
+    case MetricType::Counter:
+      WriteLengthDelimited(out, field::kMetricCounter, size);
+      WriteDoubleField(out, field::kValue, metric.value);
+      break;
+    case MetricType::Gauge:
+    case MetricType::Info:
+      WriteLengthDelimited(out, field::kMetricGauge, size);
+      WriteDoubleField(out, field::kValue, metric.value);
+      break;
+    case MetricType::Untyped:
+      WriteLengthDelimited(out, field::kMetricUntyped, size);
+      WriteDoubleField(out, field::kValue, metric.value);
+      break;
+    case MetricType::Summary: {
+      auto& sum = metric.summary;
+      WriteLengthDelimited(out, field::kMetricSummary, size);
+      WriteVarintField(out, field::kSummarySampleCount, sum.sample_count);
+      WriteDoubleField(out, field::kSummarySampleSum, sum.sample_sum);
+      for (std::size_t i = 0; i < sum.quantile_count; ++i) {
+        auto& q = sum.quantile[i];
+        WriteLengthDelimited(out, field::kSummaryQuantile, kQuantileSize);
+        WriteDoubleField(out, field::kQuantileQuantile, q.quantile);
+        WriteDoubleField(out, field::kQuantileValue, q.value);
+      }
+      break;
+    }
+    case MetricType::Histogram: {
+      auto& hist = metric.histogram;
+      WriteLengthDelimited(out, field::kMetricHistogram, size);
+      WriteVarintField(out, field::kHistogramSampleCount, hist.sample_count);
+      WriteDoubleField(out, field::kHistogramSampleSum, hist.sample_sum);
+      for (std::size_t i = 0; i < hist.bucket_count; ++i) {
+        auto& b = hist.bucket[i];
+        WriteLengthDelimited(out, field::kHistogramBucket, BucketSize(b));
+        WriteVarintField(out, field::kBucketCumulativeCount,
+                         b.cumulative_count);
+        WriteDoubleField(out, field::kBucketUpperBound, b.upper_bound);
+      }
+      break;
+    }
+  }
+}
+
+void SerializeMetric(std::string& out, const MetricFamily& family,
+                     const MetricRecord& metric) {
+  auto size = std::size_t{0};
+  for (auto& lp : family.constant_label) {
+    size += LengthDelimitedSize(LabelPairSize(lp.name, lp.value));
+  }
+  for (std::size_t i = 0; i < metric.label_count; ++i) {
+    auto& lp = metric.label[i];
+    size += LengthDelimitedSize(LabelPairSize(*lp.name, *lp.value));
+  }
+  const auto value_size = ValueSize(family.type, metric);
+  size += LengthDelimitedSize(value_size);
+  if (metric.timestamp_ms != 0) {
+    size += kTagSize +
+            VarintSize(static_cast<std::uint64_t>(metric.timestamp_ms));
+  }
+
+  WriteLengthDelimited(out, field::kFamilyMetric, size);
+  for (auto& lp : family.constant_label) {
+    WriteLabelPair(out, lp.name, lp.value);
+  }
+  for (std::size_t i = 0; i < metric.label_count; ++i) {
+    auto& lp = metric.label[i];
+    WriteLabelPair(out, *lp.name, *lp.value);
+  }
+  WriteValue(out, family.type, metric, value_size);
+  if (metric.timestamp_ms != 0) {
+    WriteVarintField(out, field::kMetricTimestampMs,
+                     static_cast<std::uint64_t>(metric.timestamp_ms));
+  }
+}
+
+ProtoMetricType ToProtoMetricType(MetricType type) {
+  switch (type) {
+    case MetricType::Counter:
+      return kCounter;
+    case MetricType::Gauge:
+      return kGauge;
+    // info is not handled by prometheus, we use gauge as workaround
+    case MetricType::Info:
+      return kGauge;
+    case MetricType::Summary:
+      return kSummary;
+    case MetricType::Untyped:
+      return kUntyped;
+    case MetricType::Histogram:
+      return kHistogram;
+  }
+  return kUntyped;
+}
+
+void SerializeFamilyHeader(std::string& out, const MetricFamily& family) {
+  // the name of the time series of an info metric has a suffix, just like in
+  // the text format
+  if (family.type == MetricType::Info) {
+    WriteStringField(out, field::kFamilyName, family.name + "_info");
+  } else {
+    WriteStringField(out, field::kFamilyName, family.name);
+  }
+  if (!family.help.empty()) {
+    WriteStringField(out, field::kFamilyHelp, family.help);
+  }
+  WriteVarintField(out, field::kFamilyType, ToProtoMetricType(family.type));
+}
+
+// Writes the length prefixed family message
+void WriteFamily(std::string& out, const std::string& family) {
+  WriteVarint(out, family.size());
+  out.append(family);
+}
+
+void SerializeFamily(std::string& out, std::string& scratch,
+                     const MetricFamily& family, MetricRecordArena& arena) {
+  scratch.clear();
+  SerializeFamilyHeader(scratch, family);
+  for (auto& metric : family.metric) {
+    arena.Clear();
+    SerializeMetric(scratch, family,
+                    MakeMetricRecord(metric, family.type, arena));
+  }
+  WriteFamily(out, scratch);
+}
+
+void Flush(std::ostream& out, std::string& buffer) {
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  buffer.clear();
+}
+
+// The length of a family is only known at its end, so the sink buffers one
+// family at a time.
+class ProtobufSink : public MetricSink {
+ public:
+  explicit ProtobufSink(std::ostream& out) : out_(out) {
+    buffer_.reserve(kFlushThreshold);
+  }
+
+  ~ProtobufSink() override { Flush(out_, buffer_); }
+
+  ProtobufSink(const ProtobufSink&) = delete;
+  ProtobufSink& operator=(const ProtobufSink&) = delete;
+
+  void BeginFamily(const MetricFamily& family) override {
+    family_ = &family;
+    scratch_.clear();
+    SerializeFamilyHeader(scratch_, family);
+  }
+
+  void AddMetric(const MetricRecord& metric) override {
+    SerializeMetric(scratch_, *family_, metric);
+  }
+
+  void EndFamily() override {
+    family_ = nullptr;
+    WriteFamily(buffer_, scratch_);
+    if (buffer_.size() >= kFlushThreshold) {
+      Flush(out_, buffer_);
+    }
+  }
+
+ private:
+  std::ostream& out_;
+  std::string buffer_;
+  std::string scratch_;
+  const MetricFamily* family_ = nullptr;
+};
+
+}  // namespace
+
+std::string ProtobufSerializer::Serialize(
+    const std::vector<MetricFamily>& metrics) const {
+  std::string out;
+  std::string scratch;
+  auto arena = MetricRecordArena{};
+
+  for (auto& family : metrics) {
+    SerializeFamily(out, scratch, family, arena);
+  }
+  return out;
+}
+
+void ProtobufSerializer::Serialize(
+    std::ostream& out, const std::vector<MetricFamily>& metrics) const {
+  std::string buffer;
+  std::string scratch;
+  auto arena = MetricRecordArena{};
+
+  for (auto& family : metrics) {
+    SerializeFamily(buffer, scratch, family, arena);
+    if (buffer.size() >= kFlushThreshold) {
+      Flush(out, buffer);
+    }
+  }
+  Flush(out, buffer);
+}
+
+std::unique_ptr<MetricSink> ProtobufSerializer::MakeSink(
+    std::ostream& out) const {
+  return detail::make_unique<ProtobufSink>(out);
+}
+
+}  // namespace prometheus
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <tuple>
 
+#include "detail/metric_snapshot.h"
 #include "prometheus/counter.h"
 #include "prometheus/detail/future_std.h"
 #include "prometheus/gauge.h"
@@ -56,6 +57,31 @@ std::vector<MetricFamily> Registry::Collect() const {
   return results;
 }
 
+void Registry::Collect(MetricSink& sink) const {
+  detail::MetricSnapshot snapshot{sink.GetArena()};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    SnapshotAll(snapshot, sink, counters_);
+    SnapshotAll(snapshot, sink, gauges_);
+    SnapshotAll(snapshot, sink, histograms_);
+    SnapshotAll(snapshot, sink, infos_);
+    SnapshotAll(snapshot, sink, summaries_);
+  }
+  snapshot.WriteTo(sink);
+}
+
+template <typename T>
+void Registry::SnapshotAll(
+    detail::MetricSnapshot& snapshot, const MetricSink& sink,
+    const std::vector<std::unique_ptr<Family<T>>>& families) {
+  for (const auto& family : families) {
+    if (sink.WantsFamily(family->GetName())) {
+      family->Snapshot(snapshot);
+    }
+  }
+}
+
 template <>
 std::vector<std::unique_ptr<Family<Counter>>>& Registry::GetFamilies() {
   return counters_;
@@ -108,7 +134,7 @@ bool Registry::NameExistsInOtherType<Summary>(const std::string& name) const {
 
 template <typename T>
 Family<T>& Registry::Add(const std::string& name, const std::string& help,
-                         const Labels& labels) {
+                         const Labels& labels, const std::string& unit) {
   std::lock_guard<std::mutex> lock{mutex_};
 
   if (NameExistsInOtherType<T>(name)) {
@@ -135,7 +161,7 @@ Family<T>& Registry::Add(const std::string& name, const std::string& help,
     }
   }
 
-  auto family = detail::make_unique<Family<T>>(name, help, labels);
+  auto family = detail::make_unique<Family<T>>(name, help, labels, unit);
   auto& ref = *family;
   families.push_back(std::move(family));
   return ref;
@@ -143,23 +169,28 @@ Family<T>& Registry::Add(const std::string& name, const std::string& help,
 
 template Family<Counter>& Registry::Add(const std::string& name,
                                         const std::string& help,
-                                        const Labels& labels);
+                                        const Labels& labels,
+                                        const std::string& unit);
 
 template Family<Gauge>& Registry::Add(const std::string& name,
                                       const std::string& help,
-                                      const Labels& labels);
+                                      const Labels& labels,
+                                      const std::string& unit);
 
 template Family<Info>& Registry::Add(const std::string& name,
                                      const std::string& help,
-                                     const Labels& labels);
+                                     const Labels& labels,
+                                     const std::string& unit);
 
 template Family<Summary>& Registry::Add(const std::string& name,
                                         const std::string& help,
-                                        const Labels& labels);
+                                        const Labels& labels,
+                                        const std::string& unit);
 
 template Family<Histogram>& Registry::Add(const std::string& name,
                                           const std::string& help,
-                                          const Labels& labels);
+                                          const Labels& labels,
+                                          const std::string& unit);
 
 template <typename T>
 bool Registry::Remove(const Family<T>& family) {
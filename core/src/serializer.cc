@@ -1,13 +1,52 @@
 #include "prometheus/serializer.h"
 
 #include <sstream>  // IWYU pragma: keep
+#include <utility>
+
+#include "prometheus/detail/future_std.h"
+#include "prometheus/metric_record.h"
 
 namespace prometheus {
 
+namespace {
+
+class FamilyBufferingSink : public MetricSink {
+ public:
+  FamilyBufferingSink(const Serializer& serializer, std::ostream& out)
+      : serializer_(serializer), out_(out) {}
+
+  void BeginFamily(const MetricFamily& family) override {
+    families_.resize(1);
+    families_.front() = family;
+  }
+
+  void AddMetric(const MetricRecord& metric) override {
+    auto& family = families_.front();
+    family.metric.push_back(MakeClientMetric(metric, family.type));
+  }
+
+  void EndFamily() override {
+    serializer_.Serialize(out_, families_);
+    families_.front().metric.clear();
+  }
+
+ private:
+  const Serializer& serializer_;
+  std::ostream& out_;
+  std::vector<MetricFamily> families_;
+};
+
+}  // namespace
+
 std::string Serializer::Serialize(
     const std::vector<MetricFamily>& metrics) const {
   std::ostringstream ss;
   Serialize(ss, metrics);
   return ss.str();
 }
+
+std::unique_ptr<MetricSink> Serializer::MakeSink(std::ostream& out) const {
+  return detail::make_unique<FamilyBufferingSink>(*this, out);
+}
+
 }  // namespace prometheus
@@ -2,17 +2,21 @@
 
 #include <utility>
 
+#include "detail/clock.h"
+
 namespace prometheus {
 
 Summary::Summary(const Quantiles& quantiles,
                  const std::chrono::milliseconds max_age, const int age_buckets)
     : quantiles_{quantiles},
-      quantile_values_{quantiles_, max_age, age_buckets} {}
+      quantile_values_{quantiles_, max_age, age_buckets},
+      created_timestamp_ms_{detail::CurrentTimeMs()} {}
 
 Summary::Summary(Quantiles&& quantiles, const std::chrono::milliseconds max_age,
                  const int age_buckets)
     : quantiles_{std::move(quantiles)},
-      quantile_values_{quantiles_, max_age, age_buckets} {}
+      quantile_values_{quantiles_, max_age, age_buckets},
+      created_timestamp_ms_{detail::CurrentTimeMs()} {}
 
 void Summary::Observe(const double value) {
   std::lock_guard<std::mutex> lock(mutex_);
@@ -36,8 +40,26 @@ ClientMetric Summary::Collect() const {
   }
   metric.summary.sample_count = count_;
   metric.summary.sample_sum = sum_;
+  metric.created_timestamp_ms = created_timestamp_ms_;
 
   return metric;
 }
 
+void Summary::Collect(MetricRecord& record, MetricRecordArena& arena) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const auto first_quantile = arena.quantile.size();
+  for (const auto& quantile : quantiles_) {
+    auto metricQuantile = ClientMetric::Quantile{};
+    metricQuantile.quantile = quantile.quantile;
+    metricQuantile.value = quantile_values_.get(quantile.quantile);
+    arena.quantile.push_back(metricQuantile);
+  }
+  record.summary.sample_count = count_;
+  record.summary.sample_sum = sum_;
+  record.created_timestamp_ms = created_timestamp_ms_;
+  record.summary.quantile = arena.quantile.data() + first_quantile;
+  record.summary.quantile_count = quantiles_.size();
+}
+
 }  // namespace prometheus
@@ -1,138 +1,158 @@
 #include "prometheus/text_serializer.h"
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
-#include <locale>
+#include <memory>
 #include <ostream>
 #include <string>
 
-#include "prometheus/client_metric.h"
+#include "detail/text_output.h"
+#include "prometheus/detail/future_std.h"
 #include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 
 namespace prometheus {
 
+const char* const TextSerializer::kContentType =
+    "text/plain; version=0.0.4; charset=utf-8";
+
 namespace {
 
+// Streams are written in chunks of at least this size
+const std::size_t kFlushThreshold = 64 * 1024;
+
+void Write(std::string& out, const std::string& value) { out.append(value); }
+
+template <std::size_t N>
+void Write(std::string& out, const char (&value)[N]) {
+  out.append(value, N - 1);
+}
+
 // Write a double as a string, with proper formatting for infinity and NaN
-void WriteValue(std::ostream& out, double value) {
+void WriteValue(std::string& out, double value) {
   if (std::isnan(value)) {
-    out << "Nan";
+    Write(out, "Nan");
   } else if (std::isinf(value)) {
-    out << (value < 0 ? "-Inf" : "+Inf");
+    out.append(value < 0 ? "-Inf" : "+Inf");
   } else {
-    out << value;
+    detail::AppendDouble(out, value);
   }
 }
 
-void WriteValue(std::ostream& out, const std::string& value) {
-  for (auto c : value) {
-    switch (c) {
-      case '\n':
-        out << '\\' << 'n';
-        break;
-
-      case '\\':
-        out << '\\' << c;
-        break;
+void WriteValue(std::string& out, std::uint64_t value) {
+  detail::AppendInteger(out, value);
+}
 
-      case '"':
-        out << '\\' << c;
-        break;
+void WriteValue(std::string& out, const std::string& value) {
+  detail::AppendEscaped(out, value);
+}
 
-      default:
-        out << c;
-        break;
-    }
-  }
+void WriteLabel(std::string& out, const char* prefix, const std::string& name,
+                const std::string& value) {
+  out.append(prefix);
+  Write(out, name);
+  Write(out, "=\"");
+  WriteValue(out, value);
+  out.push_back('"');
 }
 
 // Write a line header: metric name and labels
-template <typename T = std::string>
-void WriteHead(std::ostream& out, const MetricFamily& family,
-               const ClientMetric& metric, const std::string& suffix = "",
-               const std::string& extraLabelName = "",
-               const T& extraLabelValue = T()) {
-  out << family.name << suffix;
-  if (!metric.label.empty() || !extraLabelName.empty()) {
-    out << "{";
+void WriteHead(std::string& out, const MetricFamily& family,
+               const MetricRecord& metric, const char* suffix = "",
+               const char* extraLabelName = nullptr,
+               double extraLabelValue = 0.0) {
+  Write(out, family.name);
+  out.append(suffix);
+  if (!family.constant_label.empty() || metric.label_count != 0 ||
+      extraLabelName) {
+    out.push_back('{');
     const char* prefix = "";
 
-    for (auto& lp : metric.label) {
-      out << prefix << lp.name << "=\"";
-      WriteValue(out, lp.value);
-      out << "\"";
+    for (auto& lp : family.constant_label) {
+      WriteLabel(out, prefix, lp.name, lp.value);
       prefix = ",";
     }
-    if (!extraLabelName.empty()) {
-      out << prefix << extraLabelName << "=\"";
+    for (std::size_t i = 0; i < metric.label_count; ++i) {
+      auto& lp = metric.label[i];
+      WriteLabel(out, prefix, *lp.name, *lp.value);
+      prefix = ",";
+    }
+    if (extraLabelName) {
+      out.append(prefix);
+      out.append(extraLabelName);
+      Write(out, "=\"");
       WriteValue(out, extraLabelValue);
-      out << "\"";
+      out.push_back('"');
     }
-    out << "}";
+    out.push_back('}');
   }
-  out << " ";
+  out.push_back(' ');
 }
 
 // Write a line trailer: timestamp
-void WriteTail(std::ostream& out, const ClientMetric& metric) {
+void WriteTail(std::string& out, const MetricRecord& metric) {
   if (metric.timestamp_ms != 0) {
-    out << " " << metric.timestamp_ms;
+    out.push_back(' ');
+    detail::AppendInteger(out, metric.timestamp_ms);
   }
-  out << "\n";
+  out.push_back('\n');
 }
 
-void SerializeCounter(std::ostream& out, const MetricFamily& family,
-                      const ClientMetric& metric) {
+void SerializeCounter(std::string& out, const MetricFamily& family,
+                      const MetricRecord& metric) {
   WriteHead(out, family, metric);
-  WriteValue(out, metric.counter.value);
+  WriteValue(out, metric.value);
   WriteTail(out, metric);
 }
 
-void SerializeGauge(std::ostream& out, const MetricFamily& family,
-                    const ClientMetric& metric) {
+void SerializeGauge(std::string& out, const MetricFamily& family,
+                    const MetricRecord& metric) {
   WriteHead(out, family, metric);
-  WriteValue(out, metric.gauge.value);
+  WriteValue(out, metric.value);
   WriteTail(out, metric);
 }
 
-void SerializeInfo(std::ostream& out, const MetricFamily& family,
-                   const ClientMetric& metric) {
+void SerializeInfo(std::string& out, const MetricFamily& family,
+                   const MetricRecord& metric) {
   WriteHead(out, family, metric, "_info");
-  WriteValue(out, metric.info.value);
+  WriteValue(out, metric.value);
   WriteTail(out, metric);
 }
 
-void SerializeSummary(std::ostream& out, const MetricFamily& family,
-                      const ClientMetric& metric) {
+void SerializeSummary(std::string& out, const MetricFamily& family,
+                      const MetricRecord& metric) {
   auto& sum = metric.summary;
   WriteHead(out, family, metric, "_count");
-  out << sum.sample_count;
+  WriteValue(out, sum.sample_count);
   WriteTail(out, metric);
 
   WriteHead(out, family, metric, "_sum");
   WriteValue(out, sum.sample_sum);
   WriteTail(out, metric);
 
-  for (auto& q : sum.quantile) {
+  for (std::size_t i = 0; i < sum.quantile_count; ++i) {
+    auto& q = sum.quantile[i];
     WriteHead(out, family, metric, "", "quantile", q.quantile);
     WriteValue(out, q.value);
     WriteTail(out, metric);
   }
 }
 
-void SerializeUntyped(std::ostream& out, const MetricFamily& family,
-                      const ClientMetric& metric) {
+void SerializeUntyped(std::string& out, const MetricFamily& family,
+                      const MetricRecord& metric) {
   WriteHead(out, family, metric);
-  WriteValue(out, metric.untyped.value);
+  WriteValue(out, metric.value);
   WriteTail(out, metric);
 }
 
-void SerializeHistogram(std::ostream& out, const MetricFamily& family,
-                        const ClientMetric& metric) {
+void SerializeHistogram(std::string& out, const MetricFamily& family,
+                        const MetricRecord& metric) {
   auto& hist = metric.histogram;
   WriteHead(out, family, metric, "_count");
-  out << hist.sample_count;
+  WriteValue(out, hist.sample_count);
   WriteTail(out, metric);
 
   WriteHead(out, family, metric, "_sum");
@@ -140,80 +160,160 @@ void SerializeHistogram(std::ostream& out, const MetricFamily& family,
   WriteTail(out, metric);
 
   double last = -std::numeric_limits<double>::infinity();
-  for (auto& b : hist.bucket) {
+  for (std::size_t i = 0; i < hist.bucket_count; ++i) {
+    auto& b = hist.bucket[i];
     WriteHead(out, family, metric, "_bucket", "le", b.upper_bound);
     last = b.upper_bound;
-    out << b.cumulative_count;
+    WriteValue(out, b.cumulative_count);
     WriteTail(out, metric);
   }
 
   if (last != std::numeric_limits<double>::infinity()) {
-    WriteHead(out, family, metric, "_bucket", "le", "+Inf");
-    out << hist.sample_count;
+    WriteHead(out, family, metric, "_bucket", "le",
+              std::numeric_limits<double>::infinity());
+    WriteValue(out, hist.sample_count);
     WriteTail(out, metric);
   }
 }
 
-void SerializeFamily(std::ostream& out, const MetricFamily& family) {
+void WriteType(std::string& out, const MetricFamily& family,
+               const char* type) {
+  Write(out, "# TYPE ");
+  Write(out, family.name);
+  out.push_back(' ');
+  out.append(type);
+  out.push_back('\n');
+}
+
+void SerializeFamilyHeader(std::string& out, const MetricFamily& family) {
   if (!family.help.empty()) {
-    out << "# HELP " << family.name << " " << family.help << "\n";
+    Write(out, "# HELP ");
+    Write(out, family.name);
+    out.push_back(' ');
+    Write(out, family.help);
+    out.push_back('\n');
   }
   switch (family.type) {
     case MetricType::Counter:
-      out << "# TYPE " << family.name << " counter\n";
-      for (auto& metric : family.metric) {
-        SerializeCounter(out, family, metric);
-      }
+      WriteType(out, family, "counter");
       break;
     case MetricType::Gauge:
-      out << "# TYPE " << family.name << " gauge\n";
-      for (auto& metric : family.metric) {
-        SerializeGauge(out, family, metric);
-      }
+      WriteType(out, family, "gauge");
       break;
     // info is not handled by prometheus, we use gauge as workaround
     // (https://github.com/OpenObservability/OpenMetrics/blob/98ae26c87b1c3bcf937909a880b32c8be643cc9b/specification/OpenMetrics.md#info-1)
     case MetricType::Info:
-      out << "# TYPE " << family.name << " gauge\n";
-      for (auto& metric : family.metric) {
-        SerializeInfo(out, family, metric);
-      }
+      WriteType(out, family, "gauge");
       break;
     case MetricType::Summary:
-      out << "# TYPE " << family.name << " summary\n";
-      for (auto& metric : family.metric) {
-        SerializeSummary(out, family, metric);
-      }
+      WriteType(out, family, "summary");
       break;
     case MetricType::Untyped:
-      out << "# TYPE " << family.name << " untyped\n";
-      for (auto& metric : family.metric) {
-        SerializeUntyped(out, family, metric);
-      }
+      WriteType(out, family, "untyped");
       break;
     case MetricType::Histogram:
-      out << "# TYPE " << family.name << " histogram\n";
-      for (auto& metric : family.metric) {
-        SerializeHistogram(out, family, metric);
-      }
+      WriteType(out, family, "histogram");
       break;
   }
 }
+
+void SerializeMetric(std::string& out, const MetricFamily& family,
+                     const MetricRecord& metric) {
+  switch (family.type) {
+    case MetricType::Counter:
+      SerializeCounter(out, family, metric);
+      break;
+    case MetricType::Gauge:
+      SerializeGauge(out, family, metric);
+      break;
+    case MetricType::Info:
+      SerializeInfo(out, family, metric);
+      break;
+    case MetricType::Summary:
+      SerializeSummary(out, family, metric);
+      break;
+    case MetricType::Untyped:
+      SerializeUntyped(out, family, metric);
+      break;
+    case MetricType::Histogram:
+      SerializeHistogram(out, family, metric);
+      break;
+  }
+}
+
+void SerializeFamily(std::string& out, const MetricFamily& family,
+                     MetricRecordArena& arena) {
+  SerializeFamilyHeader(out, family);
+  for (auto& metric : family.metric) {
+    arena.Clear();
+    SerializeMetric(out, family, MakeMetricRecord(metric, family.type, arena));
+  }
+}
+
+void Flush(std::ostream& out, std::string& buffer) {
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  buffer.clear();
+}
+
+class TextSink : public MetricSink {
+ public:
+  explicit TextSink(std::ostream& out) : out_(out) {
+    buffer_.reserve(kFlushThreshold);
+  }
+
+  ~TextSink() override { Flush(out_, buffer_); }
+
+  TextSink(const TextSink&) = delete;
+  TextSink& operator=(const TextSink&) = delete;
+
+  void BeginFamily(const MetricFamily& family) override {
+    family_ = &family;
+    SerializeFamilyHeader(buffer_, family);
+  }
+
+  void AddMetric(const MetricRecord& metric) override {
+    SerializeMetric(buffer_, *family_, metric);
+    if (buffer_.size() >= kFlushThreshold) {
+      Flush(out_, buffer_);
+    }
+  }
+
+  void EndFamily() override { family_ = nullptr; }
+
+ private:
+  std::ostream& out_;
+  std::string buffer_;
+  const MetricFamily* family_ = nullptr;
+};
+
 }  // namespace
 
+std::string TextSerializer::Serialize(
+    const std::vector<MetricFamily>& metrics) const {
+  std::string out;
+  auto arena = MetricRecordArena{};
+
+  for (auto& family : metrics) {
+    SerializeFamily(out, family, arena);
+  }
+  return out;
+}
+
 void TextSerializer::Serialize(std::ostream& out,
                                const std::vector<MetricFamily>& metrics) const {
-  auto saved_locale = out.getloc();
-  auto saved_precision = out.precision();
-
-  out.imbue(std::locale::classic());
-  out.precision(std::numeric_limits<double>::max_digits10 - 1);
+  std::string buffer;
+  auto arena = MetricRecordArena{};
 
   for (auto& family : metrics) {
-    SerializeFamily(out, family);
+    SerializeFamily(buffer, family, arena);
+    if (buffer.size() >= kFlushThreshold) {
+      Flush(out, buffer);
+    }
   }
+  Flush(out, buffer);
+}
 
-  out.imbue(saved_locale);
-  out.precision(saved_precision);
+std::unique_ptr<MetricSink> TextSerializer::MakeSink(std::ostream& out) const {
+  return detail::make_unique<TextSink>(out);
 }
 }  // namespace prometheus
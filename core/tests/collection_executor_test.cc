@@ -0,0 +1,88 @@
+#include "prometheus/collection_executor.h"
+
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+namespace prometheus {
+namespace {
+
+TEST(CollectionExecutorTest, shouldRunTasksOnItsThreads) {
+  CollectionExecutor executor;
+  std::promise<std::thread::id> ran;
+
+  executor.AsExecutor()([&ran] { ran.set_value(std::this_thread::get_id()); });
+
+  EXPECT_NE(ran.get_future().get(), std::this_thread::get_id());
+}
+
+TEST(CollectionExecutorTest, shouldRunPendingTasksBeforeStopping) {
+  auto count = 0;
+  {
+    auto options = CollectionExecutor::Options{};
+    options.num_threads = 1;
+    CollectionExecutor executor{options};
+    for (auto i = 0; i < 100; ++i) {
+      executor.Post([&count] { ++count; });
+    }
+  }
+  EXPECT_EQ(count, 100);
+}
+
+TEST(CollectionExecutorTest, shouldRunTasksAfterOneThrew) {
+  auto options = CollectionExecutor::Options{};
+  options.num_threads = 1;
+  CollectionExecutor executor{options};
+  std::promise<void> ran;
+
+  executor.Post([] { throw std::runtime_error{"failed"}; });
+  executor.Post([] { throw 42; });
+  executor.Post([&ran] { ran.set_value(); });
+
+  ran.get_future().get();
+}
+
+#ifdef __linux__
+TEST(CollectionExecutorTest, shouldPinThreadsWithIdlePriority) {
+  // the first CPU the process may run on, CPU 0 may be excluded
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  ASSERT_EQ(::sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  auto first_cpu = 0;
+  while (first_cpu < CPU_SETSIZE && !CPU_ISSET(first_cpu, &allowed)) {
+    ++first_cpu;
+  }
+  ASSERT_LT(first_cpu, CPU_SETSIZE);
+
+  auto options = CollectionExecutor::Options{};
+  options.cpus = {first_cpu};
+  options.idle_priority = true;
+  CollectionExecutor executor{options};
+  std::promise<int> cpu;
+  std::promise<int> policy;
+
+  executor.Post([&cpu, &policy] {
+    cpu.set_value(::sched_getcpu());
+    policy.set_value(::sched_getscheduler(0));
+  });
+
+  EXPECT_EQ(cpu.get_future().get(), first_cpu);
+  EXPECT_EQ(policy.get_future().get(), SCHED_IDLE);
+}
+
+TEST(CollectionExecutorTest, shouldThrowIfThreadsCannotBeConfigured) {
+  auto options = CollectionExecutor::Options{};
+  options.cpus = {-1};
+
+  EXPECT_THROW(CollectionExecutor{options}, std::runtime_error);
+}
+#endif
+
+}  // namespace
+}  // namespace prometheus
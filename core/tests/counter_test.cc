@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace prometheus {
 namespace {
 
@@ -47,5 +52,61 @@ TEST(CounterTest, reset) {
   EXPECT_EQ(counter.Value(), 6.0);
 }
 
+TEST(CounterTest, should_keep_latest_exemplar) {
+  Counter counter;
+  EXPECT_EQ(counter.Collect().counter.exemplar, nullptr);
+
+  counter.Increment(1.0, {{"trace_id", "abc"}});
+  counter.Increment(2.0, {{"trace_id", "def"}});
+  const auto metric = counter.Collect();
+  EXPECT_EQ(metric.counter.value, 3.0);
+  ASSERT_NE(metric.counter.exemplar, nullptr);
+  ASSERT_EQ(metric.counter.exemplar->label.size(), 1U);
+  EXPECT_EQ(metric.counter.exemplar->label[0].value, "def");
+  EXPECT_EQ(metric.counter.exemplar->value, 2.0);
+  EXPECT_GT(metric.counter.exemplar->timestamp_ms, 0);
+
+  // collecting must not consume the exemplar
+  EXPECT_NE(counter.Collect().counter.exemplar, nullptr);
+}
+
+TEST(CounterTest, reset_should_drop_exemplar) {
+  Counter counter;
+  counter.Increment(1.0, {{"trace_id", "abc"}});
+  counter.Reset();
+  EXPECT_EQ(counter.Collect().counter.exemplar, nullptr);
+}
+
+TEST(CounterTest, concurrent_collections_should_all_see_exemplar) {
+  Counter counter;
+  counter.Increment(1.0, {{"trace_id", "abc"}});
+
+  std::vector<std::thread> collectors;
+  for (int i = 0; i < 4; ++i) {
+    collectors.emplace_back([&counter] {
+      for (int j = 0; j < 1000; ++j) {
+        ASSERT_NE(counter.Collect().counter.exemplar, nullptr);
+      }
+    });
+  }
+  for (auto& collector : collectors) {
+    collector.join();
+  }
+}
+
+TEST(CounterTest, should_reject_invalid_exemplar) {
+  Counter counter;
+  EXPECT_THROW(counter.Increment(1.0, {{"__invalid", "x"}}),
+               std::invalid_argument);
+  EXPECT_THROW(counter.Increment(1.0, {{"trace_id", std::string(121, 'x')}}),
+               std::invalid_argument);
+  EXPECT_EQ(counter.Value(), 0.0);
+}
+
+TEST(CounterTest, should_record_creation_time) {
+  Counter counter;
+  EXPECT_GT(counter.Collect().created_timestamp_ms, 0);
+}
+
 }  // namespace
 }  // namespace prometheus
@@ -4,12 +4,15 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <stdexcept>
 
 #include "prometheus/client_metric.h"
 #include "prometheus/counter.h"
 #include "prometheus/detail/future_std.h"
+#include "prometheus/gauge.h"
 #include "prometheus/histogram.h"
 #include "prometheus/labels.h"
+#include "prometheus/metric_sink.h"
 #include "prometheus/summary.h"
 
 namespace prometheus {
@@ -30,6 +33,54 @@ TEST(FamilyTest, labels) {
               ::testing::ElementsAre(const_label, dynamic_label));
 }
 
+TEST(FamilyTest, streamed_labels) {
+  auto const_label = ClientMetric::Label{"component", "test"};
+  auto dynamic_label = ClientMetric::Label{"status", "200"};
+
+  Family<Counter> family{"total_requests",
+                         "Counts all requests",
+                         {{const_label.name, const_label.value}}};
+  family.Add({{dynamic_label.name, dynamic_label.value}});
+  MetricFamilyCollector collector;
+  family.Collect(collector);
+  auto collected = collector.TakeFamilies();
+  ASSERT_GE(collected.size(), 1U);
+  ASSERT_GE(collected.at(0).metric.size(), 1U);
+  EXPECT_THAT(collected.at(0).constant_label,
+              ::testing::ElementsAre(const_label));
+  EXPECT_THAT(collected.at(0).metric.at(0).label,
+              ::testing::ElementsAre(dynamic_label));
+}
+
+// Adds a metric to the family it collects, which would deadlock if the
+// family were still locked
+class AddingCollector : public MetricFamilyCollector {
+ public:
+  explicit AddingCollector(Family<Counter>& family) : family_(family) {}
+
+  void AddMetric(const MetricRecord& metric) override {
+    family_.Add({{"status", "500"}});
+    MetricFamilyCollector::AddMetric(metric);
+  }
+
+ private:
+  Family<Counter>& family_;
+};
+
+TEST(FamilyTest, should_not_lock_while_sink_runs) {
+  Family<Counter> family{"total_requests", "Counts all requests", {}};
+  family.Add({{"status", "200"}});
+  AddingCollector collector{family};
+
+  family.Collect(collector);
+
+  auto collected = collector.TakeFamilies();
+  ASSERT_EQ(collected.size(), 1U);
+  ASSERT_EQ(collected.at(0).metric.size(), 1U);
+  EXPECT_EQ(collected.at(0).metric.at(0).label.at(0).value, "200");
+  EXPECT_TRUE(family.Has({{"status", "500"}}));
+}
+
 TEST(FamilyTest, reject_same_label_keys) {
   auto labels = Labels{{"component", "test"}};
 
@@ -87,6 +138,25 @@ TEST(FamilyTest, throw_on_invalid_metric_name) {
   EXPECT_ANY_THROW(create_family_with_invalid_name());
 }
 
+TEST(FamilyTest, should_accept_matching_unit) {
+  Family<Counter> family{"request_size_bytes_total", "", {}, "bytes"};
+  family.Add({});
+  auto collected = family.Collect();
+  ASSERT_EQ(collected.size(), 1U);
+  EXPECT_EQ(collected[0].unit, "bytes");
+
+  EXPECT_NO_THROW(
+      (Family<Histogram>{"request_duration_seconds", "", {}, "seconds"}));
+}
+
+TEST(FamilyTest, throw_on_unit_not_in_name) {
+  auto create_family_with_wrong_unit = []() {
+    return detail::make_unique<Family<Gauge>>("temperature_celsius", "",
+                                              Labels{}, "kelvin");
+  };
+  EXPECT_THROW(create_family_with_wrong_unit(), std::invalid_argument);
+}
+
 TEST(FamilyTest, throw_on_invalid_constant_label_name) {
   auto create_family_with_invalid_labels = []() {
     return detail::make_unique<Family<Counter>>(
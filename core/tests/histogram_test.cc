@@ -143,6 +143,22 @@ TEST(HistogramTest, test_reset) {
   EXPECT_EQ(h.sample_sum, 54);
 }
 
+TEST(HistogramTest, should_attach_exemplar_to_bucket) {
+  Histogram histogram{{1, 2}};
+  histogram.Observe(1.5, {{"trace_id", "abc"}});
+  histogram.Observe(0.5);
+  auto metric = histogram.Collect();
+  auto h = metric.histogram;
+  EXPECT_EQ(h.sample_count, 2U);
+  ASSERT_EQ(h.bucket.size(), 3U);
+  EXPECT_EQ(h.bucket.at(0).exemplar, nullptr);
+  ASSERT_NE(h.bucket.at(1).exemplar, nullptr);
+  EXPECT_EQ(h.bucket.at(1).exemplar->value, 1.5);
+  EXPECT_EQ(h.bucket.at(1).exemplar->label.at(0).name, "trace_id");
+  EXPECT_EQ(h.bucket.at(2).exemplar, nullptr);
+  EXPECT_GT(metric.created_timestamp_ms, 0);
+}
+
 TEST(HistogramTest, sum_can_go_down) {
   Histogram histogram{{1}};
   auto metric1 = histogram.Collect();
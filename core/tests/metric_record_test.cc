@@ -0,0 +1,132 @@
+#include "prometheus/metric_record.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+
+#include "prometheus/client_metric.h"
+#include "prometheus/counter.h"
+#include "prometheus/histogram.h"
+#include "prometheus/metric_type.h"
+#include "prometheus/summary.h"
+
+namespace prometheus {
+namespace {
+
+TEST(MetricRecordTest, shouldBeSmallerThanClientMetric) {
+  EXPECT_LT(sizeof(MetricRecord), sizeof(ClientMetric) / 2);
+}
+
+TEST(MetricRecordTest, shouldReferenceLabelsOfClientMetric) {
+  auto metric = ClientMetric{};
+  metric.label = {{"a", "1"}, {"b", "2"}};
+  metric.gauge.value = 3.0;
+  metric.timestamp_ms = 1234;
+
+  MetricRecordArena arena;
+  auto record = MakeMetricRecord(metric, MetricType::Gauge, arena);
+
+  ASSERT_EQ(record.label_count, 2U);
+  EXPECT_EQ(record.label[0].name, &metric.label[0].name);
+  EXPECT_EQ(record.label[1].value, &metric.label[1].value);
+  EXPECT_EQ(record.value, 3.0);
+  EXPECT_EQ(record.timestamp_ms, 1234);
+}
+
+TEST(MetricRecordTest, shouldRoundTripHistogram) {
+  Histogram histogram{{1, 2}};
+  histogram.Observe(1.5);
+  auto metric = histogram.Collect();
+  metric.label = {{"a", "1"}};
+
+  MetricRecordArena arena;
+  auto record = MakeMetricRecord(metric, MetricType::Histogram, arena);
+  auto copy = MakeClientMetric(record, MetricType::Histogram);
+
+  EXPECT_EQ(copy.label, metric.label);
+  EXPECT_EQ(copy.histogram.sample_count, 1U);
+  EXPECT_EQ(copy.histogram.sample_sum, 1.5);
+  ASSERT_EQ(copy.histogram.bucket.size(), 3U);
+  EXPECT_EQ(copy.histogram.bucket[1].cumulative_count, 1U);
+  EXPECT_EQ(copy.histogram.bucket[1].upper_bound, 2.0);
+}
+
+TEST(MetricRecordTest, shouldRoundTripSummary) {
+  auto metric = ClientMetric{};
+  metric.summary.sample_count = 2;
+  metric.summary.sample_sum = 4.0;
+  metric.summary.quantile.resize(2);
+  metric.summary.quantile[0].quantile = 0.5;
+  metric.summary.quantile[0].value = 1.0;
+  metric.summary.quantile[1].quantile = 0.9;
+  metric.summary.quantile[1].value = 3.0;
+
+  MetricRecordArena arena;
+  auto record = MakeMetricRecord(metric, MetricType::Summary, arena);
+  auto copy = MakeClientMetric(record, MetricType::Summary);
+
+  EXPECT_EQ(copy.summary.sample_count, 2U);
+  EXPECT_EQ(copy.summary.sample_sum, 4.0);
+  ASSERT_EQ(copy.summary.quantile.size(), 2U);
+  EXPECT_EQ(copy.summary.quantile[1].quantile, 0.9);
+  EXPECT_EQ(copy.summary.quantile[1].value, 3.0);
+}
+
+TEST(MetricRecordTest, counterShouldCollectIntoRecord) {
+  Counter counter;
+  counter.Increment(5);
+
+  MetricRecordArena arena;
+  MetricRecord record;
+  counter.Collect(record, arena);
+
+  EXPECT_EQ(record.value, 5.0);
+}
+
+TEST(MetricRecordTest, histogramShouldCollectBucketsIntoArena) {
+  Histogram histogram{{1, 2}};
+  histogram.Observe(0.5);
+  histogram.Observe(5);
+
+  MetricRecordArena arena;
+  MetricRecord record;
+  histogram.Collect(record, arena);
+
+  ASSERT_EQ(record.histogram.bucket_count, 3U);
+  EXPECT_EQ(record.histogram.bucket, arena.bucket.data());
+  EXPECT_EQ(record.histogram.sample_count, 2U);
+  EXPECT_EQ(record.histogram.sample_sum, 5.5);
+  EXPECT_EQ(record.histogram.bucket[0].cumulative_count, 1U);
+  EXPECT_EQ(record.histogram.bucket[2].cumulative_count, 2U);
+  EXPECT_EQ(record.histogram.bucket[2].upper_bound,
+            std::numeric_limits<double>::infinity());
+}
+
+TEST(MetricRecordTest, summaryShouldCollectQuantilesIntoArena) {
+  Summary summary{Summary::Quantiles{{0.5, 0.05}}};
+  summary.Observe(1);
+
+  MetricRecordArena arena;
+  MetricRecord record;
+  summary.Collect(record, arena);
+
+  ASSERT_EQ(record.summary.quantile_count, 1U);
+  EXPECT_EQ(record.summary.quantile, arena.quantile.data());
+  EXPECT_EQ(record.summary.sample_count, 1U);
+  EXPECT_EQ(record.summary.quantile[0].quantile, 0.5);
+}
+
+TEST(MetricRecordTest, clearShouldKeepCapacity) {
+  MetricRecordArena arena;
+  arena.bucket.resize(16);
+  const auto capacity = arena.bucket.capacity();
+
+  arena.Clear();
+
+  EXPECT_TRUE(arena.bucket.empty());
+  EXPECT_EQ(arena.bucket.capacity(), capacity);
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,227 @@
+#include "prometheus/metric_sink.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "prometheus/collectable.h"
+#include "prometheus/counter.h"
+#include "prometheus/family.h"
+#include "prometheus/gauge.h"
+#include "prometheus/histogram.h"
+#include "prometheus/labels.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/registry.h"
+#include "prometheus/text_serializer.h"
+
+namespace prometheus {
+namespace {
+
+class StaticCollectable : public Collectable {
+ public:
+  explicit StaticCollectable(std::vector<MetricFamily> families)
+      : families_(std::move(families)) {}
+
+  using Collectable::Collect;
+  std::vector<MetricFamily> Collect() const override { return families_; }
+
+ private:
+  std::vector<MetricFamily> families_;
+};
+
+class FamilyNameSerializer : public Serializer {
+ public:
+  using Serializer::Serialize;
+  void Serialize(std::ostream& out,
+                 const std::vector<MetricFamily>& metrics) const override {
+    for (auto& family : metrics) {
+      out << family.name << ":" << family.metric.size() << "\n";
+    }
+  }
+};
+
+// Collects only the families of the given name
+class SelectingCollector : public MetricFamilyCollector {
+ public:
+  explicit SelectingCollector(std::string name) : name_(std::move(name)) {}
+
+  bool WantsFamily(const std::string& name) const override {
+    ++asked_;
+    return name == name_;
+  }
+
+  mutable int asked_ = 0;
+
+ private:
+  std::string name_;
+};
+
+class MetricSinkTest : public testing::Test {
+ public:
+  MetricSinkTest() {
+    auto& counters = BuildCounter()
+                         .Name("requests_total")
+                         .Help("counts requests")
+                         .Labels({{"component", "test"}})
+                         .Register(registry);
+    counters.Add({{"status", "200"}}).Increment(3);
+    counters.Add({{"status", "500"}}).Increment();
+
+    BuildGauge().Name("temperature").Register(registry).Add({}).Set(21.5);
+
+    BuildHistogram()
+        .Name("latency")
+        .Register(registry)
+        .Add({}, Histogram::BucketBoundaries{1, 2})
+        .Observe(1.5);
+
+    BuildCounter().Name("empty_total").Register(registry);
+  }
+
+  Registry registry;
+};
+
+TEST_F(MetricSinkTest, collectorShouldMatchListBasedCollect) {
+  MetricFamilyCollector collector;
+  registry.Collect(collector);
+  auto streamed = collector.TakeFamilies();
+  auto collected = registry.Collect();
+
+  ASSERT_EQ(streamed.size(), collected.size());
+  for (std::size_t i = 0; i < streamed.size(); ++i) {
+    EXPECT_EQ(streamed[i].name, collected[i].name);
+    EXPECT_EQ(streamed[i].help, collected[i].help);
+    EXPECT_EQ(streamed[i].type, collected[i].type);
+    ASSERT_EQ(streamed[i].metric.size(), collected[i].metric.size());
+  }
+}
+
+TEST_F(MetricSinkTest, collectorShouldBeEmptyAfterTakingFamilies) {
+  MetricFamilyCollector collector;
+  registry.Collect(collector);
+  EXPECT_EQ(collector.TakeFamilies().size(), 3U);
+  EXPECT_TRUE(collector.TakeFamilies().empty());
+}
+
+TEST_F(MetricSinkTest, shouldAdaptListBasedCollectables) {
+  StaticCollectable collectable{registry.Collect()};
+
+  MetricFamilyCollector collector;
+  collectable.Collect(collector);
+  auto streamed = collector.TakeFamilies();
+
+  ASSERT_EQ(streamed.size(), 3U);
+  EXPECT_EQ(streamed[0].name, "requests_total");
+  EXPECT_EQ(streamed[0].metric.size(), 2U);
+}
+
+TEST_F(MetricSinkTest, shouldSkipUnwantedFamilies) {
+  SelectingCollector collector{"temperature"};
+  registry.Collect(collector);
+  auto streamed = collector.TakeFamilies();
+
+  ASSERT_EQ(streamed.size(), 1U);
+  EXPECT_EQ(streamed[0].name, "temperature");
+  EXPECT_EQ(collector.asked_, 4);
+}
+
+TEST_F(MetricSinkTest, shouldWriteOnlyWantedFamilies) {
+  SelectingCollector collector{"latency"};
+  const Labels external_labels{{"instance", "a"}};
+  ExternalLabelsSink labeled{collector, external_labels};
+  WriteToSink(labeled, registry.Collect());
+  auto streamed = collector.TakeFamilies();
+
+  ASSERT_EQ(streamed.size(), 1U);
+  EXPECT_EQ(streamed[0].name, "latency");
+}
+
+TEST_F(MetricSinkTest, shouldCollectIntoArenaOfSink) {
+  MetricRecordArena arena;
+  MetricFamilyCollector collector;
+  collector.SetArena(&arena);
+  EXPECT_EQ(&collector.GetArena(), &arena);
+
+  registry.Collect(collector);
+  const auto* labels = arena.label.data();
+  const auto* buckets = arena.bucket.data();
+  EXPECT_NE(labels, nullptr);
+  EXPECT_NE(buckets, nullptr);
+
+  // a second collection reuses the memory of the first one
+  registry.Collect(collector);
+  EXPECT_EQ(arena.label.data(), labels);
+  EXPECT_EQ(arena.bucket.data(), buckets);
+
+  collector.SetArena(nullptr);
+  EXPECT_NE(&collector.GetArena(), &arena);
+}
+
+TEST_F(MetricSinkTest, shouldAddExternalLabels) {
+  const Labels external_labels{{"component", "other"}, {"instance", "a"}};
+  const TextSerializer serializer;
+
+  std::ostringstream streamed;
+  {
+    auto text_sink = serializer.MakeSink(streamed);
+    ExternalLabelsSink sink{*text_sink, external_labels};
+    registry.Collect(sink);
+  }
+
+  // the constant label of the family wins
+  EXPECT_THAT(streamed.str(),
+              testing::HasSubstr(
+                  "requests_total{component=\"test\",instance=\"a\","
+                  "status=\"200\"} 3\n"));
+  EXPECT_THAT(streamed.str(),
+              testing::HasSubstr(
+                  "temperature{component=\"other\",instance=\"a\"} 21.5\n"));
+  EXPECT_THAT(streamed.str(),
+              testing::HasSubstr("latency_bucket{component=\"other\","
+                                 "instance=\"a\",le=\"1\"} 0\n"));
+}
+
+TEST_F(MetricSinkTest, metricLabelsShouldWinOverExternalLabels) {
+  const Labels external_labels{{"status", "none"}};
+
+  MetricFamilyCollector collector;
+  {
+    ExternalLabelsSink sink{collector, external_labels};
+    registry.Collect(sink);
+  }
+  auto families = collector.TakeFamilies();
+
+  ASSERT_EQ(families.size(), 3U);
+  for (const auto& metric : families[0].metric) {
+    ASSERT_EQ(metric.label.size(), 1U);
+    EXPECT_NE(metric.label[0].value, "none");
+  }
+  EXPECT_THAT(families[1].metric[0].label,
+              testing::ElementsAre(ClientMetric::Label{"status", "none"}));
+}
+
+TEST_F(MetricSinkTest, textSinkShouldMatchTextSerializer) {
+  const TextSerializer serializer;
+
+  std::ostringstream streamed;
+  registry.Collect(*serializer.MakeSink(streamed));
+
+  EXPECT_EQ(streamed.str(), serializer.Serialize(registry.Collect()));
+}
+
+TEST_F(MetricSinkTest, defaultSinkShouldSerializeFamilyByFamily) {
+  const FamilyNameSerializer serializer;
+
+  std::ostringstream streamed;
+  registry.Collect(*serializer.MakeSink(streamed));
+
+  EXPECT_EQ(streamed.str(), "requests_total:2\ntemperature:1\nlatency:1\n");
+}
+
+}  // namespace
+}  // namespace prometheus
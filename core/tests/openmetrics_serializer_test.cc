@@ -0,0 +1,163 @@
+#include "prometheus/openmetrics_serializer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "prometheus/client_metric.h"
+#include "prometheus/counter.h"
+#include "prometheus/family.h"
+#include "prometheus/histogram.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_type.h"
+#include "prometheus/registry.h"
+
+namespace prometheus {
+namespace {
+
+class OpenMetricsSerializerTest : public testing::Test {
+ public:
+  std::string Serialize(MetricType type) const {
+    MetricFamily family;
+    family.name = name;
+    family.help = help;
+    family.unit = unit;
+    family.type = type;
+    family.metric = std::vector<ClientMetric>{metric};
+
+    return serializer.Serialize(std::vector<MetricFamily>{family});
+  }
+
+  std::string name = "my_metric";
+  std::string help;
+  std::string unit;
+  ClientMetric metric;
+  OpenMetricsSerializer serializer;
+};
+
+TEST_F(OpenMetricsSerializerTest, shouldSerializeCounter) {
+  name = "requests_total";
+  help = "number of \"requests\"";
+  metric.label.resize(1, ClientMetric::Label{"status", "200"});
+  metric.counter.value = 3;
+  metric.created_timestamp_ms = 1500;
+
+  auto exemplar = std::make_shared<ClientMetric::Exemplar>();
+  exemplar->label.resize(1, ClientMetric::Label{"trace_id", "abc"});
+  exemplar->value = 2;
+  exemplar->timestamp_ms = 1520879607789;
+  metric.counter.exemplar = exemplar;
+
+  EXPECT_EQ(Serialize(MetricType::Counter),
+            "# TYPE requests counter\n"
+            "# HELP requests number of \\\"requests\\\"\n"
+            "requests_total{status=\"200\"} 3 "
+            "# {trace_id=\"abc\"} 2 1520879607.789\n"
+            "requests_created{status=\"200\"} 1.5\n"
+            "# EOF\n");
+}
+
+TEST_F(OpenMetricsSerializerTest, shouldSerializeHistogram) {
+  name = "latency_seconds";
+  unit = "seconds";
+  Histogram histogram{{1, 2.5}};
+  histogram.Observe(0.5);
+  histogram.Observe(2, {{"trace_id", "abc"}});
+  metric = histogram.Collect();
+  metric.created_timestamp_ms = 0;
+  metric.histogram.bucket.at(1).exemplar = nullptr;
+
+  EXPECT_EQ(Serialize(MetricType::Histogram),
+            "# TYPE latency_seconds histogram\n"
+            "# UNIT latency_seconds seconds\n"
+            "latency_seconds_bucket{le=\"1.0\"} 1\n"
+            "latency_seconds_bucket{le=\"2.5\"} 2\n"
+            "latency_seconds_bucket{le=\"+Inf\"} 2\n"
+            "latency_seconds_count 2\n"
+            "latency_seconds_sum 2.5\n"
+            "# EOF\n");
+}
+
+TEST_F(OpenMetricsSerializerTest, shouldAttachExemplarToBucket) {
+  Histogram histogram{{1}};
+  histogram.Observe(0.25, {{"trace_id", "abc"}});
+  metric = histogram.Collect();
+
+  EXPECT_THAT(Serialize(MetricType::Histogram),
+              testing::HasSubstr("my_metric_bucket{le=\"1.0\"} 1 "
+                                 "# {trace_id=\"abc\"} 0.25 "));
+}
+
+TEST_F(OpenMetricsSerializerTest, shouldSerializeSummary) {
+  metric.summary.sample_count = 2;
+  metric.summary.sample_sum = 5;
+  metric.summary.quantile.resize(1);
+  metric.summary.quantile[0].quantile = 1;
+  metric.summary.quantile[0].value = 4;
+  metric.timestamp_ms = 2000;
+
+  EXPECT_EQ(Serialize(MetricType::Summary),
+            "# TYPE my_metric summary\n"
+            "my_metric{quantile=\"1.0\"} 4 2\n"
+            "my_metric_sum 5 2\n"
+            "my_metric_count 2 2\n"
+            "# EOF\n");
+}
+
+TEST_F(OpenMetricsSerializerTest, shouldSerializeInfoAndUnknown) {
+  metric.info.value = 1;
+  EXPECT_EQ(Serialize(MetricType::Info),
+            "# TYPE my_metric info\nmy_metric_info 1\n# EOF\n");
+
+  metric.untyped.value = 1;
+  EXPECT_EQ(Serialize(MetricType::Untyped),
+            "# TYPE my_metric unknown\nmy_metric 1\n# EOF\n");
+}
+
+TEST_F(OpenMetricsSerializerTest, sinkShouldMatchListBasedSerialize) {
+  Registry registry;
+  auto& counters = BuildCounter()
+                       .Name("requests_total")
+                       .Help("counts requests")
+                       .Labels({{"component", "test"}})
+                       .Register(registry);
+  counters.Add({{"status", "200"}}).Increment(3, {{"trace_id", "abc"}});
+  BuildHistogram()
+      .Name("latency_seconds")
+      .Unit("seconds")
+      .Register(registry)
+      .Add({}, Histogram::BucketBoundaries{1, 2})
+      .Observe(1.5, {{"trace_id", "def"}});
+
+  std::ostringstream streamed;
+  {
+    auto sink = serializer.MakeSink(streamed);
+    registry.Collect(*sink);
+    sink->Finish();
+  }
+
+  EXPECT_EQ(streamed.str(), serializer.Serialize(registry.Collect()));
+  EXPECT_THAT(streamed.str(), testing::EndsWith("# EOF\n"));
+}
+
+TEST_F(OpenMetricsSerializerTest, unfinishedSinkShouldNotWriteEof) {
+  Registry registry;
+  BuildCounter()
+      .Name("requests_total")
+      .Register(registry)
+      .Add({{"status", "200"}})
+      .Increment();
+
+  std::ostringstream streamed;
+  registry.Collect(*serializer.MakeSink(streamed));
+
+  EXPECT_THAT(streamed.str(), testing::HasSubstr("requests_total{"));
+  EXPECT_THAT(streamed.str(), testing::Not(testing::HasSubstr("# EOF")));
+}
+
+}  // namespace
+}  // namespace prometheus
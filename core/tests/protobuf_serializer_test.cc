@@ -0,0 +1,182 @@
+#include "prometheus/protobuf_serializer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "prometheus/client_metric.h"
+#include "prometheus/counter.h"
+#include "prometheus/family.h"
+#include "prometheus/histogram.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_type.h"
+#include "prometheus/registry.h"
+
+namespace prometheus {
+namespace {
+
+// Minimal reader for the protobuf wire format
+class Reader {
+ public:
+  explicit Reader(std::string data) : data_(std::move(data)) {}
+
+  bool AtEnd() const { return pos_ == data_.size(); }
+
+  std::uint64_t ReadVarint() {
+    std::uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+      const auto byte = static_cast<unsigned char>(data_.at(pos_++));
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+  }
+
+  // Returns the field number and checks the wire type
+  int ReadTag(int wire_type) {
+    const auto tag = ReadVarint();
+    EXPECT_EQ(static_cast<int>(tag & 7), wire_type);
+    return static_cast<int>(tag >> 3);
+  }
+
+  std::string ReadBytes() {
+    const auto size = static_cast<std::size_t>(ReadVarint());
+    auto bytes = data_.substr(pos_, size);
+    pos_ += size;
+    return bytes;
+  }
+
+  double ReadDouble() {
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+      bits |= static_cast<std::uint64_t>(
+                  static_cast<unsigned char>(data_.at(pos_++)))
+              << (8 * i);
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+ private:
+  std::string data_;
+  std::size_t pos_ = 0;
+};
+
+class ProtobufSerializerTest : public testing::Test {
+ public:
+  std::string Serialize(MetricType type) const {
+    MetricFamily family;
+    family.name = name;
+    family.type = type;
+    family.metric = std::vector<ClientMetric>{metric};
+
+    return serializer.Serialize(std::vector<MetricFamily>{family});
+  }
+
+  const std::string name = "a";
+  ClientMetric metric;
+  ProtobufSerializer serializer;
+};
+
+TEST_F(ProtobufSerializerTest, shouldEncodeCounter) {
+  metric.label.resize(1, ClientMetric::Label{"k", "v"});
+  metric.counter.value = 1.0;
+
+  const char expected[] =
+      "\x1A"                                           // family length
+      "\x0A\x01\x61"                                   // name
+      "\x18\x00"                                       // type
+      "\x22\x13"                                       // metric
+      "\x0A\x06\x0A\x01k\x12\x01v"                     // label
+      "\x1A\x09\x09\x00\x00\x00\x00\x00\x00\xF0\x3F";  // counter
+
+  EXPECT_EQ(Serialize(MetricType::Counter),
+            std::string(expected, sizeof(expected) - 1));
+}
+
+TEST_F(ProtobufSerializerTest, shouldEncodeHistogram) {
+  Histogram histogram{{1}};
+  histogram.Observe(0);
+  histogram.Observe(200);
+  metric = histogram.Collect();
+  metric.timestamp_ms = -1;
+
+  Reader stream{Serialize(MetricType::Histogram)};
+  Reader family{stream.ReadBytes()};
+  EXPECT_TRUE(stream.AtEnd());
+
+  EXPECT_EQ(family.ReadTag(2), 1);
+  EXPECT_EQ(family.ReadBytes(), name);
+  EXPECT_EQ(family.ReadTag(0), 3);
+  EXPECT_EQ(family.ReadVarint(), 4U);
+  EXPECT_EQ(family.ReadTag(2), 4);
+  Reader metric{family.ReadBytes()};
+  EXPECT_TRUE(family.AtEnd());
+
+  EXPECT_EQ(metric.ReadTag(2), 7);
+  Reader hist{metric.ReadBytes()};
+  EXPECT_EQ(metric.ReadTag(0), 6);
+  EXPECT_EQ(static_cast<std::int64_t>(metric.ReadVarint()), -1);
+  EXPECT_TRUE(metric.AtEnd());
+
+  EXPECT_EQ(hist.ReadTag(0), 1);
+  EXPECT_EQ(hist.ReadVarint(), 2U);
+  EXPECT_EQ(hist.ReadTag(1), 2);
+  EXPECT_EQ(hist.ReadDouble(), 200.0);
+
+  const std::uint64_t counts[] = {1, 2};
+  const double bounds[] = {1, std::numeric_limits<double>::infinity()};
+  for (std::size_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(hist.ReadTag(2), 3);
+    Reader bucket{hist.ReadBytes()};
+    EXPECT_EQ(bucket.ReadTag(0), 1);
+    EXPECT_EQ(bucket.ReadVarint(), counts[i]);
+    EXPECT_EQ(bucket.ReadTag(1), 2);
+    EXPECT_EQ(bucket.ReadDouble(), bounds[i]);
+    EXPECT_TRUE(bucket.AtEnd());
+  }
+  EXPECT_TRUE(hist.AtEnd());
+}
+
+TEST_F(ProtobufSerializerTest, shouldAddSuffixToInfo) {
+  Reader stream{Serialize(MetricType::Info)};
+  Reader family{stream.ReadBytes()};
+
+  EXPECT_EQ(family.ReadTag(2), 1);
+  EXPECT_EQ(family.ReadBytes(), name + "_info");
+  EXPECT_EQ(family.ReadTag(0), 3);
+  EXPECT_EQ(family.ReadVarint(), 1U);
+}
+
+TEST_F(ProtobufSerializerTest, sinkShouldMatchListBasedSerialize) {
+  Registry registry;
+  auto& counters = BuildCounter()
+                       .Name("requests_total")
+                       .Help("counts requests")
+                       .Labels({{"component", "test"}})
+                       .Register(registry);
+  counters.Add({{"status", "200"}}).Increment(3);
+  BuildHistogram()
+      .Name("latency")
+      .Register(registry)
+      .Add({}, Histogram::BucketBoundaries{1, 2})
+      .Observe(1.5);
+
+  std::ostringstream streamed;
+  registry.Collect(*serializer.MakeSink(streamed));
+
+  EXPECT_EQ(streamed.str(), serializer.Serialize(registry.Collect()));
+}
+
+}  // namespace
+}  // namespace prometheus
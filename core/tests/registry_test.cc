@@ -9,6 +9,7 @@
 #include "prometheus/gauge.h"
 #include "prometheus/histogram.h"
 #include "prometheus/info.h"
+#include "prometheus/metric_sink.h"
 #include "prometheus/summary.h"
 
 namespace prometheus {
@@ -42,6 +43,50 @@ TEST(RegistryTest, build_histogram_family) {
   ASSERT_EQ(collected.size(), 1U);
 }
 
+// Removes a family while the registry is collected, which would deadlock
+// if the registry were still locked
+class RemovingCollector : public MetricFamilyCollector {
+ public:
+  RemovingCollector(Registry& registry, const Family<Histogram>& family)
+      : registry_(registry), family_(&family) {}
+
+  void BeginFamily(const MetricFamily& family) override {
+    if (family_) {
+      EXPECT_TRUE(registry_.Remove(*family_));
+      family_ = nullptr;
+    }
+    MetricFamilyCollector::BeginFamily(family);
+  }
+
+ private:
+  Registry& registry_;
+  const Family<Histogram>* family_;
+};
+
+TEST(RegistryTest, should_not_lock_while_sink_runs) {
+  Registry registry{};
+  auto& counter_family =
+      BuildCounter().Name("test").Help("a test").Register(registry);
+  counter_family.Add({{"name", "counter1"}}).Increment();
+  auto& histogram_family =
+      BuildHistogram().Name("hist").Help("Test Histogram").Register(registry);
+  histogram_family.Add({{"name", "test_histogram_1"}},
+                       Histogram::BucketBoundaries{0, 1, 2});
+  RemovingCollector collector{registry, histogram_family};
+
+  registry.Collect(collector);
+
+  const auto collected = collector.TakeFamilies();
+  ASSERT_EQ(collected.size(), 2U);
+  ASSERT_EQ(collected[0].metric.size(), 1U);
+  EXPECT_EQ(collected[0].metric[0].label.at(0).value, "counter1");
+  EXPECT_EQ(collected[0].metric[0].counter.value, 1);
+  ASSERT_EQ(collected[1].metric.size(), 1U);
+  EXPECT_EQ(collected[1].metric[0].label.at(0).value, "test_histogram_1");
+  EXPECT_EQ(collected[1].metric[0].histogram.bucket.size(), 4U);
+  EXPECT_EQ(registry.Collect().size(), 1U);
+}
+
 TEST(RegistryTest, unable_to_remove_family) {
   Family<Counter> family{"name", "help", {}};
   Registry registry{};
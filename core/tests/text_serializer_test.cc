@@ -4,13 +4,18 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <cstdint>
 #include <limits>
+#include <locale>
+#include <sstream>
 #include <string>
+#include <utility>
 
 #include "prometheus/client_metric.h"
 #include "prometheus/histogram.h"
 #include "prometheus/info.h"
 #include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
 #include "prometheus/metric_type.h"
 #include "prometheus/summary.h"
 
@@ -24,6 +29,7 @@ class TextSerializerTest : public testing::Test {
     metricFamily.name = name;
     metricFamily.help = "my metric help text";
     metricFamily.type = type;
+    metricFamily.constant_label = constant_label;
     metricFamily.metric = std::vector<ClientMetric>{metric};
 
     std::vector<MetricFamily> families{metricFamily};
@@ -32,6 +38,7 @@ class TextSerializerTest : public testing::Test {
   }
 
   const std::string name = "my_metric";
+  std::vector<ClientMetric::Label> constant_label;
   ClientMetric metric;
   TextSerializer textSerializer;
 };
@@ -51,6 +58,48 @@ TEST_F(TextSerializerTest, shouldSerializePositiveInfinity) {
   EXPECT_THAT(Serialize(MetricType::Gauge), testing::HasSubstr(name + " +Inf"));
 }
 
+TEST_F(TextSerializerTest, shouldSerializeShortestRoundTrip) {
+  const std::pair<double, std::string> values[] = {
+      {0.1, "0.1"},
+      {0.1 + 0.2, "0.30000000000000004"},
+      {-2.5, "-2.5"},
+      {-0.0, "-0"},
+      {123456789.0, "123456789"},
+      {1e20, "1e+20"},
+      {1.5e-7, "1.5e-07"},
+  };
+
+  for (const auto& value : values) {
+    metric.gauge.value = value.first;
+    EXPECT_THAT(Serialize(MetricType::Gauge),
+                testing::HasSubstr(name + " " + value.second + "\n"));
+  }
+}
+
+TEST_F(TextSerializerTest, shouldParseBackToSameDouble) {
+  for (double value = 1e-10; value < 1e30; value *= 3.3) {
+    for (double sign : {1.0, -1.0}) {
+      metric.gauge.value = sign * value;
+      const auto serialized = Serialize(MetricType::Gauge);
+
+      std::istringstream in{serialized.substr(serialized.rfind(' ') + 1)};
+      in.imbue(std::locale::classic());
+      double parsed = 0.0;
+      in >> parsed;
+      EXPECT_EQ(parsed, sign * value);
+    }
+  }
+}
+
+TEST_F(TextSerializerTest, shouldSerializeLargeCounts) {
+  metric.histogram.sample_count = std::numeric_limits<std::uint64_t>::max();
+  metric.timestamp_ms = std::numeric_limits<std::int64_t>::min();
+
+  EXPECT_THAT(Serialize(MetricType::Histogram),
+              testing::HasSubstr(name + "_count 18446744073709551615 "
+                                        "-9223372036854775808\n"));
+}
+
 TEST_F(TextSerializerTest, shouldEscapeBackslash) {
   metric.label.resize(1, ClientMetric::Label{"k", "v\\v"});
   EXPECT_THAT(Serialize(MetricType::Gauge),
@@ -69,6 +118,13 @@ TEST_F(TextSerializerTest, shouldEscapeDoubleQuote) {
               testing::HasSubstr(name + "{k=\"v\\\"v\"}"));
 }
 
+TEST_F(TextSerializerTest, shouldPutConstantLabelsFirst) {
+  metric.label.resize(1, ClientMetric::Label{"k", "v"});
+  constant_label.resize(1, ClientMetric::Label{"c", "w"});
+  EXPECT_THAT(Serialize(MetricType::Gauge),
+              testing::HasSubstr(name + "{c=\"w\",k=\"v\"}"));
+}
+
 TEST_F(TextSerializerTest, shouldSerializeUntyped) {
   metric.untyped.value = 64.0;
 
@@ -128,5 +184,31 @@ TEST_F(TextSerializerTest, shouldSerializeSummary) {
   EXPECT_THAT(serialized, testing::HasSubstr(name + "{quantile=\"0.5\"} 0\n"));
 }
 
+TEST_F(TextSerializerTest, shouldSerializeRecordFromSink) {
+  const std::string label_name = "k";
+  const std::string label_value = "v";
+  const MetricRecord::LabelRef labels[] = {{&label_name, &label_value}};
+
+  MetricFamily family;
+  family.name = name;
+  family.type = MetricType::Counter;
+
+  MetricRecord record;
+  record.label = labels;
+  record.label_count = 1;
+  record.value = 64.0;
+
+  std::ostringstream out;
+  {
+    auto sink = textSerializer.MakeSink(out);
+    sink->BeginFamily(family);
+    sink->AddMetric(record);
+    sink->EndFamily();
+  }
+
+  EXPECT_EQ(out.str(), "# TYPE " + name + " counter\n" + name +
+                           "{k=\"v\"} 64\n");
+}
+
 }  // namespace
 }  // namespace prometheus
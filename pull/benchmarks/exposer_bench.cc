@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "prometheus/counter.h"
+#include "prometheus/exposer.h"
+#include "prometheus/family.h"
+#include "prometheus/registry.h"
+
+namespace {
+
+std::size_t Discard(void*, std::size_t size, std::size_t nmemb, void*) {
+  return size * nmemb;
+}
+
+// Scrapes over a single kept-alive connection, like Prometheus does, and
+// reports the requests per second and the 99th percentile latency
+void ScrapeExposer(benchmark::State& state,
+                   prometheus::ExposerBackend backend) {
+  prometheus::Exposer exposer{"127.0.0.1:0", backend};
+  auto registry = std::make_shared<prometheus::Registry>();
+  auto& family =
+      prometheus::BuildCounter().Name("requests_total").Register(*registry);
+  for (auto i = 0; i < state.range(0); ++i) {
+    family.Add({{"id", std::to_string(i)}}).Increment();
+  }
+  exposer.RegisterCollectable(registry);
+
+  const auto url = "http://127.0.0.1:" +
+                   std::to_string(exposer.GetListeningPorts().at(0)) +
+                   "/metrics";
+  auto curl = std::shared_ptr<CURL>(curl_easy_init(), curl_easy_cleanup);
+  if (!curl) {
+    throw std::runtime_error("failed to initialize libcurl");
+  }
+  curl_easy_setopt(curl.get(), CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, Discard);
+
+  std::vector<double> latencies;
+  while (state.KeepRunning()) {
+    const auto start = std::chrono::steady_clock::now();
+    if (curl_easy_perform(curl.get()) != CURLE_OK) {
+      state.SkipWithError("failed to perform HTTP request");
+      break;
+    }
+    latencies.push_back(std::chrono::duration<double, std::micro>{
+        std::chrono::steady_clock::now() - start}
+                            .count());
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(latencies.size()));
+  if (!latencies.empty()) {
+    auto p99 = latencies.begin() + latencies.size() * 99 / 100;
+    std::nth_element(latencies.begin(), p99, latencies.end());
+    state.counters["p99_us"] = *p99;
+  }
+}
+
+}  // namespace
+
+static void BM_Exposer_Civetweb(benchmark::State& state) {
+  ScrapeExposer(state, prometheus::ExposerBackend::Civetweb);
+}
+BENCHMARK(BM_Exposer_Civetweb)->Range(1, 4096);
+
+#ifdef __linux__
+static void BM_Exposer_Epoll(benchmark::State& state) {
+  ScrapeExposer(state, prometheus::ExposerBackend::Epoll);
+}
+BENCHMARK(BM_Exposer_Epoll)->Range(1, 4096);
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace prometheus {
+
+/// \brief Settings for compressing scrape responses.
+///
+/// Responses are compressed with zstd or gzip if the scraper accepts it and
+/// support was enabled at build time (ENABLE_ZSTD, ENABLE_COMPRESSION). zstd
+/// is preferred if the scraper accepts both equally. The gzip settings are
+/// passed on to zlib's deflateInit2().
+struct CompressionOptions {
+  /// gzip compression level from 1 (fastest) to 9 (smallest output), -1 for
+  /// the zlib default of 6. 0 disables compression altogether.
+  int level = -1;
+
+  /// Memory used for the gzip compression state from 1 (least memory) to 9
+  /// (fastest).
+  int memory_level = 9;
+
+  /// gzip strategy: 0 (default), 1 (filtered), 2 (Huffman only),
+  /// 3 (run-length encoding) or 4 (fixed Huffman codes).
+  int strategy = 0;
+
+  /// zstd compression level from 1 (fastest) to 19 (smallest output), 0 for
+  /// the zstd default of 3.
+  int zstd_level = 0;
+
+  /// Responses smaller than this many bytes are sent uncompressed.
+  std::size_t min_size = 0;
+};
+
+}  // namespace prometheus
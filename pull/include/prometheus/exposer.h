@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <memory>
@@ -8,7 +9,12 @@
 #include <vector>
 
 #include "prometheus/collectable.h"
+#include "prometheus/collection_executor.h"
+#include "prometheus/compression_options.h"
 #include "prometheus/detail/pull_export.h"
+#include "prometheus/labels.h"
+#include "prometheus/scrape_handler.h"
+#include "prometheus/serializer.h"
 
 class CivetServer;
 struct CivetCallbacks;
@@ -17,8 +23,20 @@ namespace prometheus {
 
 namespace detail {
 class Endpoint;
+class HttpServer;
 }  // namespace detail
 
+/// \brief HTTP server an Exposer serves its endpoints with.
+enum class ExposerBackend {
+  /// civetweb with a thread per concurrent request.
+  Civetweb,
+  /// Minimal HTTP/1.1 server handling all connections on a single thread
+  /// with epoll, only available on Linux. It keeps connections alive and
+  /// sends each response with few system calls, but scrapes of all
+  /// endpoints are served one after the other.
+  Epoll,
+};
+
 class PROMETHEUS_CPP_PULL_EXPORT Exposer {
  public:
   explicit Exposer(std::shared_ptr<CivetServer> server);
@@ -26,6 +44,24 @@ class PROMETHEUS_CPP_PULL_EXPORT Exposer {
                    const CivetCallbacks* callbacks = nullptr);
   explicit Exposer(std::vector<std::string> options,
                    const CivetCallbacks* callbacks = nullptr);
+
+  /// \brief Serves on bind_address with the given backend.
+  ///
+  /// bind_address has the format of civetweb's listening_ports option,
+  /// e.g., "127.0.0.1:8080". The epoll backend also listens on Unix domain
+  /// sockets, "unix:/path/to/socket" or "unix:@name" for the abstract
+  /// namespace, which spares local scrapers the TCP stack and ports. A
+  /// socket file left behind by an earlier process is replaced, one
+  /// another process still listens on is not. Throws std::runtime_error if
+  /// the backend is not available on this platform or cannot listen on
+  /// bind_address.
+  ///
+  /// \param executor Serves the scrapes of the epoll backend, e.g., a thread
+  /// pool or the executor of an asio or libuv application. Scrapes run on
+  /// four threads of the server if there is none, never on its I/O thread.
+  /// Not used by civetweb, which serves every request on its own threads.
+  Exposer(const std::string& bind_address, ExposerBackend backend,
+          ScrapeHandler::Executor executor = nullptr);
   ~Exposer();
 
   Exposer(const Exposer&) = delete;
@@ -33,8 +69,12 @@ class PROMETHEUS_CPP_PULL_EXPORT Exposer {
   Exposer& operator=(const Exposer&) = delete;
   Exposer& operator=(Exposer&&) = delete;
 
+  /// \param name Names the collectable in the profile of scrapes, see
+  /// ProfileScrapes(). Collectables without a name are not profiled
+  /// individually.
   void RegisterCollectable(const std::weak_ptr<Collectable>& collectable,
-                           const std::string& uri = std::string("/metrics"));
+                           const std::string& uri = std::string("/metrics"),
+                           const std::string& name = std::string());
 
   void RegisterAuth(
       std::function<bool(const std::string&, const std::string&)> authCB,
@@ -44,12 +84,122 @@ class PROMETHEUS_CPP_PULL_EXPORT Exposer {
   void RemoveCollectable(const std::weak_ptr<Collectable>& collectable,
                          const std::string& uri = std::string("/metrics"));
 
+  /// \brief Adds labels to every metric exposed on the given endpoint.
+  ///
+  /// Labels already set by a metric family or a metric take precedence.
+  void SetExternalLabels(const Labels& labels,
+                         const std::string& uri = std::string("/metrics"));
+
+  /// \brief Offers an additional exposition format on the given endpoint.
+  ///
+  /// The format of each scrape is negotiated with its Accept header, q-values
+  /// included. The text, protobuf and OpenMetrics formats are offered by
+  /// default and preferred in this order if the scraper accepts several
+  /// formats equally. Registered formats are preferred over the built-in ones
+  /// and replace a built-in format with the same content type.
+  ///
+  /// \param content_type Content type of the format, e.g.,
+  /// "text/plain; version=0.0.4; charset=utf-8".
+  void RegisterSerializer(std::shared_ptr<const Serializer> serializer,
+                          const std::string& content_type,
+                          const std::string& uri = std::string("/metrics"));
+
+  /// \brief Sets how responses of the given endpoint are compressed.
+  ///
+  /// Lower levels trade a larger response for less CPU time per scrape.
+  void SetCompressionOptions(const CompressionOptions& options,
+                             const std::string& uri = std::string("/metrics"));
+
+  /// \brief Lets scrapes of the given endpoint share their responses.
+  ///
+  /// Concurrent scrapes asking for the same format and encoding wait for the
+  /// first of them instead of collecting the metrics again. Its response is
+  /// also served to scrapes arriving up to max_age later. Shared responses
+  /// are held in memory as a whole instead of being streamed. Scrapes
+  /// selecting families by name are not shared, they always collect.
+  void ShareResponses(std::chrono::milliseconds max_age,
+                      const std::string& uri = std::string("/metrics"));
+
+  /// \brief Renders the responses of the given endpoint in the background.
+  ///
+  /// A background thread collects, serializes and compresses the metrics
+  /// every interval. Scrapes only send the latest rendering, so they take
+  /// constant time and collecting no longer depends on when scrapes arrive.
+  /// The response of a format and encoding is first rendered when it is
+  /// scraped and dropped once it has not been scraped for ten intervals.
+  /// Scrapes selecting families by name are not prerendered, they always
+  /// collect.
+  void PrerenderResponses(std::chrono::milliseconds interval,
+                          const std::string& uri = std::string("/metrics"));
+
+  /// \brief Limits how long the given endpoint waits for its collectables.
+  ///
+  /// Collectables are collected concurrently on four background threads
+  /// owned by the endpoint. One not done in time keeps collecting in the
+  /// background, the scrape uses its previous result instead or leaves it
+  /// out if there is none. A collectable is never collected twice at once,
+  /// so one that hangs occupies at most one thread. Scrapes by Prometheus
+  /// get at most three quarters of the scrape timeout it announces in the
+  /// X-Prometheus-Scrape-Timeout-Seconds header, the rest is left for
+  /// sending the response. exposer_late_collections_total counts late
+  /// collectables.
+  void SetCollectTimeout(std::chrono::milliseconds timeout,
+                         const std::string& uri = std::string("/metrics"));
+
+  /// \brief Measures where scrapes of the given endpoint spend their time.
+  ///
+  /// Records histograms of the time spent waiting for the lock, collecting,
+  /// serializing, compressing and writing, and of the time spent on each
+  /// collectable registered with a name. Collecting and serializing are
+  /// interleaved, so measuring them costs reading the clock for every
+  /// series. Profiling is off by default.
+  void ProfileScrapes(bool enabled,
+                      const std::string& uri = std::string("/metrics"));
+
+  /// \brief Profiles the given metric families of the endpoint individually.
+  ///
+  /// Records histograms of the time spent on each of the families and of
+  /// their number of series while ProfileScrapes() is enabled. Families are
+  /// only profiled if listed, so the number of series of the histograms
+  /// stays bounded.
+  void ProfileFamilies(const std::vector<std::string>& names,
+                       const std::string& uri = std::string("/metrics"));
+
+  /// \brief Limits the CPU time the given endpoint spends on collecting.
+  ///
+  /// At most max_collections scrapes collect at once, 0 for no limit, and
+  /// a collection starts at least min_interval after the previous one.
+  /// Scrapes within min_interval are served the last response of the same
+  /// format and encoding, so several Prometheus servers can scrape the
+  /// endpoint, at the cost of holding that response in memory. Filtered
+  /// scrapes, those without such a response and those exceeding
+  /// max_collections are answered with "429 Too Many Requests" or "503
+  /// Service Unavailable" without collecting, counted by
+  /// exposer_rejected_scrapes_total. Prerendered responses are always
+  /// served, and shared responses only need a collection once they are
+  /// older than the max_age of ShareResponses().
+  void LimitCollections(std::size_t max_collections,
+                        std::chrono::milliseconds min_interval,
+                        const std::string& uri = std::string("/metrics"));
+
+  /// \brief Renders the scrapes of the given endpoint on the executor.
+  ///
+  /// Collecting, serializing and compressing run on the executor, e.g.,
+  /// CollectionExecutor::AsExecutor() of threads pinned to housekeeping
+  /// cores with a low priority, instead of the server threads. The server
+  /// thread sends the response while it is rendered, holding at most 128 KiB
+  /// of it, so a slow client also holds up the executor. The epoll backend
+  /// runs its handlers on the executor passed to its constructor instead,
+  /// without waiting for them.
+  void SetCollectionExecutor(Executor executor,
+                             const std::string& uri = std::string("/metrics"));
+
   std::vector<int> GetListeningPorts() const;
 
  private:
   detail::Endpoint& GetEndpointForUri(const std::string& uri);
 
-  std::shared_ptr<CivetServer> server_;
+  std::unique_ptr<detail::HttpServer> server_;
   std::vector<std::unique_ptr<detail::Endpoint>> endpoints_;
   std::mutex mutex_;
 };
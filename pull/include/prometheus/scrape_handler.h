@@ -0,0 +1,216 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "prometheus/collectable.h"
+#include "prometheus/collection_executor.h"
+#include "prometheus/compression_options.h"
+#include "prometheus/counter.h"
+#include "prometheus/detail/pull_export.h"
+#include "prometheus/family.h"
+#include "prometheus/histogram.h"
+#include "prometheus/labels.h"
+#include "prometheus/registry.h"
+#include "prometheus/serializer.h"
+#include "prometheus/summary.h"
+
+namespace prometheus {
+
+namespace detail {
+class Prerenderer;
+class ScrapeArenaPool;
+class ScrapeProfile;
+}  // namespace detail
+
+/// \brief Serves scrapes independent of any HTTP server.
+///
+/// Negotiates the format and encoding of a scrape from its request headers,
+/// collects the registered collectables and serializes and compresses them
+/// into the response body. Lets an application expose its metrics with the
+/// HTTP server it already runs instead of an Exposer. Scrapes run on the
+/// calling thread and may run concurrently. Like an Exposer endpoint, the
+/// handler exposes metrics about its own scrapes.
+class PROMETHEUS_CPP_PULL_EXPORT ScrapeHandler {
+ public:
+  /// \brief Outcome of a scrape.
+  enum class Status {
+    /// the response was served
+    Ok,
+    /// rejected, the endpoint collected less than the minimum interval ago
+    /// and has no earlier response to serve for the request
+    TooFrequent,
+    /// rejected, the maximum number of collections is running
+    Overloaded,
+  };
+
+  /// \brief Request headers a scrape depends on, empty if not sent.
+  struct Request {
+    /// Accept header
+    std::string accept;
+    /// Accept-Encoding header
+    std::string accept_encoding;
+    /// X-Prometheus-Scrape-Timeout-Seconds header
+    std::string scrape_timeout_seconds;
+    /// query string of the URL without the "?", selects metric families
+    std::string query_string;
+  };
+
+  /// \brief Response of a scrape held in memory.
+  struct Response {
+    /// nothing else is set if the scrape was rejected
+    Status status = Status::Ok;
+    std::string content_type;
+    /// empty if the body is not compressed
+    std::string content_encoding;
+    std::string body;
+  };
+
+  /// \brief Receives a response while it is rendered.
+  class ResponseWriter {
+   public:
+    virtual ~ResponseWriter() = default;
+
+    /// \brief Starts the response, called once before the body.
+    ///
+    /// \param content_encoding Empty if the body is not compressed.
+    /// \param content_length Size of the whole body, nullptr if the body is
+    /// streamed before its size is known.
+    virtual void Begin(const std::string& content_type,
+                       const std::string& content_encoding,
+                       const std::size_t* content_length) = 0;
+
+    /// \brief Writes the next part of the body, returns false on errors.
+    virtual bool Write(const char* data, std::size_t size) = 0;
+  };
+
+  using Executor = prometheus::Executor;
+
+  ScrapeHandler();
+  ~ScrapeHandler();
+
+  ScrapeHandler(const ScrapeHandler&) = delete;
+  ScrapeHandler(ScrapeHandler&&) = delete;
+  ScrapeHandler& operator=(const ScrapeHandler&) = delete;
+  ScrapeHandler& operator=(ScrapeHandler&&) = delete;
+
+  /// \param name See Exposer::RegisterCollectable().
+  void RegisterCollectable(const std::weak_ptr<Collectable>& collectable,
+                           const std::string& name = std::string());
+  void RemoveCollectable(const std::weak_ptr<Collectable>& collectable);
+
+  /// \brief See Exposer::SetExternalLabels().
+  void SetExternalLabels(const Labels& labels);
+
+  /// \brief See Exposer::RegisterSerializer().
+  void RegisterSerializer(std::shared_ptr<const Serializer> serializer,
+                          const std::string& content_type);
+
+  /// \brief See Exposer::SetCompressionOptions().
+  void SetCompressionOptions(const CompressionOptions& options);
+
+  /// \brief See Exposer::ShareResponses().
+  void ShareResponses(std::chrono::milliseconds max_age);
+
+  /// \brief See Exposer::PrerenderResponses(), starts a background thread.
+  void PrerenderResponses(std::chrono::milliseconds interval);
+
+  /// \brief See Exposer::SetCollectTimeout(), collects on background
+  /// threads.
+  void SetCollectTimeout(std::chrono::milliseconds timeout);
+
+  /// \brief See Exposer::ProfileScrapes().
+  void ProfileScrapes(bool enabled);
+
+  /// \brief See Exposer::ProfileFamilies().
+  void ProfileFamilies(const std::vector<std::string>& names);
+
+  /// \brief See Exposer::LimitCollections().
+  void LimitCollections(std::size_t max_collections,
+                        std::chrono::milliseconds min_interval);
+
+  /// \brief Collects, serializes and compresses on the executor.
+  ///
+  /// Handle() renders the response on the executor, e.g., a
+  /// CollectionExecutor pinned to housekeeping cores, and writes it on the
+  /// calling thread while it is rendered. At most 128 KiB of it wait for the
+  /// calling thread, beyond that the executor waits as well, so a slow client
+  /// holds up one of its threads. nullptr renders on the calling thread
+  /// again.
+  void SetCollectionExecutor(Executor executor);
+
+  /// \brief Serves a scrape, streaming the response into the writer.
+  ///
+  /// The body is sent in chunks as soon as they are full, so neither the
+  /// samples nor the response are held in memory as a whole. Nothing is
+  /// written to a rejected scrape, the caller answers it, e.g., with
+  /// "429 Too Many Requests" or "503 Service Unavailable".
+  Status Handle(const Request& request, ResponseWriter& writer);
+
+  /// \brief Serves a scrape, returning the whole response.
+  Response Handle(const Request& request);
+
+  /// \brief Serves a scrape on the executor and passes the response to done.
+  ///
+  /// The scrape is rendered by the given executor, not by the one of
+  /// SetCollectionExecutor().
+  ///
+  /// Collecting, serializing and compressing run in the task handed to the
+  /// executor, so a large scrape never blocks the calling thread, e.g., the
+  /// I/O thread of an event loop. done is called by the task, the caller
+  /// posts the response back to its event loop if needed. The handler has
+  /// to outlive the task.
+  void HandleAsync(const Request& request, const Executor& executor,
+                   std::function<void(Response)> done);
+
+ private:
+  struct Settings;
+  using Collectables = std::vector<std::weak_ptr<Collectable>>;
+
+  std::shared_ptr<const Settings> GetSettings() const;
+  Status Serve(const Request& request, ResponseWriter& writer);
+  Response Serve(const Request& request);
+  void UpdateSettings(const std::function<void(Settings&)>& update);
+  void ResolveProfileHistograms(Settings& settings);
+  void RecordProfile(detail::ScrapeProfile& profile);
+
+  // serializes updates of the settings
+  std::mutex settings_mutex_;
+  // everything a scrape depends on, scrapes use the settings at their start
+  // and changes replace them with an updated copy, accessed with
+  // std::atomic_load() and std::atomic_store()
+  std::shared_ptr<const Settings> settings_;
+  // kept apart from the settings, so its rendering thread never holds the
+  // last reference to it, accessed like settings_
+  std::shared_ptr<detail::Prerenderer> prerenderer_;
+  std::unique_ptr<detail::ScrapeArenaPool> arena_pool_;
+  // "meta" metrics about the scrapes
+  std::shared_ptr<Registry> registry_;
+  Family<Counter>& bytes_transferred_family_;
+  Counter& bytes_transferred_;
+  Family<Counter>& num_scrapes_family_;
+  Counter& num_scrapes_;
+  Family<Summary>& request_latencies_family_;
+  Summary& request_latencies_;
+  Family<Counter>& shared_responses_family_;
+  Counter& shared_response_hits_;
+  Counter& shared_response_coalesced_;
+  Counter& shared_response_misses_;
+  Family<Counter>& late_collections_family_;
+  Counter& late_collections_reused_;
+  Counter& late_collections_dropped_;
+  Family<Counter>& rejected_scrapes_family_;
+  Counter& rejected_too_frequent_;
+  Counter& rejected_overloaded_;
+  Family<Histogram>& phase_durations_family_;
+  Family<Histogram>& collectable_durations_family_;
+  Family<Histogram>& family_durations_family_;
+  Family<Histogram>& family_series_family_;
+};
+
+}  // namespace prometheus
@@ -2,7 +2,6 @@
 
 #include <utility>
 
-#include "CivetServer.h"
 #include "prometheus/detail/base64.h"
 
 namespace prometheus {
@@ -10,16 +9,16 @@ namespace prometheus {
 BasicAuthHandler::BasicAuthHandler(AuthFunc callback, std::string realm)
     : callback_(std::move(callback)), realm_(std::move(realm)) {}
 
-bool BasicAuthHandler::authorize(CivetServer* server, mg_connection* conn) {
-  if (!AuthorizeInner(server, conn)) {
+bool BasicAuthHandler::Authorize(detail::HttpConnection& conn) {
+  if (!AuthorizeInner(conn)) {
     WriteUnauthorizedResponse(conn);
     return false;
   }
   return true;
 }
 
-bool BasicAuthHandler::AuthorizeInner(CivetServer*, mg_connection* conn) {
-  const char* authHeader = mg_get_header(conn, "Authorization");
+bool BasicAuthHandler::AuthorizeInner(const detail::HttpConnection& conn) {
+  const char* authHeader = conn.GetHeader("Authorization");
 
   if (authHeader == nullptr) {
     // No auth header was provided.
@@ -62,13 +61,14 @@ bool BasicAuthHandler::AuthorizeInner(CivetServer*, mg_connection* conn) {
   return callback_(username, password);
 }
 
-void BasicAuthHandler::WriteUnauthorizedResponse(mg_connection* conn) {
-  mg_printf(conn, "HTTP/1.1 401 Unauthorized\r\n");
-  mg_printf(conn, "WWW-Authenticate: Basic realm=\"%s\"\r\n", realm_.c_str());
-  mg_printf(conn, "Connection: close\r\n");
-  mg_printf(conn, "Content-Length: 0\r\n");
+void BasicAuthHandler::WriteUnauthorizedResponse(
+    detail::HttpConnection& conn) {
+  conn.Write("HTTP/1.1 401 Unauthorized\r\n");
+  conn.Write("WWW-Authenticate: Basic realm=\"" + realm_ + "\"\r\n");
+  conn.Write("Connection: close\r\n");
+  conn.Write("Content-Length: 0\r\n");
   // end headers
-  mg_printf(conn, "\r\n");
+  conn.Write("\r\n");
 }
 
 }  // namespace prometheus
@@ -3,21 +3,20 @@
 #include <functional>
 #include <string>
 
-#include "CivetServer.h"
-#include "civetweb.h"
+#include "detail/http_server.h"
 
 namespace prometheus {
 
 /**
  * Handler for HTTP Basic authentication for Endpoints.
  */
-class BasicAuthHandler : public CivetAuthHandler {
+class BasicAuthHandler : public detail::HttpAuthHandler {
  public:
   using AuthFunc = std::function<bool(const std::string&, const std::string&)>;
   explicit BasicAuthHandler(AuthFunc callback, std::string realm);
 
   /**
-   * Implements civetweb authorization interface.
+   * Implements the authorization interface of the HTTP server.
    *
    * Attempts to extract a username and password from the Authorization header
    * to pass to the owning AuthHandler, `this->handler`.
@@ -25,11 +24,11 @@ class BasicAuthHandler : public CivetAuthHandler {
    * If handler returns false, or the Auth header is absent,
    * rejects the request with 401 Unauthorized.
    */
-  bool authorize(CivetServer* server, mg_connection* conn) override;
+  bool Authorize(detail::HttpConnection& conn) override;
 
  private:
-  bool AuthorizeInner(CivetServer* server, mg_connection* conn);
-  void WriteUnauthorizedResponse(mg_connection* conn);
+  bool AuthorizeInner(const detail::HttpConnection& conn);
+  void WriteUnauthorizedResponse(detail::HttpConnection& conn);
 
   AuthFunc callback_;
   std::string realm_;
@@ -0,0 +1,113 @@
+#include "civet_server.h"
+
+#include <utility>
+
+#include "civetweb.h"
+#include "prometheus/detail/future_std.h"
+
+#if CIVETWEB_VERSION_MAJOR < 1 || \
+    (CIVETWEB_VERSION_MAJOR == 1 && CIVETWEB_VERSION_MINOR < 14)
+// https://github.com/civetweb/civetweb/issues/954
+#error "Civetweb version 1.14 or higher required"
+#endif
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+
+class CivetConnection : public HttpConnection {
+ public:
+  explicit CivetConnection(mg_connection* conn) : conn_(conn) {}
+
+  const char* GetHeader(const char* name) const override {
+    return mg_get_header(conn_, name);
+  }
+
+  const char* GetQueryString() const override {
+    auto request_info = mg_get_request_info(conn_);
+    return request_info ? request_info->query_string : nullptr;
+  }
+
+  const char* GetHttpVersion() const override {
+    auto request_info = mg_get_request_info(conn_);
+    return request_info ? request_info->http_version : nullptr;
+  }
+
+  bool Write(const char* data, std::size_t size) override {
+    return mg_write(conn_, data, size) >= 0;
+  }
+
+  bool WriteChunk(const char* data, std::size_t size) override {
+    return mg_send_chunk(conn_, data, static_cast<unsigned int>(size)) >= 0;
+  }
+
+ private:
+  mg_connection* conn_;
+};
+
+}  // namespace
+
+class CivetHttpServer::Handler : public CivetHandler {
+ public:
+  explicit Handler(HttpHandler& handler) : handler_(handler) {}
+
+  bool handleGet(CivetServer*, mg_connection* conn) override {
+    CivetConnection connection{conn};
+    return handler_.HandleGet(connection);
+  }
+
+ private:
+  HttpHandler& handler_;
+};
+
+class CivetHttpServer::AuthHandler : public CivetAuthHandler {
+ public:
+  explicit AuthHandler(HttpAuthHandler& handler) : handler_(handler) {}
+
+  bool authorize(CivetServer*, mg_connection* conn) override {
+    CivetConnection connection{conn};
+    return handler_.Authorize(connection);
+  }
+
+ private:
+  HttpAuthHandler& handler_;
+};
+
+CivetHttpServer::CivetHttpServer(std::shared_ptr<CivetServer> server)
+    : server_(std::move(server)) {}
+
+CivetHttpServer::~CivetHttpServer() = default;
+
+void CivetHttpServer::AddHandler(const std::string& uri,
+                                 HttpHandler& handler) {
+  auto adapter = detail::make_unique<Handler>(handler);
+  server_->addHandler(uri, adapter.get());
+  handlers_[uri] = std::move(adapter);
+}
+
+void CivetHttpServer::RemoveHandler(const std::string& uri) {
+  server_->removeHandler(uri);
+  handlers_.erase(uri);
+}
+
+void CivetHttpServer::AddAuthHandler(const std::string& uri,
+                                     HttpAuthHandler& handler) {
+  auto adapter = detail::make_unique<AuthHandler>(handler);
+  server_->addAuthHandler(uri, adapter.get());
+  auth_handlers_[uri] = std::move(adapter);
+}
+
+void CivetHttpServer::RemoveAuthHandler(const std::string& uri) {
+  server_->removeAuthHandler(uri);
+  auth_handlers_.erase(uri);
+}
+
+std::vector<int> CivetHttpServer::GetListeningPorts() const {
+  return server_->getListeningPorts();
+}
+
+void CivetHttpServer::Close() { server_->close(); }
+
+}  // namespace detail
+}  // namespace prometheus
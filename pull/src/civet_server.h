@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CivetServer.h"
+#include "detail/http_server.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Serves the endpoints of an Exposer with civetweb.
+class CivetHttpServer : public HttpServer {
+ public:
+  explicit CivetHttpServer(std::shared_ptr<CivetServer> server);
+  ~CivetHttpServer() override;
+
+  void AddHandler(const std::string& uri, HttpHandler& handler) override;
+  void RemoveHandler(const std::string& uri) override;
+  void AddAuthHandler(const std::string& uri,
+                      HttpAuthHandler& handler) override;
+  void RemoveAuthHandler(const std::string& uri) override;
+
+  std::vector<int> GetListeningPorts() const override;
+  void Close() override;
+
+ private:
+  class Handler;
+  class AuthHandler;
+
+  std::shared_ptr<CivetServer> server_;
+  // civetweb only references its handlers
+  std::map<std::string, std::unique_ptr<Handler>> handlers_;
+  std::map<std::string, std::unique_ptr<AuthHandler>> auth_handlers_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,73 @@
+#include "chunk_stream_buffer.h"
+
+#include <cstring>
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+ChunkStreamBuffer::ChunkStreamBuffer(ChunkWriter writer,
+                                     std::vector<char>& buffer)
+    : writer_(std::move(writer)), buffer_(buffer) {
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+bool ChunkStreamBuffer::Flush() {
+  if (pptr() != pbase()) {
+    Write(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+  }
+  return !failed_;
+}
+
+void ChunkStreamBuffer::Write(const char* data, std::size_t size) {
+  if (!failed_) {
+    failed_ = !writer_(data, size);
+    bytes_written_ += size;
+  }
+}
+
+ChunkStreamBuffer::int_type ChunkStreamBuffer::overflow(int_type ch) {
+  if (!Flush()) {
+    return traits_type::eof();
+  }
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    if (pptr() == epptr()) {
+      // no buffer at all, write the character on its own
+      const auto c = traits_type::to_char_type(ch);
+      Write(&c, 1);
+    } else {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+  }
+  return failed_ ? traits_type::eof() : traits_type::not_eof(ch);
+}
+
+std::streamsize ChunkStreamBuffer::xsputn(const char_type* s,
+                                          std::streamsize count) {
+  auto size = static_cast<std::size_t>(count);
+  const auto space = static_cast<std::size_t>(epptr() - pptr());
+  if (size > space) {
+    // complete the current chunk first
+    std::memcpy(pptr(), s, space);
+    pbump(static_cast<int>(space));
+    s += space;
+    size -= space;
+    Flush();
+
+    if (size >= buffer_.size()) {
+      // too large to be buffered, pass it on as chunk of its own
+      Write(s, size);
+      return failed_ ? 0 : count;
+    }
+  }
+  std::memcpy(pptr(), s, size);
+  pbump(static_cast<int>(size));
+  return failed_ ? 0 : count;
+}
+
+int ChunkStreamBuffer::sync() { return Flush() ? 0 : -1; }
+
+}  // namespace detail
+}  // namespace prometheus
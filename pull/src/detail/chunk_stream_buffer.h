@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <streambuf>
+#include <vector>
+
+#include "prometheus/detail/pull_export.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Stream buffer passing its content on in chunks of a fixed size.
+///
+/// Only a single chunk is held in memory, so the memory needed to write a
+/// response does not depend on its size. Once a chunk could not be written,
+/// everything else is discarded and the stream reports an error.
+class PROMETHEUS_CPP_PULL_EXPORT ChunkStreamBuffer : public std::streambuf {
+ public:
+  /// \brief Writes a chunk, returns false on errors.
+  using ChunkWriter = std::function<bool(const char* data, std::size_t size)>;
+
+  /// \param writer Receives the chunks.
+  /// \param buffer Memory to collect a chunk in, its size is the chunk size.
+  ChunkStreamBuffer(ChunkWriter writer, std::vector<char>& buffer);
+
+  ChunkStreamBuffer(const ChunkStreamBuffer&) = delete;
+  ChunkStreamBuffer& operator=(const ChunkStreamBuffer&) = delete;
+
+  /// \brief Passes on the buffered data.
+  ///
+  /// \return False if any chunk could not be written.
+  bool Flush();
+
+  /// \brief Returns the number of bytes passed on to the writer.
+  std::size_t BytesWritten() const { return bytes_written_; }
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+  int sync() override;
+
+ private:
+  void Write(const char* data, std::size_t size);
+
+  ChunkWriter writer_;
+  std::vector<char>& buffer_;
+  std::size_t bytes_written_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace detail
+}  // namespace prometheus
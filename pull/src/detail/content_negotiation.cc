@@ -0,0 +1,146 @@
+#include "content_negotiation.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "prometheus/detail/http_header.h"
+#include "prometheus/openmetrics_serializer.h"
+#include "prometheus/protobuf_serializer.h"
+#include "prometheus/text_serializer.h"
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+
+using MediaType = ContentNegotiator::MediaType;
+
+struct MediaRange {
+  MediaType media_type;
+  int quality = kMaxQuality;
+};
+
+// Parses "type/subtype; name=value; q=0.5", parameters after the q-value are
+// extensions and ignored
+bool ParseMediaRange(const std::string& text, MediaRange& range) {
+  const auto parts = Split(text, ';');
+  const auto full_type = ToLower(Trim(parts[0]));
+  const auto slash = full_type.find('/');
+  if (slash == std::string::npos || slash == 0 ||
+      slash + 1 == full_type.size()) {
+    return false;
+  }
+  range.media_type.type = full_type.substr(0, slash);
+  range.media_type.subtype = full_type.substr(slash + 1);
+
+  for (std::size_t i = 1; i < parts.size(); ++i) {
+    const auto equals = parts[i].find('=');
+    if (equals == std::string::npos) {
+      continue;
+    }
+    auto name = ToLower(Trim(parts[i].substr(0, equals)));
+    auto value = Trim(parts[i].substr(equals + 1));
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+      value = value.substr(1, value.size() - 2);
+    }
+
+    if (name == "q") {
+      range.quality = ParseQuality(value);
+      return range.quality >= 0;
+    }
+    if (name != "charset") {
+      range.media_type.parameter.emplace_back(std::move(name),
+                                              std::move(value));
+    }
+  }
+  return true;
+}
+
+std::vector<MediaRange> ParseAccept(const std::string& accept) {
+  std::vector<MediaRange> ranges;
+  for (const auto& text : Split(accept, ',')) {
+    auto range = MediaRange{};
+    if (ParseMediaRange(text, range)) {
+      ranges.push_back(std::move(range));
+    }
+  }
+  return ranges;
+}
+
+// Returns how specific the range matches the offered type, -1 if not at all
+int Match(const MediaType& range, const MediaType& offer) {
+  if (range.type == "*") {
+    return range.subtype == "*" ? 0 : -1;
+  }
+  if (range.type != offer.type) {
+    return -1;
+  }
+  if (range.subtype == "*") {
+    return 1;
+  }
+  if (range.subtype != offer.subtype) {
+    return -1;
+  }
+  for (const auto& parameter : range.parameter) {
+    if (std::find(offer.parameter.begin(), offer.parameter.end(),
+                  parameter) == offer.parameter.end()) {
+      return -1;
+    }
+  }
+  return 2 + static_cast<int>(range.parameter.size());
+}
+
+}  // namespace
+
+ContentNegotiator::ContentNegotiator() {
+  // text first, so "*/*" results in a human readable response
+  Register(std::make_shared<OpenMetricsSerializer>(),
+           OpenMetricsSerializer::kContentType);
+  Register(std::make_shared<ProtobufSerializer>(),
+           ProtobufSerializer::kContentType);
+  Register(std::make_shared<TextSerializer>(), TextSerializer::kContentType);
+  fallback_ = offers_.front().format;
+}
+
+void ContentNegotiator::Register(std::shared_ptr<const Serializer> serializer,
+                                 const std::string& content_type) {
+  auto range = MediaRange{};
+  ParseMediaRange(content_type, range);
+
+  auto offer = Offer{};
+  offer.format.serializer = std::move(serializer);
+  offer.format.content_type = content_type;
+  offer.media_type = std::move(range.media_type);
+  offers_.insert(offers_.begin(), std::move(offer));
+}
+
+const ContentNegotiator::Format& ContentNegotiator::Select(
+    const char* accept) const {
+  if (!accept) {
+    return fallback_;
+  }
+  const auto ranges = ParseAccept(accept);
+
+  const Format* best = &fallback_;
+  auto best_quality = 0;
+  for (const auto& offer : offers_) {
+    auto specificity = -1;
+    auto quality = 0;
+    for (const auto& range : ranges) {
+      const auto match = Match(range.media_type, offer.media_type);
+      if (match > specificity) {
+        specificity = match;
+        quality = range.quality;
+      }
+    }
+    // offers are ordered by preference, so only a higher quality wins
+    if (quality > best_quality) {
+      best = &offer.format;
+      best_quality = quality;
+    }
+  }
+  return *best;
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "prometheus/detail/pull_export.h"
+#include "prometheus/serializer.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Picks the exposition format of a scrape from its Accept header.
+///
+/// Formats are kept in order of preference. Each format gets the q-value of
+/// the most specific media range of the Accept header matching it. The format
+/// with the highest q-value wins, ties go to the preferred format. The text
+/// format is used if there is no Accept header or no format is acceptable.
+class PROMETHEUS_CPP_PULL_EXPORT ContentNegotiator {
+ public:
+  struct Format {
+    std::shared_ptr<const Serializer> serializer;
+    std::string content_type;
+  };
+
+  struct MediaType {
+    std::string type;
+    std::string subtype;
+    // lower case names, without "charset" and "q"
+    std::vector<std::pair<std::string, std::string>> parameter;
+  };
+
+  /// \brief Offers the text, protobuf and OpenMetrics formats, preferred in
+  /// this order.
+  ContentNegotiator();
+
+  /// \brief Offers an additional format.
+  ///
+  /// The format is preferred over all formats offered before, so it replaces
+  /// an earlier format with the same content type.
+  void Register(std::shared_ptr<const Serializer> serializer,
+                const std::string& content_type);
+
+  /// \brief Returns the format to use for a scrape.
+  ///
+  /// \param accept Value of the Accept header, nullptr if there is none.
+  const Format& Select(const char* accept) const;
+
+ private:
+  struct Offer {
+    Format format;
+    MediaType media_type;
+  };
+
+  std::vector<Offer> offers_;
+  Format fallback_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,149 @@
+#include "deadline_collector.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+const std::size_t DeadlineCollector::kDefaultThreads;
+
+DeadlineCollector::DeadlineCollector(Counter& reused, Counter& dropped,
+                                     std::size_t num_threads)
+    : reused_(reused), dropped_(dropped) {
+  workers_.reserve(std::max<std::size_t>(num_threads, 1));
+  for (std::size_t i = 0; i < std::max<std::size_t>(num_threads, 1); ++i) {
+    workers_.emplace_back([this] { Run(); });
+  }
+}
+
+DeadlineCollector::~DeadlineCollector() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  queued_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void DeadlineCollector::Collect(
+    const std::vector<std::weak_ptr<Collectable>>& collectables,
+    const FamilyFilter& filter, Clock::time_point deadline,
+    MetricSink& sink) {
+  struct Pending {
+    std::shared_ptr<State> state;
+    std::uint64_t collections;
+  };
+  std::vector<Pending> pending;
+  pending.reserve(collectables.size());
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (auto it = states_.begin(); it != states_.end();) {
+    if (it->first.expired() && !it->second->running) {
+      it = states_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (const auto& wcollectable : collectables) {
+    if (wcollectable.expired()) {
+      continue;
+    }
+
+    auto& state = states_[wcollectable];
+    if (!state) {
+      state = std::make_shared<State>();
+    }
+    pending.push_back(Pending{state, state->collections});
+    if (!state->running) {
+      state->running = true;
+      queue_.push_back(Task{wcollectable, state, filter});
+      queued_.notify_one();
+    }
+  }
+
+  auto done = [](const Pending& p) {
+    return p.state->collections != p.collections || !p.state->running;
+  };
+  collected_.wait_until(lock, deadline, [&] {
+    return std::all_of(pending.begin(), pending.end(), done);
+  });
+
+  std::vector<std::shared_ptr<const Result>> results;
+  results.reserve(pending.size());
+  for (const auto& p : pending) {
+    auto result = p.state->last_result;
+    if (result && !result->filter.Covers(filter)) {
+      result = p.state->last_complete;
+    }
+    const auto fresh = p.state->collections != p.collections &&
+                       result == p.state->last_result;
+    if (!fresh) {
+      // late, failed or collected for other families, fall back to the
+      // previous collection
+      if (result) {
+        reused_.Increment();
+      } else {
+        dropped_.Increment();
+      }
+    }
+    if (result) {
+      results.push_back(std::move(result));
+    }
+  }
+  lock.unlock();
+
+  for (const auto& result : results) {
+    WriteToSink(sink, result->families);
+  }
+}
+
+void DeadlineCollector::Run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (;;) {
+    queued_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+    auto task = std::move(queue_.front());
+    queue_.pop_front();
+
+    std::shared_ptr<const Result> result;
+    lock.unlock();
+    // referenced only while collecting, so the collector does not keep
+    // collectables alive
+    if (auto collectable = task.collectable.lock()) {
+      try {
+        MetricFamilyCollector families;
+        if (task.filter.Empty()) {
+          collectable->Collect(families);
+        } else {
+          FilteringSink filtered{families, task.filter};
+          collectable->Collect(filtered);
+        }
+        result = std::make_shared<const Result>(
+            Result{task.filter, families.TakeFamilies()});
+      } catch (...) {
+        // keep the previous result
+      }
+    }
+    lock.lock();
+
+    auto& state = *task.state;
+    state.running = false;
+    if (result) {
+      state.last_result = result;
+      if (result->filter.Empty()) {
+        state.last_complete = std::move(result);
+      }
+      ++state.collections;
+    }
+    collected_.notify_all();
+  }
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "family_filter.h"
+#include "prometheus/collectable.h"
+#include "prometheus/counter.h"
+#include "prometheus/detail/pull_export.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Collects metrics with a deadline, so one slow collectable does not
+/// fail the whole scrape.
+///
+/// Collectables are collected on a fixed number of worker threads. A
+/// collectable not done by the deadline keeps collecting in the background
+/// and its last result covering the families of the scrape is used instead,
+/// or it is left out if there is none yet. A collectable is never collected
+/// twice at the same time, later scrapes wait for the collection already
+/// running instead of starting another one.
+class PROMETHEUS_CPP_PULL_EXPORT DeadlineCollector {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static const std::size_t kDefaultThreads = 4;
+
+  /// \param reused Counts collectables replaced by their last result.
+  /// \param dropped Counts collectables left out of a scrape.
+  /// \param num_threads Number of worker threads, at least one.
+  DeadlineCollector(Counter& reused, Counter& dropped,
+                    std::size_t num_threads = kDefaultThreads);
+
+  /// \brief Waits for the running collections and stops the workers.
+  ~DeadlineCollector();
+
+  DeadlineCollector(const DeadlineCollector&) = delete;
+  DeadlineCollector& operator=(const DeadlineCollector&) = delete;
+
+  /// \brief Collects into the sink, in the order of the collectables.
+  ///
+  /// \param filter Families asked for, collectables started by this scrape
+  /// only collect these.
+  void Collect(const std::vector<std::weak_ptr<Collectable>>& collectables,
+               const FamilyFilter& filter, Clock::time_point deadline,
+               MetricSink& sink);
+
+ private:
+  struct Result {
+    // families the result was collected for
+    FamilyFilter filter;
+    std::vector<MetricFamily> families;
+  };
+
+  struct State {
+    bool running = false;
+    // incremented whenever a collection succeeds
+    std::uint64_t collections = 0;
+    std::shared_ptr<const Result> last_result;
+    // last result of all families, kept for scrapes the last result does
+    // not cover
+    std::shared_ptr<const Result> last_complete;
+  };
+
+  struct Task {
+    std::weak_ptr<Collectable> collectable;
+    std::shared_ptr<State> state;
+    FamilyFilter filter;
+  };
+
+  void Run();
+
+  Counter& reused_;
+  Counter& dropped_;
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable collected_;
+  bool stop_ = false;
+  std::deque<Task> queue_;
+  std::map<std::weak_ptr<Collectable>, std::shared_ptr<State>,
+           std::owner_less<std::weak_ptr<Collectable>>>
+      states_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,815 @@
+#include "epoll_server.h"
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "prometheus/detail/future_std.h"
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+
+// requests with larger headers or bodies are rejected
+constexpr std::size_t kMaxHeadSize = 16 * 1024;
+constexpr std::size_t kReadSize = 16 * 1024;
+// responses are buffered in blocks of this size, each one iovec of writev()
+constexpr std::size_t kBlockSize = 64 * 1024;
+// writing more waits for the client to read, so a response is not buffered
+// as a whole
+constexpr std::size_t kMaxBufferedSize = 4 * kBlockSize;
+// how long a write waits for the client to read before giving up
+constexpr int kWriteTimeoutMs = 30 * 1000;
+// run the handlers if no executor is given
+constexpr std::size_t kHandlerThreads = 4;
+// how long accepting pauses once the process runs out of file descriptors
+constexpr auto kAcceptBackoff = std::chrono::milliseconds{100};
+constexpr int kMaxIovecs = 64;
+constexpr int kMaxEvents = 64;
+constexpr char kUnixPrefix[] = "unix:";
+constexpr std::size_t kUnixPrefixSize = sizeof(kUnixPrefix) - 1;
+
+std::string Trim(const std::string& text) {
+  const auto begin = text.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return {};
+  }
+  const auto end = text.find_last_not_of(" \t");
+  return text.substr(begin, end - begin + 1);
+}
+
+// Returns false if the value is not a number or does not fit
+bool ParseContentLength(const char* text, std::size_t& length) {
+  length = 0;
+  if (*text == '\0') {
+    return false;
+  }
+  for (; *text != '\0'; ++text) {
+    if (*text < '0' || *text > '9') {
+      return false;
+    }
+    const auto digit = static_cast<std::size_t>(*text - '0');
+    if (length > (std::numeric_limits<std::size_t>::max() - digit) / 10) {
+      return false;
+    }
+    length = length * 10 + digit;
+  }
+  return true;
+}
+
+std::unique_ptr<CollectionExecutor> MakeHandlerThreads() {
+  auto options = CollectionExecutor::Options{};
+  options.num_threads = kHandlerThreads;
+  return detail::make_unique<CollectionExecutor>(options);
+}
+
+[[noreturn]] void ThrowSystemError(const std::string& what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Resolves "host:port", "[host]:port" or "port" without DNS lookups
+void ResolveAddress(const std::string& address, sockaddr_storage& storage,
+                    socklen_t& length) {
+  std::string host;
+  std::string port = address;
+  const auto colon = address.rfind(':');
+  if (colon != std::string::npos) {
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+      host = host.substr(1, host.size() - 2);
+    }
+  }
+  if (port.empty() ||
+      port.find_first_not_of("0123456789") != std::string::npos) {
+    throw std::runtime_error("invalid listening address: " + address);
+  }
+
+  addrinfo hints{};
+  hints.ai_family = host.empty() ? AF_INET : AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+  addrinfo* result = nullptr;
+  if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(),
+                    &hints, &result) != 0 ||
+      !result) {
+    throw std::runtime_error("invalid listening address: " + address);
+  }
+  std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)> info{result,
+                                                            &::freeaddrinfo};
+  std::memcpy(&storage, info->ai_addr, info->ai_addrlen);
+  length = info->ai_addrlen;
+}
+
+}  // namespace
+
+struct EpollServer::Task {
+  HttpHandler* handler = nullptr;
+  HttpAuthHandler* auth_handler = nullptr;
+};
+
+class EpollServer::Connection : public HttpConnection {
+ public:
+  explicit Connection(int fd) : fd_(fd) {}
+  ~Connection() override { ::close(fd_); }
+
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  using HttpConnection::Write;
+
+  int Fd() const { return fd_; }
+
+  const char* GetHeader(const char* name) const override {
+    for (const auto& header : headers_) {
+      if (::strcasecmp(header.first.c_str(), name) == 0) {
+        return header.second.c_str();
+      }
+    }
+    return nullptr;
+  }
+
+  const char* GetQueryString() const override {
+    return has_query_ ? query_.c_str() : nullptr;
+  }
+
+  const char* GetHttpVersion() const override { return version_.c_str(); }
+
+  // Waits for the client to read once kMaxBufferedSize is buffered, returns
+  // false if it does not in time or the connection failed
+  bool Write(const char* data, std::size_t size) override {
+    while (size > 0 && !broken_) {
+      if (output_.empty() || output_.back().size() == kBlockSize) {
+        output_.emplace_back();
+        output_.back().reserve(kBlockSize);
+      }
+      auto& block = output_.back();
+      const auto count = std::min(size, kBlockSize - block.size());
+      block.append(data, count);
+      buffered_ += count;
+      data += count;
+      size -= count;
+      if (buffered_ >= kMaxBufferedSize) {
+        Drain();
+      }
+    }
+    return !broken_;
+  }
+
+  // Returns false if the request is malformed
+  bool ParseHead(std::size_t head_size) {
+    headers_.clear();
+    has_query_ = false;
+    query_.clear();
+
+    std::size_t pos = 0;
+    auto next_line = [&](std::string& line) {
+      const auto end = input_.find("\r\n", pos);
+      line = input_.substr(pos, end - pos);
+      pos = end + 2;
+    };
+
+    std::string line;
+    next_line(line);
+    const auto first_space = line.find(' ');
+    const auto last_space = line.rfind(' ');
+    if (first_space == std::string::npos || first_space == last_space) {
+      return false;
+    }
+    method_ = line.substr(0, first_space);
+    auto target = line.substr(first_space + 1, last_space - first_space - 1);
+    const auto version = line.substr(last_space + 1);
+    if (version == "HTTP/1.1") {
+      version_ = "1.1";
+    } else if (version == "HTTP/1.0") {
+      version_ = "1.0";
+    } else {
+      return false;
+    }
+    const auto question_mark = target.find('?');
+    if (question_mark != std::string::npos) {
+      has_query_ = true;
+      query_ = target.substr(question_mark + 1);
+      target.resize(question_mark);
+    }
+    uri_ = std::move(target);
+
+    while (pos < head_size) {
+      next_line(line);
+      const auto colon = line.find(':');
+      if (colon == std::string::npos || colon == 0 || line[0] == ' ' ||
+          line[0] == '\t') {
+        return false;
+      }
+      headers_.emplace_back(line.substr(0, colon),
+                            Trim(line.substr(colon + 1)));
+    }
+    return true;
+  }
+
+  // Sends as much of the buffered response as the socket takes, returns
+  // false on errors
+  bool Flush() {
+    while (!output_.empty()) {
+      iovec iov[kMaxIovecs];
+      int count = 0;
+      for (auto it = output_.begin(); it != output_.end() && count < kMaxIovecs;
+           ++it, ++count) {
+        const auto offset = count == 0 ? output_offset_ : 0;
+        iov[count].iov_base = const_cast<char*>(it->data() + offset);
+        iov[count].iov_len = it->size() - offset;
+      }
+
+      msghdr message{};
+      message.msg_iov = iov;
+      message.msg_iovlen = static_cast<decltype(message.msg_iovlen)>(count);
+      auto sent = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      }
+
+      auto remaining = static_cast<std::size_t>(sent);
+      buffered_ -= remaining;
+      while (remaining > 0) {
+        const auto left = output_.front().size() - output_offset_;
+        if (remaining < left) {
+          output_offset_ += remaining;
+          break;
+        }
+        remaining -= left;
+        output_offset_ = 0;
+        output_.pop_front();
+      }
+    }
+    return true;
+  }
+
+  bool HasOutput() const { return !output_.empty(); }
+
+  // set once the connection failed and is to be closed without sending the
+  // rest of the response
+  bool Broken() const { return broken_; }
+
+  std::string input_;
+  std::string method_;
+  std::string uri_;
+  std::string version_;
+  // set once the connection is closed after the buffered response
+  bool closing_ = false;
+  // events epoll waits for, none while a task serves the connection
+  std::uint32_t events_ = EPOLLIN;
+  // request to serve on the executor
+  std::unique_ptr<Task> task_;
+
+ private:
+  int fd_;
+  std::vector<std::pair<std::string, std::string>> headers_;
+  std::string query_;
+  bool has_query_ = false;
+  std::deque<std::string> output_;
+  std::size_t output_offset_ = 0;
+  std::size_t buffered_ = 0;
+  bool broken_ = false;
+
+  // Sends until less than kMaxBufferedSize is buffered
+  void Drain() {
+    while (Flush() && buffered_ >= kMaxBufferedSize) {
+      pollfd writable{};
+      writable.fd = fd_;
+      writable.events = POLLOUT;
+      const auto ready = ::poll(&writable, 1, kWriteTimeoutMs);
+      if (ready == 0 || (ready < 0 && errno != EINTR)) {
+        break;
+      }
+    }
+    broken_ = buffered_ >= kMaxBufferedSize;
+  }
+};
+
+EpollServer::EpollServer(const std::string& listening_ports,
+                         Executor executor)
+    : handler_threads_(executor ? nullptr : MakeHandlerThreads()),
+      executor_(executor ? std::move(executor)
+                         : handler_threads_->AsExecutor()) {
+  try {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      ThrowSystemError("cannot create epoll instance");
+    }
+    wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+      ThrowSystemError("cannot create eventfd");
+    }
+    done_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (done_fd_ < 0) {
+      ThrowSystemError("cannot create eventfd");
+    }
+    for (auto fd : {wakeup_fd_, done_fd_}) {
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.fd = fd;
+      ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    std::size_t begin = 0;
+    while (begin <= listening_ports.size()) {
+      auto end = listening_ports.find(',', begin);
+      if (end == std::string::npos) {
+        end = listening_ports.size();
+      }
+      Listen(Trim(listening_ports.substr(begin, end - begin)));
+      begin = end + 1;
+    }
+  } catch (...) {
+    CloseSockets();
+    throw;
+  }
+  thread_ = std::thread{&EpollServer::Run, this};
+}
+
+EpollServer::~EpollServer() { Close(); }
+
+void EpollServer::Listen(const std::string& address) {
+  sockaddr_storage storage{};
+  socklen_t length = 0;
+  std::string path;
+  if (address.compare(0, kUnixPrefixSize, kUnixPrefix) == 0) {
+    path = address.substr(kUnixPrefixSize);
+    auto& unix_address = reinterpret_cast<sockaddr_un&>(storage);
+    if (path.empty() || path.size() >= sizeof(unix_address.sun_path)) {
+      throw std::runtime_error("invalid listening address: " + address);
+    }
+    unix_address.sun_family = AF_UNIX;
+    std::memcpy(unix_address.sun_path, path.data(), path.size());
+    length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) +
+                                    path.size() + 1);
+    if (path.front() == '@') {
+      // abstract namespace, the name is not null terminated
+      unix_address.sun_path[0] = '\0';
+      --length;
+      path.clear();
+    }
+  } else {
+    ResolveAddress(address, storage, length);
+  }
+
+  const auto fd = ::socket(storage.ss_family,
+                           SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    ThrowSystemError("cannot listen on " + address);
+  }
+  listeners_.push_back(fd);
+
+  int on = 1;
+  if (storage.ss_family == AF_UNIX) {
+    // replaces the socket file a previous process left behind, but neither
+    // other files nor a socket still listened on
+    struct stat status {};
+    if (!path.empty() && ::lstat(path.c_str(), &status) == 0 &&
+        S_ISSOCK(status.st_mode)) {
+      const auto probe =
+          ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (probe < 0) {
+        ThrowSystemError("cannot listen on " + address);
+      }
+      const auto connected =
+          ::connect(probe, reinterpret_cast<sockaddr*>(&storage), length) == 0;
+      const auto error = errno;
+      ::close(probe);
+      if (!connected && error == ECONNREFUSED) {
+        ::unlink(path.c_str());
+      } else if (connected || error == EAGAIN) {
+        errno = EADDRINUSE;
+        ThrowSystemError("cannot listen on " + address);
+      }
+    }
+  } else {
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  }
+  if (storage.ss_family == AF_INET6) {
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+  }
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&storage), length) != 0) {
+    ThrowSystemError("cannot listen on " + address);
+  }
+  if (!path.empty()) {
+    socket_paths_.push_back(path);
+  }
+  if (::listen(fd, SOMAXCONN) != 0) {
+    ThrowSystemError("cannot listen on " + address);
+  }
+
+  if (storage.ss_family != AF_UNIX) {
+    sockaddr_storage bound{};
+    length = sizeof(bound);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &length);
+    ports_.push_back(
+        ntohs(bound.ss_family == AF_INET6
+                  ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+                  : reinterpret_cast<sockaddr_in*>(&bound)->sin_port));
+  }
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+}
+
+void EpollServer::AddHandler(const std::string& uri, HttpHandler& handler) {
+  std::lock_guard<std::mutex> lock{handlers_mutex_};
+  handlers_[uri] = &handler;
+}
+
+void EpollServer::RemoveHandler(const std::string& uri) {
+  std::lock_guard<std::mutex> lock{handlers_mutex_};
+  handlers_.erase(uri);
+}
+
+void EpollServer::AddAuthHandler(const std::string& uri,
+                                 HttpAuthHandler& handler) {
+  std::lock_guard<std::mutex> lock{handlers_mutex_};
+  auth_handlers_[uri] = &handler;
+}
+
+void EpollServer::RemoveAuthHandler(const std::string& uri) {
+  std::lock_guard<std::mutex> lock{handlers_mutex_};
+  auth_handlers_.erase(uri);
+}
+
+std::vector<int> EpollServer::GetListeningPorts() const { return ports_; }
+
+void EpollServer::Close() {
+  if (thread_.joinable()) {
+    const std::uint64_t one = 1;
+    if (::write(wakeup_fd_, &one, sizeof(one)) < 0) {
+      // the counter is only full if a wakeup is already pending
+    }
+    thread_.join();
+  }
+  {
+    // tasks still use their connections
+    std::unique_lock<std::mutex> lock{tasks_mutex_};
+    tasks_done_.wait(lock, [this] { return running_tasks_ == 0; });
+  }
+  CloseSockets();
+}
+
+void EpollServer::CloseSockets() {
+  connections_.clear();
+  for (auto fd : listeners_) {
+    ::close(fd);
+  }
+  listeners_.clear();
+  for (const auto& path : socket_paths_) {
+    ::unlink(path.c_str());
+  }
+  socket_paths_.clear();
+  for (auto fd : {&wakeup_fd_, &done_fd_}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+  if (epoll_fd_ >= 0) {
+    ::close(epoll_fd_);
+    epoll_fd_ = -1;
+  }
+}
+
+void EpollServer::Run() {
+  epoll_event events[kMaxEvents];
+  for (;;) {
+    const auto timeout =
+        accepting_ ? -1 : static_cast<int>(kAcceptBackoff.count());
+    const auto count = ::epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+    if (!accepting_ &&
+        std::chrono::steady_clock::now() >= resume_accepting_) {
+      SetAccepting(true);
+    }
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      const auto fd = events[i].data.fd;
+      if (fd == wakeup_fd_) {
+        return;
+      }
+      if (fd == done_fd_) {
+        CompleteTasks();
+        continue;
+      }
+      if (std::find(listeners_.begin(), listeners_.end(), fd) !=
+          listeners_.end()) {
+        Accept(fd);
+        continue;
+      }
+      auto it = connections_.find(fd);
+      if (it != connections_.end() &&
+          !HandleEvents(*it->second, events[i].events)) {
+        // closing the socket also removes it from the epoll instance
+        connections_.erase(it);
+      }
+    }
+  }
+}
+
+void EpollServer::Accept(int listener) {
+  for (;;) {
+    const auto fd =
+        ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        // the pending connection stays and would wake the level triggered
+        // listener again right away, so pause until resources are freed
+        SetAccepting(false);
+        resume_accepting_ = std::chrono::steady_clock::now() + kAcceptBackoff;
+        return;
+      }
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      // EAGAIN once all pending connections are accepted
+      return;
+    }
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      ::close(fd);
+      continue;
+    }
+    connections_[fd] = detail::make_unique<Connection>(fd);
+  }
+}
+
+void EpollServer::SetAccepting(bool accepting) {
+  accepting_ = accepting;
+  for (auto fd : listeners_) {
+    epoll_event event{};
+    event.events = accepting ? static_cast<std::uint32_t>(EPOLLIN) : 0u;
+    event.data.fd = fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+  }
+}
+
+// Returns false once the connection is to be closed
+bool EpollServer::HandleEvents(Connection& connection, std::uint32_t events) {
+  if (events & EPOLLIN) {
+    char buffer[kReadSize];
+    for (;;) {
+      const auto count = ::recv(connection.Fd(), buffer, sizeof(buffer), 0);
+      if (count > 0) {
+        connection.input_.append(buffer, static_cast<std::size_t>(count));
+        continue;
+      }
+      if (count == 0) {
+        connection.closing_ = true;
+      } else if (errno == EINTR) {
+        continue;
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+      break;
+    }
+  } else if (events & (EPOLLERR | EPOLLHUP)) {
+    return false;
+  }
+
+  return Continue(connection);
+}
+
+// Sends the pending response and serves the buffered requests, returns false
+// once the connection is to be closed
+bool EpollServer::Continue(Connection& connection) {
+  if (connection.Broken() || !connection.Flush()) {
+    return false;
+  }
+  if (!connection.HasOutput() && !ProcessRequests(connection)) {
+    return false;
+  }
+
+  if (connection.task_) {
+    // not watched while the request is served on the executor, so only the
+    // task uses the connection
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.Fd(), nullptr);
+    connection.events_ = 0;
+    Dispatch(connection);
+    return true;
+  }
+
+  // stop reading while a response is pending, so a client not reading its
+  // responses cannot make the server buffer without limit
+  const std::uint32_t wanted = connection.HasOutput() ? EPOLLOUT : EPOLLIN;
+  if (wanted != connection.events_) {
+    epoll_event event{};
+    event.events = wanted;
+    event.data.fd = connection.Fd();
+    ::epoll_ctl(epoll_fd_, connection.events_ ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                connection.Fd(), &event);
+    connection.events_ = wanted;
+  }
+  return connection.HasOutput() || !connection.closing_;
+}
+
+void EpollServer::Dispatch(Connection& connection) {
+  {
+    std::lock_guard<std::mutex> lock{tasks_mutex_};
+    ++running_tasks_;
+  }
+  auto* task_connection = &connection;
+  executor_([this, task_connection] {
+    auto& task = task_connection->task_;
+    try {
+      Serve(*task_connection, *task->handler, task->auth_handler);
+    } catch (...) {
+      // the response may be incomplete
+      task_connection->closing_ = true;
+    }
+    task.reset();
+    if (task_connection->closing_) {
+      // requests pipelined after the last one are not served
+      task_connection->input_.clear();
+    }
+
+    std::lock_guard<std::mutex> lock{tasks_mutex_};
+    completed_.push_back(task_connection->Fd());
+    const std::uint64_t one = 1;
+    if (::write(done_fd_, &one, sizeof(one)) < 0) {
+      // the counter is only full if a wakeup is already pending
+    }
+    --running_tasks_;
+    tasks_done_.notify_all();
+  });
+}
+
+void EpollServer::CompleteTasks() {
+  std::uint64_t count;
+  if (::read(done_fd_, &count, sizeof(count)) < 0) {
+    // nothing to read if an earlier call already took the completions
+  }
+  std::vector<int> completed;
+  {
+    std::lock_guard<std::mutex> lock{tasks_mutex_};
+    completed.swap(completed_);
+  }
+  for (auto fd : completed) {
+    auto it = connections_.find(fd);
+    if (it != connections_.end() && !Continue(*it->second)) {
+      connections_.erase(it);
+    }
+  }
+}
+
+// Serves the buffered requests in order until one has to wait for the
+// socket, returns false on errors
+bool EpollServer::ProcessRequests(Connection& connection) {
+  auto& input = connection.input_;
+  // answers with the error and closes the connection
+  auto reject = [&](const char* status) {
+    connection.Write(std::string{"HTTP/1.1 "} + status +
+                     "\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+    connection.closing_ = true;
+    input.clear();
+    return connection.Flush();
+  };
+
+  while (!connection.HasOutput()) {
+    const auto head_end = input.find("\r\n\r\n");
+    if (head_end == std::string::npos) {
+      if (input.size() > kMaxHeadSize) {
+        return reject("431 Request Header Fields Too Large");
+      }
+      return true;
+    }
+
+    if (!connection.ParseHead(head_end + 2) ||
+        connection.GetHeader("Transfer-Encoding")) {
+      return reject("400 Bad Request");
+    }
+
+    // bodies are not used, but have to be skipped
+    auto request_size = head_end + 4;
+    const auto content_length = connection.GetHeader("Content-Length");
+    if (content_length) {
+      std::size_t body_size = 0;
+      if (!ParseContentLength(content_length, body_size)) {
+        return reject("400 Bad Request");
+      }
+      if (body_size > kMaxHeadSize) {
+        return reject("413 Payload Too Large");
+      }
+      request_size += body_size;
+      if (input.size() < request_size) {
+        return true;
+      }
+    }
+
+    const auto connection_header = connection.GetHeader("Connection");
+    if (std::strcmp(connection.GetHttpVersion(), "1.0") == 0 ||
+        (connection_header && ::strcasecmp(connection_header, "close") == 0)) {
+      connection.closing_ = true;
+    }
+    HandleRequest(connection);
+    input.erase(0, request_size);
+    if (connection.task_) {
+      return true;
+    }
+    if (!connection.Flush()) {
+      return false;
+    }
+    if (connection.closing_) {
+      input.clear();
+      return true;
+    }
+  }
+  return true;
+}
+
+void EpollServer::HandleRequest(Connection& connection) {
+  if (connection.method_ != "GET") {
+    connection.Write(
+        "HTTP/1.1 405 Method Not Allowed\r\n"
+        "Allow: GET\r\nContent-Length: 0\r\n\r\n");
+    return;
+  }
+
+  HttpHandler* handler = nullptr;
+  HttpAuthHandler* auth_handler = nullptr;
+  {
+    std::lock_guard<std::mutex> lock{handlers_mutex_};
+    auto it = handlers_.find(connection.uri_);
+    if (it != handlers_.end()) {
+      handler = it->second;
+    }
+    auto auth_it = auth_handlers_.find(connection.uri_);
+    if (auth_it != auth_handlers_.end()) {
+      auth_handler = auth_it->second;
+    }
+  }
+
+  if (!handler) {
+    connection.Write(
+        "HTTP/1.1 404 Not Found\r\n"
+        "Content-Length: 0\r\n\r\n");
+    return;
+  }
+  // served once the I/O thread is done with the connection, so a client
+  // reading slowly only ever blocks the thread writing its response
+  connection.task_ = detail::make_unique<Task>();
+  connection.task_->handler = handler;
+  connection.task_->auth_handler = auth_handler;
+}
+
+void EpollServer::Serve(Connection& connection, HttpHandler& handler,
+                        HttpAuthHandler* auth_handler) {
+  if (auth_handler && !auth_handler->Authorize(connection)) {
+    // the rejection closes the connection
+    connection.closing_ = true;
+    return;
+  }
+  if (!handler.HandleGet(connection) && !connection.HasOutput()) {
+    connection.Write(
+        "HTTP/1.1 500 Internal Server Error\r\n"
+        "Content-Length: 0\r\n\r\n");
+  }
+}
+
+}  // namespace detail
+}  // namespace prometheus
+
+#endif
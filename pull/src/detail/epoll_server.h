@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "http_server.h"
+#include "prometheus/collection_executor.h"
+#include "prometheus/detail/pull_export.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Minimal HTTP/1.1 server built on epoll, only available on Linux.
+///
+/// A single I/O thread accepts connections, parses requests and sends the
+/// buffered responses, it never waits for a client. Connections are kept alive. Responses are buffered and sent
+/// with one writev() per flush, so a scrape over an open connection costs a
+/// few system calls. Once a few hundred KiB are buffered, writing waits for
+/// the client to read, so large responses are not held in memory as a
+/// whole. Only GET requests are served, request bodies of more than 16 KiB
+/// are rejected.
+///
+/// Handlers run on the given executor, or on four threads of the server if
+/// there is none. A request is handed to it and the connection is left
+/// alone until the handler is done, so slow handlers and clients reading
+/// slowly do not stall other connections.
+class PROMETHEUS_CPP_PULL_EXPORT EpollServer : public HttpServer {
+ public:
+  /// \brief Runs a task, e.g., by posting it to a thread pool.
+  using Executor = std::function<void(std::function<void()>)>;
+
+  /// \brief Starts listening and serving.
+  ///
+  /// \param listening_ports Comma separated addresses to listen on, e.g.,
+  /// "127.0.0.1:8080,[::1]:8080", or only a port to listen on all IPv4
+  /// addresses. Port 0 picks a free port. "unix:/path/to/socket" listens on
+  /// a Unix domain socket, "unix:@name" on one in the abstract namespace.
+  /// Throws std::runtime_error if an address is invalid or cannot be
+  /// listened on.
+  /// \param executor Runs the handlers, nullptr to run them on threads of
+  /// the server. Close() waits for the tasks handed to it.
+  explicit EpollServer(const std::string& listening_ports,
+                       Executor executor = nullptr);
+  ~EpollServer() override;
+
+  EpollServer(const EpollServer&) = delete;
+  EpollServer(EpollServer&&) = delete;
+  EpollServer& operator=(const EpollServer&) = delete;
+  EpollServer& operator=(EpollServer&&) = delete;
+
+  void AddHandler(const std::string& uri, HttpHandler& handler) override;
+  void RemoveHandler(const std::string& uri) override;
+  void AddAuthHandler(const std::string& uri,
+                      HttpAuthHandler& handler) override;
+  void RemoveAuthHandler(const std::string& uri) override;
+
+  std::vector<int> GetListeningPorts() const override;
+  void Close() override;
+
+ private:
+  class Connection;
+  struct Task;
+
+  void Listen(const std::string& address);
+  void Run();
+  void Accept(int listener);
+  void SetAccepting(bool accepting);
+  bool HandleEvents(Connection& connection, std::uint32_t events);
+  bool Continue(Connection& connection);
+  bool ProcessRequests(Connection& connection);
+  void HandleRequest(Connection& connection);
+  static void Serve(Connection& connection, HttpHandler& handler,
+                    HttpAuthHandler* auth_handler);
+  void Dispatch(Connection& connection);
+  void CompleteTasks();
+  void CloseSockets();
+
+  // run the handlers if no executor is given
+  std::unique_ptr<CollectionExecutor> handler_threads_;
+  const Executor executor_;
+  int epoll_fd_ = -1;
+  // signals the I/O thread to stop
+  int wakeup_fd_ = -1;
+  // signals the I/O thread that tasks are done
+  int done_fd_ = -1;
+  std::vector<int> listeners_;
+  // only used by the I/O thread, accepting pauses while the process is out
+  // of file descriptors
+  bool accepting_ = true;
+  std::chrono::steady_clock::time_point resume_accepting_;
+  // ports of the TCP listeners
+  std::vector<int> ports_;
+  // files of the Unix domain socket listeners, removed when closing
+  std::vector<std::string> socket_paths_;
+  std::mutex handlers_mutex_;
+  std::map<std::string, HttpHandler*> handlers_;
+  std::map<std::string, HttpAuthHandler*> auth_handlers_;
+  // only used by the I/O thread
+  std::map<int, std::unique_ptr<Connection>> connections_;
+  std::mutex tasks_mutex_;
+  std::condition_variable tasks_done_;
+  std::size_t running_tasks_ = 0;
+  // connections whose tasks are done
+  std::vector<int> completed_;
+  std::thread thread_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
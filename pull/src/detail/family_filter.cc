@@ -0,0 +1,137 @@
+#include "family_filter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+
+#include "prometheus/detail/http_header.h"
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+
+// Decodes "%XX" escapes and "+" of application/x-www-form-urlencoded
+std::string UrlDecode(const std::string& text) {
+  std::string decoded;
+  decoded.reserve(text.size());
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '+') {
+      decoded.push_back(' ');
+    } else if (text[i] == '%' && i + 2 < text.size() &&
+               std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+               std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+      decoded.push_back(static_cast<char>(
+          std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16)));
+      i += 2;
+    } else {
+      decoded.push_back(text[i]);
+    }
+  }
+  return decoded;
+}
+
+// Extracts the name of a selector like up or {__name__="up"}, empty if the
+// selector is anything else
+std::string SelectorName(const std::string& selector) {
+  const auto text = Trim(selector);
+  const std::string prefix = "{__name__=\"";
+  const std::string suffix = "\"}";
+  if (text.size() > prefix.size() + suffix.size() &&
+      text.compare(0, prefix.size(), prefix) == 0 &&
+      text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0) {
+    return text.substr(prefix.size(),
+                       text.size() - prefix.size() - suffix.size());
+  }
+  const auto is_name_char = [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == ':';
+  };
+  if (std::all_of(text.begin(), text.end(), is_name_char)) {
+    return text;
+  }
+  return std::string{};
+}
+
+}  // namespace
+
+void FamilyFilter::Parse(const char* query_string) {
+  names_.clear();
+  if (!query_string) {
+    return;
+  }
+
+  auto selected = false;
+  for (const auto& parameter : Split(query_string, '&')) {
+    const auto equals = parameter.find('=');
+    if (equals == std::string::npos) {
+      continue;
+    }
+    const auto key = UrlDecode(parameter.substr(0, equals));
+    const auto value = UrlDecode(parameter.substr(equals + 1));
+
+    if (key == "name[]") {
+      selected = true;
+      names_.push_back(value);
+    } else if (key == "match[]") {
+      selected = true;
+      auto name = SelectorName(value);
+      if (!name.empty()) {
+        names_.push_back(std::move(name));
+      }
+    }
+  }
+
+  if (selected && names_.empty()) {
+    // only unsupported selectors, a name no family can have selects nothing
+    names_.emplace_back();
+  }
+  std::sort(names_.begin(), names_.end());
+  names_.erase(std::unique(names_.begin(), names_.end()), names_.end());
+}
+
+bool FamilyFilter::Matches(const std::string& name) const {
+  return names_.empty() ||
+         std::binary_search(names_.begin(), names_.end(), name);
+}
+
+bool FamilyFilter::Covers(const FamilyFilter& other) const {
+  if (names_.empty()) {
+    return true;
+  }
+  return !other.names_.empty() &&
+         std::includes(names_.begin(), names_.end(), other.names_.begin(),
+                       other.names_.end());
+}
+
+FilteringSink::FilteringSink(MetricSink& sink, const FamilyFilter& filter)
+    : sink_(sink), filter_(filter) {
+  SetArena(&sink_.GetArena());
+}
+
+void FilteringSink::BeginFamily(const MetricFamily& family) {
+  skipping_ = !filter_.Matches(family.name);
+  if (!skipping_) {
+    sink_.BeginFamily(family);
+  }
+}
+
+void FilteringSink::AddMetric(const MetricRecord& metric) {
+  if (!skipping_) {
+    sink_.AddMetric(metric);
+  }
+}
+
+void FilteringSink::EndFamily() {
+  if (!skipping_) {
+    sink_.EndFamily();
+  }
+  skipping_ = false;
+}
+
+bool FilteringSink::WantsFamily(const std::string& name) const {
+  return filter_.Matches(name) && sink_.WantsFamily(name);
+}
+
+}  // namespace detail
+}  // namespace prometheus
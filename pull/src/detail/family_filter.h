@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "prometheus/detail/pull_export.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Metric families a scrape asks for by name.
+///
+/// Parsed from the query parameters "name[]" and "match[]", each naming a
+/// family. Selectors of "match[]" other than a plain metric name or
+/// {__name__="..."} are not supported and select nothing. Without any
+/// parameter all families are selected.
+class PROMETHEUS_CPP_PULL_EXPORT FamilyFilter {
+ public:
+  /// \param query_string Query string of the request, nullptr if none.
+  void Parse(const char* query_string);
+
+  void Clear() { names_.clear(); }
+
+  /// \brief Returns true if all families are selected.
+  bool Empty() const { return names_.empty(); }
+
+  bool Matches(const std::string& name) const;
+
+  /// \brief Returns true if this filter selects every family the other one
+  /// selects.
+  bool Covers(const FamilyFilter& other) const;
+
+ private:
+  // sorted and unique
+  std::vector<std::string> names_;
+};
+
+/// \brief Forwards the families selected by a filter to another sink.
+///
+/// Collectables asking the sink do not collect other families at all, the
+/// others' are dropped here.
+class PROMETHEUS_CPP_PULL_EXPORT FilteringSink : public MetricSink {
+ public:
+  /// \param filter Families to forward, must outlive the sink.
+  FilteringSink(MetricSink& sink, const FamilyFilter& filter);
+
+  void BeginFamily(const MetricFamily& family) override;
+  void AddMetric(const MetricRecord& metric) override;
+  void EndFamily() override;
+  bool WantsFamily(const std::string& name) const override;
+
+ private:
+  MetricSink& sink_;
+  const FamilyFilter& filter_;
+  bool skipping_ = false;
+};
+
+}  // namespace detail
+}  // namespace prometheus
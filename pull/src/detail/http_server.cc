@@ -0,0 +1,17 @@
+#include "http_server.h"
+
+#include <cstdio>
+
+namespace prometheus {
+namespace detail {
+
+bool HttpConnection::WriteChunk(const char* data, std::size_t size) {
+  char header[24];
+  const auto length = std::snprintf(header, sizeof(header), "%lx\r\n",
+                                    static_cast<unsigned long>(size));
+  return length > 0 && Write(header, static_cast<std::size_t>(length)) &&
+         (size == 0 || Write(data, size)) && Write("\r\n", 2);
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "prometheus/detail/pull_export.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief A request and its response, independent of the HTTP server.
+class PROMETHEUS_CPP_PULL_EXPORT HttpConnection {
+ public:
+  virtual ~HttpConnection() = default;
+
+  /// \brief Returns the value of a request header, nullptr if there is none.
+  virtual const char* GetHeader(const char* name) const = 0;
+
+  /// \brief Returns the query string of the request, nullptr if there is
+  /// none.
+  virtual const char* GetQueryString() const = 0;
+
+  /// \brief Returns the HTTP version of the request, e.g., "1.1".
+  virtual const char* GetHttpVersion() const = 0;
+
+  /// \brief Writes raw response data, returns false on errors.
+  virtual bool Write(const char* data, std::size_t size) = 0;
+
+  /// \brief Writes a chunk of a response with chunked transfer encoding,
+  /// returns false on errors.
+  ///
+  /// An empty chunk ends the response.
+  virtual bool WriteChunk(const char* data, std::size_t size);
+
+  bool Write(const std::string& data) {
+    return Write(data.data(), data.size());
+  }
+};
+
+/// \brief Serves GET requests of a URI.
+class PROMETHEUS_CPP_PULL_EXPORT HttpHandler {
+ public:
+  virtual ~HttpHandler() = default;
+
+  /// \brief Writes the response, returns false if the request was not
+  /// handled.
+  virtual bool HandleGet(HttpConnection& conn) = 0;
+};
+
+/// \brief Decides whether a request may be served.
+class PROMETHEUS_CPP_PULL_EXPORT HttpAuthHandler {
+ public:
+  virtual ~HttpAuthHandler() = default;
+
+  /// \brief Returns true if the request may be served, otherwise writes
+  /// the response rejecting it.
+  virtual bool Authorize(HttpConnection& conn) = 0;
+};
+
+/// \brief HTTP server the endpoints of an Exposer are served by.
+///
+/// Handlers are only referenced and have to be removed before they are
+/// destroyed.
+class PROMETHEUS_CPP_PULL_EXPORT HttpServer {
+ public:
+  virtual ~HttpServer() = default;
+
+  virtual void AddHandler(const std::string& uri, HttpHandler& handler) = 0;
+  virtual void RemoveHandler(const std::string& uri) = 0;
+  virtual void AddAuthHandler(const std::string& uri,
+                              HttpAuthHandler& handler) = 0;
+  virtual void RemoveAuthHandler(const std::string& uri) = 0;
+
+  virtual std::vector<int> GetListeningPorts() const = 0;
+
+  /// \brief Stops accepting requests and waits for running requests.
+  virtual void Close() = 0;
+};
+
+}  // namespace detail
+}  // namespace prometheus
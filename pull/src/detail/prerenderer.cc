@@ -0,0 +1,101 @@
+#include "prerenderer.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+// responses nobody asked for during this many intervals are dropped
+const int kExpiryIntervals = 10;
+}  // namespace
+
+Prerenderer::Prerenderer(std::chrono::milliseconds interval)
+    : interval_(interval),
+      expiry_(interval * kExpiryIntervals),
+      thread_([this] { Run(); }) {}
+
+Prerenderer::~Prerenderer() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  stopped_.notify_all();
+  thread_.join();
+}
+
+std::shared_ptr<const CachedResponse> Prerenderer::Get(const std::string& key,
+                                                       Render render) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      it->second->last_requested = Clock::now();
+      entry = it->second;
+    }
+  }
+  if (entry) {
+    return std::atomic_load(&entry->response);
+  }
+
+  entry = std::make_shared<Entry>();
+  entry->response = std::make_shared<const CachedResponse>(render());
+  entry->render = std::move(render);
+  entry->last_requested = Clock::now();
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  // a concurrent scrape may have added the key meanwhile, either is fine
+  entries_[key] = entry;
+  return entry->response;
+}
+
+void Prerenderer::Clear() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  entries_.clear();
+}
+
+void Prerenderer::Run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto next = Clock::now() + interval_;
+  for (;;) {
+    if (stopped_.wait_until(lock, next, [this] { return stop_; })) {
+      return;
+    }
+    next += interval_;
+
+    const auto now = Clock::now();
+    std::vector<std::shared_ptr<Entry>> entries;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (now - it->second->last_requested > expiry_) {
+        it = entries_.erase(it);
+      } else {
+        entries.push_back(it->second);
+        ++it;
+      }
+    }
+
+    // render without holding the lock, so scrapes are not blocked
+    lock.unlock();
+    for (const auto& entry : entries) {
+      try {
+        std::shared_ptr<const CachedResponse> response =
+            std::make_shared<const CachedResponse>(entry->render());
+        std::atomic_store(&entry->response, std::move(response));
+      } catch (...) {
+        // keep serving the previous rendering
+      }
+    }
+    lock.lock();
+
+    // skip intervals missed because rendering took too long
+    if (next < Clock::now()) {
+      next = Clock::now() + interval_;
+    }
+  }
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "prometheus/detail/pull_export.h"
+#include "response_cache.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Renders responses on a background thread at a fixed interval.
+///
+/// A response is rendered on the scrape thread the first time its key is
+/// asked for. From then on the background thread renders it again every
+/// interval and scrapes get the latest rendering, so they do not collect
+/// metrics anymore. Keys not asked for during the expiry time are dropped.
+class PROMETHEUS_CPP_PULL_EXPORT Prerenderer {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Render = std::function<CachedResponse()>;
+
+  /// \param interval Time between two renderings of a response.
+  explicit Prerenderer(std::chrono::milliseconds interval);
+
+  /// \brief Stops the background thread.
+  ~Prerenderer();
+
+  Prerenderer(const Prerenderer&) = delete;
+  Prerenderer& operator=(const Prerenderer&) = delete;
+
+  /// \brief Returns the latest rendering of the response for the key.
+  ///
+  /// \param render Renders the response, called right away if the key is
+  /// new and kept for rendering it in the background.
+  std::shared_ptr<const CachedResponse> Get(const std::string& key,
+                                            Render render);
+
+  /// \brief Drops all responses, e.g., because their rendering changed.
+  void Clear();
+
+ private:
+  struct Entry {
+    Render render;
+    // accessed with std::atomic_load() and std::atomic_store()
+    std::shared_ptr<const CachedResponse> response;
+    Clock::time_point last_requested;
+  };
+
+  void Run();
+
+  const Clock::duration interval_;
+  const Clock::duration expiry_;
+  std::mutex mutex_;
+  std::condition_variable stopped_;
+  bool stop_ = false;
+  std::map<std::string, std::shared_ptr<Entry>> entries_;
+  std::thread thread_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,61 @@
+#include "response_cache.h"
+
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+ResponseCache::ResponseCache(std::chrono::milliseconds max_age)
+    : max_age_(max_age) {}
+
+std::shared_ptr<const CachedResponse> ResponseCache::Get(
+    const std::string& key, const Producer& produce, Result& result) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto& entry = entries_[key];
+
+  auto waited = false;
+  auto generation = entry.generation;
+  for (;;) {
+    if (waited && entry.generation != generation) {
+      // the scrape we waited for is done, its response is fresh enough
+      result = Result::Coalesced;
+      return entry.response;
+    }
+    if (entry.response && Clock::now() - entry.produced <= max_age_) {
+      result = waited ? Result::Coalesced : Result::Hit;
+      return entry.response;
+    }
+    if (!entry.in_flight) {
+      break;
+    }
+    waited = true;
+    generation = entry.generation;
+    produced_.wait(lock);
+  }
+
+  entry.in_flight = true;
+  lock.unlock();
+
+  std::shared_ptr<const CachedResponse> response;
+  try {
+    response = std::make_shared<const CachedResponse>(produce());
+  } catch (...) {
+    lock.lock();
+    entry.in_flight = false;
+    produced_.notify_all();
+    throw;
+  }
+
+  lock.lock();
+  entry.response = response;
+  entry.produced = Clock::now();
+  ++entry.generation;
+  entry.in_flight = false;
+  produced_.notify_all();
+
+  result = Result::Miss;
+  return response;
+}
+
+}  // namespace detail
+}  // namespace prometheus
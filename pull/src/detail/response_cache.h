@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "prometheus/detail/pull_export.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Response body together with how it is encoded.
+struct CachedResponse {
+  std::string body;
+  // empty if the body is not compressed
+  std::string content_encoding;
+};
+
+/// \brief Shares responses between scrapes asking for the same content.
+///
+/// Concurrent scrapes with the same key wait for the first of them to
+/// prepare the response instead of collecting again. The response is also
+/// served to scrapes arriving up to the maximum age later.
+class PROMETHEUS_CPP_PULL_EXPORT ResponseCache {
+ public:
+  enum class Result {
+    // a fresh response was served
+    Hit,
+    // the scrape waited for the response of a concurrent scrape
+    Coalesced,
+    // the scrape prepared the response itself
+    Miss,
+  };
+
+  using Clock = std::chrono::steady_clock;
+  using Producer = std::function<CachedResponse()>;
+
+  /// \param max_age How long a response is served after it was prepared.
+  explicit ResponseCache(std::chrono::milliseconds max_age);
+
+  /// \brief Returns the response for the key.
+  ///
+  /// \param produce Prepares the response if there is neither a fresh nor
+  /// an in-flight one. If it throws, waiting scrapes try again themselves.
+  /// \param result Set to how the response was obtained.
+  std::shared_ptr<const CachedResponse> Get(const std::string& key,
+                                            const Producer& produce,
+                                            Result& result);
+
+ private:
+  struct Entry {
+    std::shared_ptr<const CachedResponse> response;
+    Clock::time_point produced;
+    // incremented whenever a response is stored
+    std::uint64_t generation = 0;
+    bool in_flight = false;
+  };
+
+  const Clock::duration max_age_;
+  std::mutex mutex_;
+  std::condition_variable produced_;
+  std::map<std::string, Entry> entries_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
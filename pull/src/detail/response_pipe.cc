@@ -0,0 +1,99 @@
+#include "response_pipe.h"
+
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+ResponsePipe::ResponsePipe(std::size_t max_buffered)
+    : max_buffered_(max_buffered) {}
+
+void ResponsePipe::Begin(const std::string& content_type,
+                         const std::string& content_encoding,
+                         const std::size_t* content_length) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  content_type_ = content_type;
+  content_encoding_ = content_encoding;
+  has_content_length_ = content_length != nullptr;
+  content_length_ = content_length ? *content_length : 0;
+  begun_ = true;
+  changed_.notify_all();
+}
+
+bool ResponsePipe::Write(const char* data, std::size_t size) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  // a chunk larger than the limit is still passed on once the pipe is empty
+  changed_.wait(lock, [this, size] {
+    return broken_ || buffered_ == 0 || buffered_ + size <= max_buffered_;
+  });
+  if (broken_) {
+    return false;
+  }
+  chunks_.emplace_back(data, size);
+  buffered_ += size;
+  changed_.notify_all();
+  return true;
+}
+
+void ResponsePipe::Close(ScrapeHandler::Status status) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  status_ = status;
+  closed_ = true;
+  changed_.notify_all();
+}
+
+void ResponsePipe::Fail(std::exception_ptr error) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  error_ = std::move(error);
+  closed_ = true;
+  changed_.notify_all();
+}
+
+ScrapeHandler::Status ResponsePipe::Drain(
+    ScrapeHandler::ResponseWriter& writer) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto begun = false;
+  try {
+    for (;;) {
+      changed_.wait(lock, [this, begun] {
+        return (begun_ && !begun) || !chunks_.empty() || closed_;
+      });
+      if (begun_ && !begun) {
+        begun = true;
+        lock.unlock();
+        writer.Begin(content_type_, content_encoding_,
+                     has_content_length_ ? &content_length_ : nullptr);
+        lock.lock();
+      } else if (!chunks_.empty()) {
+        auto chunk = std::move(chunks_.front());
+        chunks_.pop_front();
+        const auto discard = broken_;
+        lock.unlock();
+        const auto written =
+            discard || writer.Write(chunk.data(), chunk.size());
+        lock.lock();
+        buffered_ -= chunk.size();
+        broken_ = broken_ || !written;
+        changed_.notify_all();
+      } else {
+        break;
+      }
+    }
+  } catch (...) {
+    if (!lock.owns_lock()) {
+      lock.lock();
+    }
+    // lets the rendering thread finish without waiting for the sender
+    broken_ = true;
+    changed_.notify_all();
+    throw;
+  }
+
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+  return status_;
+}
+
+}  // namespace detail
+}  // namespace prometheus
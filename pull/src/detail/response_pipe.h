@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+
+#include "prometheus/detail/pull_export.h"
+#include "prometheus/scrape_handler.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Passes a response rendered on one thread to the thread sending it.
+///
+/// The rendering thread writes into the pipe as into the connection, the
+/// sending thread forwards everything to the real writer with Drain(). Once
+/// the pipe holds a limited number of bytes, writing waits for the sender.
+/// So the rendering thread does no network I/O and the response is never
+/// held in memory as a whole.
+class PROMETHEUS_CPP_PULL_EXPORT ResponsePipe
+    : public ScrapeHandler::ResponseWriter {
+ public:
+  /// \param max_buffered Bytes held before writing waits for the sender.
+  explicit ResponsePipe(std::size_t max_buffered);
+
+  ResponsePipe(const ResponsePipe&) = delete;
+  ResponsePipe& operator=(const ResponsePipe&) = delete;
+
+  void Begin(const std::string& content_type,
+             const std::string& content_encoding,
+             const std::size_t* content_length) override;
+
+  /// \brief Queues the data, returns false once the sender failed.
+  bool Write(const char* data, std::size_t size) override;
+
+  /// \brief Ends the response, called by the rendering thread.
+  void Close(ScrapeHandler::Status status);
+
+  /// \brief Ends the response with an error rethrown by Drain().
+  void Fail(std::exception_ptr error);
+
+  /// \brief Forwards the response to the writer until the pipe is closed.
+  ///
+  /// \return The status passed to Close().
+  /// \throw The error passed to Fail() or thrown by the writer.
+  ScrapeHandler::Status Drain(ScrapeHandler::ResponseWriter& writer);
+
+ private:
+  const std::size_t max_buffered_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+
+  // not changed anymore once begun_ is set
+  bool begun_ = false;
+  std::string content_type_;
+  std::string content_encoding_;
+  bool has_content_length_ = false;
+  std::size_t content_length_ = 0;
+
+  std::deque<std::string> chunks_;
+  // including the chunk being sent
+  std::size_t buffered_ = 0;
+  // the writer failed, further data is discarded
+  bool broken_ = false;
+  bool closed_ = false;
+  ScrapeHandler::Status status_ = ScrapeHandler::Status::Ok;
+  std::exception_ptr error_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,46 @@
+#include "scrape_admission.h"
+
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+ScrapeAdmission::ScrapeAdmission(std::size_t max_collections,
+                                 std::chrono::milliseconds min_interval)
+    : max_collections_(max_collections), min_interval_(min_interval) {}
+
+ScrapeAdmission::Result ScrapeAdmission::Acquire() {
+  const auto now = Clock::now();
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (max_collections_ > 0 && running_ >= max_collections_) {
+    return Result::Overloaded;
+  }
+  if (started_ && now - last_start_ < min_interval_) {
+    return Result::TooFrequent;
+  }
+  ++running_;
+  started_ = true;
+  last_start_ = now;
+  return Result::Admitted;
+}
+
+void ScrapeAdmission::Release() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  --running_;
+}
+
+void ScrapeAdmission::Keep(const std::string& key,
+                           std::shared_ptr<const CachedResponse> response) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  responses_[key] = std::move(response);
+}
+
+std::shared_ptr<const CachedResponse> ScrapeAdmission::Last(
+    const std::string& key) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto it = responses_.find(key);
+  return it != responses_.end() ? it->second : nullptr;
+}
+
+}  // namespace detail
+}  // namespace prometheus
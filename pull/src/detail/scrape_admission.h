@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "prometheus/detail/pull_export.h"
+#include "response_cache.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Limits how many collections of an endpoint run and how often.
+///
+/// Scrapes ask for admission before they collect the metrics. Those
+/// exceeding a limit are rejected instead of competing with the
+/// application for CPU time. With a minimum interval, the last response of
+/// each key is kept for the scrapes arriving too soon after it.
+class PROMETHEUS_CPP_PULL_EXPORT ScrapeAdmission {
+ public:
+  enum class Result {
+    Admitted,
+    // a collection started less than the minimum interval ago
+    TooFrequent,
+    // the maximum number of collections is running
+    Overloaded,
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  /// \param max_collections Maximum number of concurrent collections, 0
+  /// for no limit.
+  /// \param min_interval Minimum time between the starts of collections.
+  ScrapeAdmission(std::size_t max_collections,
+                  std::chrono::milliseconds min_interval);
+
+  /// \brief Asks to start a collection, which has to be ended with
+  /// Release() if admitted.
+  Result Acquire();
+
+  /// \brief Ends an admitted collection.
+  void Release();
+
+  /// \brief Whether responses are kept, i.e., there is a minimum interval.
+  bool KeepsResponses() const { return min_interval_ > Clock::duration{0}; }
+
+  /// \brief Keeps the response of an admitted collection for the key.
+  void Keep(const std::string& key,
+            std::shared_ptr<const CachedResponse> response);
+
+  /// \brief Returns the last response kept for the key, nullptr if none.
+  std::shared_ptr<const CachedResponse> Last(const std::string& key);
+
+ private:
+  const std::size_t max_collections_;
+  const Clock::duration min_interval_;
+  std::mutex mutex_;
+  std::size_t running_ = 0;
+  bool started_ = false;
+  Clock::time_point last_start_;
+  std::map<std::string, std::shared_ptr<const CachedResponse>> responses_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,112 @@
+#include "scrape_profile.h"
+
+namespace prometheus {
+namespace detail {
+
+namespace {
+std::size_t Index(ScrapePhase phase) { return static_cast<std::size_t>(phase); }
+}  // namespace
+
+ScrapeProfile::Scope::Scope(ScrapeProfile& profile, ScrapePhase phase)
+    : profile_(profile), previous_(profile.Enter(phase)) {}
+
+ScrapeProfile::Scope::~Scope() { profile_.Enter(previous_); }
+
+void ScrapeProfile::Start() {
+  enabled_ = true;
+  current_ = ScrapePhase::None;
+  entered_ = Clock::now();
+  durations_.fill(Clock::duration::zero());
+  used_.fill(false);
+  collectables.clear();
+  families.clear();
+}
+
+void ScrapeProfile::Stop() {
+  Enter(ScrapePhase::None);
+  enabled_ = false;
+}
+
+ScrapePhase ScrapeProfile::Enter(ScrapePhase phase) {
+  const auto previous = current_;
+  if (enabled_ && phase != previous) {
+    const auto now = Clock::now();
+    durations_[Index(previous)] += now - entered_;
+    entered_ = now;
+    current_ = phase;
+    used_[Index(phase)] = true;
+  }
+  return previous;
+}
+
+void ScrapeProfile::Add(ScrapePhase phase, Clock::duration duration) {
+  if (enabled_) {
+    durations_[Index(phase)] += duration;
+    used_[Index(phase)] = true;
+  }
+}
+
+bool ScrapeProfile::Entered(ScrapePhase phase) const {
+  return used_[Index(phase)];
+}
+
+ScrapeProfile::Clock::duration ScrapeProfile::Duration(
+    ScrapePhase phase) const {
+  return durations_[Index(phase)];
+}
+
+ProfilingSink::ProfilingSink(MetricSink& sink, ScrapeProfile& profile)
+    : sink_(sink), profile_(profile) {
+  SetArena(&sink_.GetArena());
+}
+
+void ProfilingSink::BeginFamily(const MetricFamily& family) {
+  family_start_ = ScrapeProfile::Clock::now();
+  profile_.families.push_back(
+      ScrapeProfile::FamilyStats{family.name, {}, 0});
+
+  ScrapeProfile::Scope scope{profile_, ScrapePhase::Serialize};
+  sink_.BeginFamily(family);
+}
+
+void ProfilingSink::AddMetric(const MetricRecord& metric) {
+  ++profile_.families.back().series;
+
+  ScrapeProfile::Scope scope{profile_, ScrapePhase::Serialize};
+  sink_.AddMetric(metric);
+}
+
+void ProfilingSink::EndFamily() {
+  {
+    ScrapeProfile::Scope scope{profile_, ScrapePhase::Serialize};
+    sink_.EndFamily();
+  }
+  profile_.families.back().duration =
+      ScrapeProfile::Clock::now() - family_start_;
+}
+
+bool ProfilingSink::WantsFamily(const std::string& name) const {
+  return sink_.WantsFamily(name);
+}
+
+ProfilingStreamBuffer::ProfilingStreamBuffer(std::streambuf& out,
+                                             ScrapeProfile& profile,
+                                             ScrapePhase phase)
+    : out_(out), profile_(profile), phase_(phase) {}
+
+ProfilingStreamBuffer::int_type ProfilingStreamBuffer::overflow(
+    int_type ch) {
+  ScrapeProfile::Scope scope{profile_, phase_};
+  return traits_type::eq_int_type(ch, traits_type::eof())
+             ? traits_type::not_eof(ch)
+             : out_.sputc(traits_type::to_char_type(ch));
+}
+
+std::streamsize ProfilingStreamBuffer::xsputn(const char_type* s,
+                                              std::streamsize count) {
+  ScrapeProfile::Scope scope{profile_, phase_};
+  return out_.sputn(s, count);
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "prometheus/collectable.h"
+#include "prometheus/detail/pull_export.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Phases a scrape spends its time in.
+enum class ScrapePhase {
+  // not attributed to any phase
+  None,
+  LockWait,
+  Collect,
+  Serialize,
+  Compress,
+  Write,
+};
+
+/// \brief Measures how long a scrape spends in each phase.
+///
+/// Phases nest, e.g., a serializer writing to an encoder compresses while it
+/// serializes. Time is always attributed to the innermost phase only, so the
+/// durations of all phases add up to the duration of the scrape.
+class PROMETHEUS_CPP_PULL_EXPORT ScrapeProfile {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static const std::size_t kPhases =
+      static_cast<std::size_t>(ScrapePhase::Write) + 1;
+
+  struct CollectableStats {
+    std::weak_ptr<Collectable> collectable;
+    Clock::duration duration;
+  };
+
+  struct FamilyStats {
+    std::string name;
+    Clock::duration duration;
+    std::size_t series;
+  };
+
+  /// \brief Enters a phase for the lifetime of the scope.
+  class Scope {
+   public:
+    Scope(ScrapeProfile& profile, ScrapePhase phase);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    ScrapeProfile& profile_;
+    ScrapePhase previous_;
+  };
+
+  /// \brief Starts measuring, discarding all earlier measurements.
+  void Start();
+
+  /// \brief Stops measuring, so later phases are not measured anymore.
+  void Stop();
+
+  bool Enabled() const { return enabled_; }
+
+  /// \brief Switches to the phase.
+  ///
+  /// \return The phase left.
+  ScrapePhase Enter(ScrapePhase phase);
+
+  /// \brief Attributes time measured elsewhere to the phase.
+  void Add(ScrapePhase phase, Clock::duration duration);
+
+  /// \brief Returns whether any time was attributed to the phase.
+  bool Entered(ScrapePhase phase) const;
+
+  Clock::duration Duration(ScrapePhase phase) const;
+
+  /// \brief Duration of each collectable including everything it caused, in
+  /// the order of the collectables.
+  std::vector<CollectableStats> collectables;
+
+  /// \brief Collected families in the order of collection.
+  std::vector<FamilyStats> families;
+
+ private:
+  bool enabled_ = false;
+  ScrapePhase current_ = ScrapePhase::None;
+  Clock::time_point entered_;
+  std::array<Clock::duration, kPhases> durations_{};
+  std::array<bool, kPhases> used_{};
+};
+
+/// \brief Forwards to another sink, attributing the time spent there to
+/// serialization and recording the size and duration of each family.
+class PROMETHEUS_CPP_PULL_EXPORT ProfilingSink : public MetricSink {
+ public:
+  ProfilingSink(MetricSink& sink, ScrapeProfile& profile);
+
+  void BeginFamily(const MetricFamily& family) override;
+  void AddMetric(const MetricRecord& metric) override;
+  void EndFamily() override;
+  bool WantsFamily(const std::string& name) const override;
+
+ private:
+  MetricSink& sink_;
+  ScrapeProfile& profile_;
+  ScrapeProfile::Clock::time_point family_start_;
+};
+
+/// \brief Forwards to another stream buffer, attributing the time spent
+/// there to a phase.
+class PROMETHEUS_CPP_PULL_EXPORT ProfilingStreamBuffer : public std::streambuf {
+ public:
+  ProfilingStreamBuffer(std::streambuf& out, ScrapeProfile& profile,
+                        ScrapePhase phase);
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+
+ private:
+  std::streambuf& out_;
+  ScrapeProfile& profile_;
+  const ScrapePhase phase_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
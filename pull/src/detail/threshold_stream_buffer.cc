@@ -0,0 +1,53 @@
+#include "threshold_stream_buffer.h"
+
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+ThresholdStreamBuffer::ThresholdStreamBuffer(std::size_t threshold,
+                                             std::string& buffer,
+                                             Target target)
+    : threshold_(threshold), buffer_(buffer), target_(std::move(target)) {}
+
+bool ThresholdStreamBuffer::Finish() {
+  if (!out_) {
+    PassOn(true);
+  }
+  return good_;
+}
+
+bool ThresholdStreamBuffer::PassOn(bool complete) {
+  out_ = &target_(complete, buffer_.size());
+  const auto size = static_cast<std::streamsize>(buffer_.size());
+  good_ = out_->sputn(buffer_.data(), size) == size;
+  buffer_.clear();
+  return good_;
+}
+
+ThresholdStreamBuffer::int_type ThresholdStreamBuffer::overflow(int_type ch) {
+  if (traits_type::eq_int_type(ch, traits_type::eof())) {
+    return traits_type::not_eof(ch);
+  }
+  const auto c = traits_type::to_char_type(ch);
+  return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+}
+
+std::streamsize ThresholdStreamBuffer::xsputn(const char_type* s,
+                                              std::streamsize count) {
+  if (!out_) {
+    buffer_.append(s, static_cast<std::size_t>(count));
+    if (buffer_.size() <= threshold_) {
+      return count;
+    }
+    return PassOn(false) ? count : 0;
+  }
+  if (!good_) {
+    return 0;
+  }
+  good_ = out_->sputn(s, count) == count;
+  return good_ ? count : 0;
+}
+
+}  // namespace detail
+}  // namespace prometheus
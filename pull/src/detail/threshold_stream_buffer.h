@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <streambuf>
+#include <string>
+
+#include "prometheus/detail/pull_export.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Stream buffer holding back its content until it is known whether
+/// the content exceeds a threshold.
+///
+/// Allows to choose how to send a response, e.g., whether to compress it,
+/// depending on its size while still streaming large responses.
+class PROMETHEUS_CPP_PULL_EXPORT ThresholdStreamBuffer : public std::streambuf {
+ public:
+  /// \brief Called once to choose where the content goes.
+  ///
+  /// \param complete True if the content did not exceed the threshold, i.e.,
+  /// everything is held back and the size of the content is known.
+  /// \param size Number of bytes held back.
+  using Target =
+      std::function<std::streambuf&(bool complete, std::size_t size)>;
+
+  /// \param threshold Content up to this size is held back.
+  /// \param buffer Memory to hold back the content in.
+  /// \param target Chooses the stream buffer receiving the content.
+  ThresholdStreamBuffer(std::size_t threshold, std::string& buffer,
+                        Target target);
+
+  ThresholdStreamBuffer(const ThresholdStreamBuffer&) = delete;
+  ThresholdStreamBuffer& operator=(const ThresholdStreamBuffer&) = delete;
+
+  /// \brief Passes on content still held back.
+  ///
+  /// \return False if passing on content failed.
+  bool Finish();
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+
+ private:
+  bool PassOn(bool complete);
+
+  const std::size_t threshold_;
+  std::string& buffer_;
+  Target target_;
+  std::streambuf* out_ = nullptr;
+  bool good_ = true;
+};
+
+}  // namespace detail
+}  // namespace prometheus
@@ -9,26 +9,24 @@
 namespace prometheus {
 namespace detail {
 
-Endpoint::Endpoint(CivetServer& server, std::string uri)
+Endpoint::Endpoint(HttpServer& server, std::string uri)
     : server_(server),
       uri_(std::move(uri)),
-      endpoint_registry_(std::make_shared<Registry>()),
-      metrics_handler_(
-          detail::make_unique<MetricsHandler>(*endpoint_registry_)) {
-  RegisterCollectable(endpoint_registry_);
-  server_.addHandler(uri_, metrics_handler_.get());
+      scrape_handler_(detail::make_unique<ScrapeHandler>()),
+      metrics_handler_(detail::make_unique<MetricsHandler>(*scrape_handler_)) {
+  server_.AddHandler(uri_, *metrics_handler_);
 }
 
 Endpoint::~Endpoint() {
-  server_.removeHandler(uri_);
+  server_.RemoveHandler(uri_);
   if (auth_handler_) {
-    server_.removeAuthHandler(uri_);
+    server_.RemoveAuthHandler(uri_);
   }
 }
 
 void Endpoint::RegisterCollectable(
-    const std::weak_ptr<Collectable>& collectable) {
-  metrics_handler_->RegisterCollectable(collectable);
+    const std::weak_ptr<Collectable>& collectable, const std::string& name) {
+  scrape_handler_->RegisterCollectable(collectable, name);
 }
 
 void Endpoint::RegisterAuth(
@@ -38,13 +36,55 @@ void Endpoint::RegisterAuth(
   // being called the second time and the handler is replaced
   auto new_handler =
       detail::make_unique<BasicAuthHandler>(std::move(authCB), realm);
-  server_.addAuthHandler(uri_, new_handler.get());
+  server_.AddAuthHandler(uri_, *new_handler);
   auth_handler_ = std::move(new_handler);
 }
 
 void Endpoint::RemoveCollectable(
     const std::weak_ptr<Collectable>& collectable) {
-  metrics_handler_->RemoveCollectable(collectable);
+  scrape_handler_->RemoveCollectable(collectable);
+}
+
+void Endpoint::SetExternalLabels(const Labels& labels) {
+  scrape_handler_->SetExternalLabels(labels);
+}
+
+void Endpoint::RegisterSerializer(std::shared_ptr<const Serializer> serializer,
+                                  const std::string& content_type) {
+  scrape_handler_->RegisterSerializer(std::move(serializer), content_type);
+}
+
+void Endpoint::SetCompressionOptions(const CompressionOptions& options) {
+  scrape_handler_->SetCompressionOptions(options);
+}
+
+void Endpoint::ShareResponses(std::chrono::milliseconds max_age) {
+  scrape_handler_->ShareResponses(max_age);
+}
+
+void Endpoint::PrerenderResponses(std::chrono::milliseconds interval) {
+  scrape_handler_->PrerenderResponses(interval);
+}
+
+void Endpoint::SetCollectTimeout(std::chrono::milliseconds timeout) {
+  scrape_handler_->SetCollectTimeout(timeout);
+}
+
+void Endpoint::ProfileScrapes(bool enabled) {
+  scrape_handler_->ProfileScrapes(enabled);
+}
+
+void Endpoint::ProfileFamilies(const std::vector<std::string>& names) {
+  scrape_handler_->ProfileFamilies(names);
+}
+
+void Endpoint::LimitCollections(std::size_t max_collections,
+                                std::chrono::milliseconds min_interval) {
+  scrape_handler_->LimitCollections(max_collections, min_interval);
+}
+
+void Endpoint::SetCollectionExecutor(Executor executor) {
+  scrape_handler_->SetCollectionExecutor(std::move(executor));
 }
 
 const std::string& Endpoint::GetURI() const { return uri_; }
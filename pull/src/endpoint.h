@@ -1,13 +1,20 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
-#include "CivetServer.h"
 #include "basic_auth.h"
+#include "detail/http_server.h"
 #include "prometheus/collectable.h"
-#include "prometheus/registry.h"
+#include "prometheus/collection_executor.h"
+#include "prometheus/compression_options.h"
+#include "prometheus/labels.h"
+#include "prometheus/scrape_handler.h"
+#include "prometheus/serializer.h"
 
 namespace prometheus {
 namespace detail {
@@ -15,7 +22,7 @@ class MetricsHandler;
 
 class Endpoint {
  public:
-  explicit Endpoint(CivetServer& server, std::string uri);
+  explicit Endpoint(HttpServer& server, std::string uri);
   ~Endpoint();
 
   Endpoint(const Endpoint&) = delete;
@@ -23,19 +30,31 @@ class Endpoint {
   Endpoint& operator=(const Endpoint&) = delete;
   Endpoint& operator=(Endpoint&&) = delete;
 
-  void RegisterCollectable(const std::weak_ptr<Collectable>& collectable);
+  void RegisterCollectable(const std::weak_ptr<Collectable>& collectable,
+                           const std::string& name);
   void RegisterAuth(
       std::function<bool(const std::string&, const std::string&)> authCB,
       const std::string& realm);
   void RemoveCollectable(const std::weak_ptr<Collectable>& collectable);
+  void SetExternalLabels(const Labels& labels);
+  void RegisterSerializer(std::shared_ptr<const Serializer> serializer,
+                          const std::string& content_type);
+  void SetCompressionOptions(const CompressionOptions& options);
+  void ShareResponses(std::chrono::milliseconds max_age);
+  void PrerenderResponses(std::chrono::milliseconds interval);
+  void SetCollectTimeout(std::chrono::milliseconds timeout);
+  void ProfileScrapes(bool enabled);
+  void ProfileFamilies(const std::vector<std::string>& names);
+  void LimitCollections(std::size_t max_collections,
+                        std::chrono::milliseconds min_interval);
+  void SetCollectionExecutor(Executor executor);
 
   const std::string& GetURI() const;
 
  private:
-  CivetServer& server_;
+  HttpServer& server_;
   const std::string uri_;
-  // registry for "meta" metrics about the endpoint itself
-  std::shared_ptr<Registry> endpoint_registry_;
+  std::unique_ptr<ScrapeHandler> scrape_handler_;
   std::unique_ptr<MetricsHandler> metrics_handler_;
   std::unique_ptr<BasicAuthHandler> auth_handler_;
 };
@@ -2,20 +2,44 @@
 
 #include <algorithm>
 #include <iterator>
+#include <stdexcept>
 #include <string>
 #include <utility>
 
 #include "CivetServer.h"
+#include "civet_server.h"
+#include "detail/epoll_server.h"
+#include "detail/http_server.h"
 #include "endpoint.h"
 #include "prometheus/detail/future_std.h"
 
 namespace prometheus {
 
-Exposer::Exposer(std::shared_ptr<CivetServer> server)
-    : server_(std::move(server)) {
-  if (!server_) {
+namespace {
+
+std::unique_ptr<detail::HttpServer> MakeServer(
+    const std::string& bind_address, ExposerBackend backend,
+    ScrapeHandler::Executor executor) {
+  if (backend == ExposerBackend::Epoll) {
+#ifdef __linux__
+    return detail::make_unique<detail::EpollServer>(bind_address,
+                                                    std::move(executor));
+#else
+    throw std::runtime_error("epoll backend is only available on Linux");
+#endif
+  }
+  return detail::make_unique<detail::CivetHttpServer>(
+      std::make_shared<CivetServer>(std::vector<std::string>{
+          "listening_ports", bind_address, "num_threads", "2"}));
+}
+
+}  // namespace
+
+Exposer::Exposer(std::shared_ptr<CivetServer> server) {
+  if (!server) {
     throw std::invalid_argument("Invalid CivetServer: cannot be null");
   }
+  server_ = detail::make_unique<detail::CivetHttpServer>(std::move(server));
 }
 
 Exposer::Exposer(const std::string& bind_address, const std::size_t num_threads,
@@ -30,13 +54,22 @@ Exposer::Exposer(std::vector<std::string> options,
     : Exposer(std::make_shared<CivetServer>(std::move(options), callbacks)) {
 }
 
-Exposer::~Exposer() = default;
+Exposer::Exposer(const std::string& bind_address, ExposerBackend backend,
+                 ScrapeHandler::Executor executor)
+    : server_(MakeServer(bind_address, backend, std::move(executor))) {}
+
+Exposer::~Exposer() {
+  // waits for running scrapes, so they are done before their endpoints are
+  // destroyed
+  server_->Close();
+}
 
 void Exposer::RegisterCollectable(const std::weak_ptr<Collectable>& collectable,
-                                  const std::string& uri) {
+                                  const std::string& uri,
+                                  const std::string& name) {
   std::lock_guard<std::mutex> lock{mutex_};
   auto& endpoint = GetEndpointForUri(uri);
-  endpoint.RegisterCollectable(collectable);
+  endpoint.RegisterCollectable(collectable, name);
 }
 
 void Exposer::RegisterAuth(
@@ -54,8 +87,78 @@ void Exposer::RemoveCollectable(const std::weak_ptr<Collectable>& collectable,
   endpoint.RemoveCollectable(collectable);
 }
 
+void Exposer::SetExternalLabels(const Labels& labels, const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.SetExternalLabels(labels);
+}
+
+void Exposer::RegisterSerializer(std::shared_ptr<const Serializer> serializer,
+                                 const std::string& content_type,
+                                 const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.RegisterSerializer(std::move(serializer), content_type);
+}
+
+void Exposer::SetCompressionOptions(const CompressionOptions& options,
+                                    const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.SetCompressionOptions(options);
+}
+
+void Exposer::ShareResponses(std::chrono::milliseconds max_age,
+                             const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.ShareResponses(max_age);
+}
+
+void Exposer::PrerenderResponses(std::chrono::milliseconds interval,
+                                 const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.PrerenderResponses(interval);
+}
+
+void Exposer::SetCollectTimeout(std::chrono::milliseconds timeout,
+                                const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.SetCollectTimeout(timeout);
+}
+
+void Exposer::ProfileScrapes(bool enabled, const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.ProfileScrapes(enabled);
+}
+
+void Exposer::ProfileFamilies(const std::vector<std::string>& names,
+                              const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.ProfileFamilies(names);
+}
+
+void Exposer::LimitCollections(std::size_t max_collections,
+                               std::chrono::milliseconds min_interval,
+                               const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.LimitCollections(max_collections, min_interval);
+}
+
+void Exposer::SetCollectionExecutor(Executor executor,
+                                    const std::string& uri) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& endpoint = GetEndpointForUri(uri);
+  endpoint.SetCollectionExecutor(std::move(executor));
+}
+
 std::vector<int> Exposer::GetListeningPorts() const {
-  return server_->getListeningPorts();
+  return server_->GetListeningPorts();
 }
 
 detail::Endpoint& Exposer::GetEndpointForUri(const std::string& uri) {
@@ -1,39 +1,19 @@
 #pragma once
 
-#include <memory>
-#include <mutex>
-#include <vector>
-
-#include "CivetServer.h"
-#include "prometheus/collectable.h"
-#include "prometheus/counter.h"
-#include "prometheus/family.h"
-#include "prometheus/registry.h"
-#include "prometheus/summary.h"
+#include "detail/http_server.h"
+#include "prometheus/scrape_handler.h"
 
 namespace prometheus {
 namespace detail {
-class MetricsHandler : public CivetHandler {
+/// \brief Serves the scrapes of an endpoint over HTTP.
+class MetricsHandler : public HttpHandler {
  public:
-  explicit MetricsHandler(Registry& registry);
-
-  void RegisterCollectable(const std::weak_ptr<Collectable>& collectable);
-  void RemoveCollectable(const std::weak_ptr<Collectable>& collectable);
+  explicit MetricsHandler(ScrapeHandler& scrape_handler);
 
-  bool handleGet(CivetServer* server, struct mg_connection* conn) override;
+  bool HandleGet(HttpConnection& conn) override;
 
  private:
-  static void CleanupStalePointers(
-      std::vector<std::weak_ptr<Collectable>>& collectables);
-
-  std::mutex collectables_mutex_;
-  std::vector<std::weak_ptr<Collectable>> collectables_;
-  Family<Counter>& bytes_transferred_family_;
-  Counter& bytes_transferred_;
-  Family<Counter>& num_scrapes_family_;
-  Counter& num_scrapes_;
-  Family<Summary>& request_latencies_family_;
-  Summary& request_latencies_;
+  ScrapeHandler& scrape_handler_;
 };
 }  // namespace detail
 }  // namespace prometheus
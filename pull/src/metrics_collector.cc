@@ -3,6 +3,7 @@
 #include <iterator>
 
 #include "prometheus/collectable.h"
+#include "prometheus/metric_sink.h"
 
 namespace prometheus {
 namespace detail {
@@ -26,5 +27,18 @@ std::vector<MetricFamily> CollectMetrics(
   return collected_metrics;
 }
 
+void CollectMetrics(
+    const std::vector<std::weak_ptr<prometheus::Collectable>>& collectables,
+    prometheus::MetricSink& sink) {
+  for (auto&& wcollectable : collectables) {
+    auto collectable = wcollectable.lock();
+    if (!collectable) {
+      continue;
+    }
+
+    collectable->Collect(sink);
+  }
+}
+
 }  // namespace detail
 }  // namespace prometheus
@@ -7,8 +7,13 @@
 
 namespace prometheus {
 class Collectable;
+class MetricSink;
 namespace detail {
 std::vector<prometheus::MetricFamily> CollectMetrics(
     const std::vector<std::weak_ptr<prometheus::Collectable>>& collectables);
+
+void CollectMetrics(
+    const std::vector<std::weak_ptr<prometheus::Collectable>>& collectables,
+    prometheus::MetricSink& sink);
 }  // namespace detail
 }  // namespace prometheus
@@ -0,0 +1,36 @@
+#include "scrape_arena.h"
+
+#include <utility>
+
+#include "prometheus/detail/future_std.h"
+
+namespace prometheus {
+namespace detail {
+
+std::unique_ptr<ScrapeArena> ScrapeArenaPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (!arenas_.empty()) {
+      auto arena = std::move(arenas_.back());
+      arenas_.pop_back();
+      return arena;
+    }
+  }
+
+  return detail::make_unique<ScrapeArena>();
+}
+
+void ScrapeArenaPool::Release(std::unique_ptr<ScrapeArena> arena) {
+  arena->collectables.reset();
+  arena->deadline_collector.reset();
+  arena->records.Clear();
+  arena->head.clear();
+  arena->filter.Clear();
+  arena->profile.Stop();
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  arenas_.push_back(std::move(arena));
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "detail/deadline_collector.h"
+#include "detail/family_filter.h"
+#include "detail/scrape_profile.h"
+#include "prometheus/collectable.h"
+#include "prometheus/metric_record.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Memory needed to serve a single scrape.
+///
+/// Arenas are handed out by a ScrapeArenaPool and reused for later scrapes,
+/// so after warming up a scrape does not allocate memory for collection,
+/// serialization or compression anymore. The response is streamed through
+/// fixed-size buffers, so the memory of an arena does not grow with the size
+/// of the registry.
+struct ScrapeArena {
+  // size of the chunks of the response and of the compression buffer
+  static const std::size_t kBufferSize = 32 * 1024;
+
+  ScrapeArena() : chunk(kBufferSize), compressed(kBufferSize) {}
+
+  std::shared_ptr<const std::vector<std::weak_ptr<Collectable>>> collectables;
+  // collects with a deadline if set
+  std::shared_ptr<DeadlineCollector> deadline_collector;
+  std::chrono::steady_clock::time_point deadline;
+  std::string content_type;
+  // families asked for by the scrape
+  FamilyFilter filter;
+  std::string head;
+  MetricRecordArena records;
+  std::vector<char> chunk;
+  std::vector<char> compressed;
+  // only measures if started
+  ScrapeProfile profile;
+};
+
+class ScrapeArenaPool {
+ public:
+  /// \brief Returns an unused arena, allocating a new one if none is left.
+  std::unique_ptr<ScrapeArena> Acquire();
+
+  /// \brief Returns the arena to the pool, keeping its allocated memory.
+  void Release(std::unique_ptr<ScrapeArena> arena);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ScrapeArena>> arenas_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
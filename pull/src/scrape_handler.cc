@@ -0,0 +1,884 @@
+#include "prometheus/scrape_handler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "detail/chunk_stream_buffer.h"
+#include "detail/content_negotiation.h"
+#include "detail/deadline_collector.h"
+#include "detail/prerenderer.h"
+#include "detail/response_pipe.h"
+#include "detail/response_cache.h"
+#include "detail/scrape_admission.h"
+#include "detail/scrape_profile.h"
+#include "detail/threshold_stream_buffer.h"
+#include "metrics_collector.h"
+#include "prometheus/counter.h"
+#include "prometheus/detail/content_codec.h"
+#include "prometheus/detail/future_std.h"
+#include "prometheus/detail/gzip_codec.h"
+#include "prometheus/detail/zstd_codec.h"
+#include "prometheus/histogram.h"
+#include "prometheus/metric_sink.h"
+#include "prometheus/serializer.h"
+#include "prometheus/summary.h"
+#include "scrape_arena.h"
+
+namespace prometheus {
+
+struct ScrapeHandler::Settings {
+  using CollectableNames =
+      std::map<std::weak_ptr<Collectable>, std::string,
+               std::owner_less<std::weak_ptr<Collectable>>>;
+
+  std::shared_ptr<const Collectables> collectables =
+      std::make_shared<const Collectables>();
+  // names of the collectables profiled individually
+  std::shared_ptr<const CollectableNames> collectable_names =
+      std::make_shared<const CollectableNames>();
+  // families profiled individually, sorted
+  std::shared_ptr<const std::vector<std::string>> profiled_families =
+      std::make_shared<const std::vector<std::string>>();
+  std::shared_ptr<const Labels> external_labels;
+  detail::ContentNegotiator negotiator;
+  std::shared_ptr<const detail::Codecs> codecs;
+  std::size_t min_compressed_size = 0;
+  std::shared_ptr<detail::ResponseCache> response_cache;
+  std::shared_ptr<detail::DeadlineCollector> deadline_collector;
+  std::chrono::milliseconds collect_timeout{0};
+  std::shared_ptr<detail::ScrapeAdmission> admission;
+  Executor collection_executor;
+  bool profile_scrapes = false;
+
+  // histograms observed by profiled scrapes
+  struct ProfileHistograms {
+    std::array<Histogram*, detail::ScrapeProfile::kPhases> phases{};
+    std::map<std::weak_ptr<Collectable>, Histogram*,
+             std::owner_less<std::weak_ptr<Collectable>>>
+        collectables;
+    std::map<std::string, Histogram*> family_durations;
+    std::map<std::string, Histogram*> family_series;
+  };
+  // resolved whenever the settings change while profiling, so scrapes only
+  // observe, nullptr if not profiling
+  std::shared_ptr<const ProfileHistograms> profile_histograms;
+};
+
+namespace detail {
+
+// bytes of a response rendered on the collection executor that may wait for
+// the calling thread to send them
+static const std::size_t kMaxPipedBytes = 4 * ScrapeArena::kBufferSize;
+
+static const char* NullIfEmpty(const std::string& text) {
+  return text.empty() ? nullptr : text.c_str();
+}
+
+// Leaves a quarter of the timeout Prometheus sends for serializing and
+// sending the response
+static std::chrono::steady_clock::time_point CollectDeadline(
+    const std::string& scrape_timeout_seconds,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::milliseconds timeout) {
+  auto deadline = start + timeout;
+
+  if (!scrape_timeout_seconds.empty()) {
+    const auto seconds = std::strtod(scrape_timeout_seconds.c_str(), nullptr);
+    if (seconds > 0 && seconds < 365 * 24 * 3600) {
+      const auto scrape_timeout =
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>{seconds * 0.75});
+      deadline = std::min(deadline, start + scrape_timeout);
+    }
+  }
+  return deadline;
+}
+
+static void CollectMetrics(ScrapeArena& arena, MetricSink& sink) {
+  auto& profile = arena.profile;
+  if (!profile.Enabled()) {
+    if (arena.deadline_collector) {
+      arena.deadline_collector->Collect(*arena.collectables, arena.filter,
+                                        arena.deadline, sink);
+    } else {
+      CollectMetrics(*arena.collectables, sink);
+    }
+    return;
+  }
+
+  ProfilingSink profiling{sink, profile};
+  if (arena.deadline_collector) {
+    ScrapeProfile::Scope scope{profile, ScrapePhase::Collect};
+    arena.deadline_collector->Collect(*arena.collectables, arena.filter,
+                                      arena.deadline, profiling);
+    return;
+  }
+  for (const auto& wcollectable : *arena.collectables) {
+    auto collectable = wcollectable.lock();
+    if (!collectable) {
+      continue;
+    }
+
+    const auto start = ScrapeProfile::Clock::now();
+    {
+      ScrapeProfile::Scope scope{profile, ScrapePhase::Collect};
+      collectable->Collect(profiling);
+    }
+    profile.collectables.push_back(ScrapeProfile::CollectableStats{
+        wcollectable, ScrapeProfile::Clock::now() - start});
+  }
+}
+
+// Families not asked for are not collected at all by collectables checking
+// MetricSink::WantsFamily()
+static void CollectSelected(ScrapeArena& arena, MetricSink& sink) {
+  if (arena.filter.Empty()) {
+    CollectMetrics(arena, sink);
+  } else {
+    FilteringSink filtered{sink, arena.filter};
+    CollectMetrics(arena, filtered);
+  }
+}
+
+// Serializes while collecting
+static void Collect(std::ostream& body, ScrapeArena& arena,
+                    const Serializer& serializer,
+                    const Labels* external_labels) {
+  auto sink = serializer.MakeSink(body);
+  sink->SetArena(&arena.records);
+
+  if (!external_labels) {
+    CollectSelected(arena, *sink);
+  } else {
+    ExternalLabelsSink labeled{*sink, *external_labels};
+    CollectSelected(arena, labeled);
+  }
+  sink->Finish();
+}
+
+// Renders the whole response into memory
+static CachedResponse Render(ScrapeArena& arena, const Serializer& serializer,
+                             const Labels* external_labels, const Codec* codec,
+                             std::size_t min_size) {
+  auto response = CachedResponse{};
+  std::ostringstream body;
+  Collect(body, arena, serializer, external_labels);
+  response.body = body.str();
+
+  if (codec && response.body.size() >= min_size) {
+    ScrapeProfile::Scope scope{arena.profile, ScrapePhase::Compress};
+    std::ostringstream compressed;
+    const auto size = static_cast<std::streamsize>(response.body.size());
+    auto encoder = codec->MakeEncoder(*compressed.rdbuf(), arena.compressed);
+    if (encoder->Good() &&
+        encoder->sputn(response.body.data(), size) == size &&
+        encoder->Finish()) {
+      response.body = compressed.str();
+      response.content_encoding = codec->Name();
+    }
+  }
+  return response;
+}
+
+static std::size_t SendResponse(ScrapeHandler::ResponseWriter& writer,
+                                ScrapeArena& arena,
+                                const CachedResponse& response) {
+  ScrapeProfile::Scope scope{arena.profile, ScrapePhase::Write};
+  const auto size = response.body.size();
+  writer.Begin(arena.content_type, response.content_encoding, &size);
+  writer.Write(response.body.data(), size);
+  return size;
+}
+
+static std::size_t StreamResponse(ScrapeHandler::ResponseWriter& writer,
+                                  ScrapeArena& arena,
+                                  const Serializer& serializer,
+                                  const Labels* external_labels,
+                                  const Codec* codec, std::size_t min_size) {
+  ChunkStreamBuffer chunks{
+      [&writer, &arena](const char* data, std::size_t size) {
+        ScrapeProfile::Scope scope{arena.profile, ScrapePhase::Write};
+        return writer.Write(data, size);
+      },
+      arena.chunk};
+  std::unique_ptr<Encoder> encoder;
+  std::unique_ptr<ProfilingStreamBuffer> profiled_encoder;
+
+  // starts the response and returns where the body goes
+  auto begin_body = [&](bool compressed, bool complete,
+                        std::size_t size) -> std::streambuf& {
+    if (compressed) {
+      encoder = codec->MakeEncoder(chunks, arena.compressed);
+      if (encoder->Good()) {
+        writer.Begin(arena.content_type, codec->Name(), nullptr);
+        if (arena.profile.Enabled()) {
+          profiled_encoder = detail::make_unique<ProfilingStreamBuffer>(
+              *encoder, arena.profile, ScrapePhase::Compress);
+          return *profiled_encoder;
+        }
+        return *encoder;
+      }
+      encoder.reset();
+    }
+    writer.Begin(arena.content_type, std::string{},
+                 complete ? &size : nullptr);
+    return chunks;
+  };
+
+  std::unique_ptr<ThresholdStreamBuffer> threshold;
+  std::streambuf* body_buffer = nullptr;
+  if (codec && min_size > 0) {
+    // small responses are not worth the CPU time of compressing them
+    threshold = detail::make_unique<ThresholdStreamBuffer>(
+        min_size - 1, arena.head,
+        [&](bool complete, std::size_t size) -> std::streambuf& {
+          return begin_body(!complete, complete, size);
+        });
+    body_buffer = threshold.get();
+  } else {
+    body_buffer = &begin_body(codec != nullptr, false, 0);
+  }
+
+  {
+    // serialize while collecting and send each chunk as soon as it is full,
+    // so neither the samples nor the response are held in memory as a whole
+    std::ostream body{body_buffer};
+    Collect(body, arena, serializer, external_labels);
+  }
+
+  if (threshold) {
+    threshold->Finish();
+  }
+  if (encoder) {
+    ScrapeProfile::Scope scope{arena.profile, ScrapePhase::Compress};
+    encoder->Finish();
+  }
+  chunks.Flush();
+  return chunks.BytesWritten();
+}
+
+static std::string ResponseKey(const ScrapeArena& arena, const Codec* codec) {
+  auto key = arena.content_type;
+  if (codec) {
+    key.append(";").append(codec->Name());
+  }
+  return key;
+}
+
+// Keeps the response of a scrape in memory
+class StringWriter : public ScrapeHandler::ResponseWriter {
+ public:
+  explicit StringWriter(ScrapeHandler::Response& response)
+      : response_(response) {}
+
+  void Begin(const std::string& content_type,
+             const std::string& content_encoding,
+             const std::size_t* content_length) override {
+    response_.content_type = content_type;
+    response_.content_encoding = content_encoding;
+    if (content_length) {
+      response_.body.reserve(*content_length);
+    }
+  }
+
+  bool Write(const char* data, std::size_t size) override {
+    response_.body.append(data, size);
+    return true;
+  }
+
+ private:
+  ScrapeHandler::Response& response_;
+};
+
+// Thrown by a shared response's producer if its collection is rejected
+struct RejectedCollection {
+  ScrapeHandler::Status status;
+};
+
+// Ends an admitted collection when it goes out of scope
+class AdmissionTicket {
+ public:
+  explicit AdmissionTicket(ScrapeAdmission* admission)
+      : admission_(admission) {
+    if (!admission_) {
+      return;
+    }
+    switch (admission_->Acquire()) {
+      case ScrapeAdmission::Result::Admitted:
+        break;
+      case ScrapeAdmission::Result::TooFrequent:
+        status_ = ScrapeHandler::Status::TooFrequent;
+        admission_ = nullptr;
+        break;
+      case ScrapeAdmission::Result::Overloaded:
+        status_ = ScrapeHandler::Status::Overloaded;
+        admission_ = nullptr;
+        break;
+    }
+  }
+
+  ~AdmissionTicket() {
+    if (admission_) {
+      admission_->Release();
+    }
+  }
+
+  AdmissionTicket(const AdmissionTicket&) = delete;
+  AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+
+  ScrapeHandler::Status Status() const { return status_; }
+
+ private:
+  ScrapeAdmission* admission_;
+  ScrapeHandler::Status status_ = ScrapeHandler::Status::Ok;
+};
+
+static void CleanupStalePointers(
+    std::vector<std::weak_ptr<Collectable>>& collectables) {
+  collectables.erase(
+      std::remove_if(std::begin(collectables), std::end(collectables),
+                     [](const std::weak_ptr<Collectable>& candidate) {
+                       return candidate.expired();
+                     }),
+      std::end(collectables));
+}
+
+}  // namespace detail
+
+ScrapeHandler::ScrapeHandler()
+    : settings_(std::make_shared<const Settings>()),
+      arena_pool_(detail::make_unique<detail::ScrapeArenaPool>()),
+      registry_(std::make_shared<Registry>()),
+      bytes_transferred_family_(
+          BuildCounter()
+              .Name("exposer_transferred_bytes_total")
+              .Help("Transferred bytes to metrics services")
+              .Register(*registry_)),
+      bytes_transferred_(bytes_transferred_family_.Add({})),
+      num_scrapes_family_(BuildCounter()
+                              .Name("exposer_scrapes_total")
+                              .Help("Number of times metrics were scraped")
+                              .Register(*registry_)),
+      num_scrapes_(num_scrapes_family_.Add({})),
+      request_latencies_family_(
+          BuildSummary()
+              .Name("exposer_request_latencies")
+              .Help("Latencies of serving scrape requests, in microseconds")
+              .Register(*registry_)),
+      request_latencies_(request_latencies_family_.Add(
+          {}, Summary::Quantiles{{0.5, 0.05}, {0.9, 0.01}, {0.99, 0.001}})),
+      shared_responses_family_(
+          BuildCounter()
+              .Name("exposer_shared_responses_total")
+              .Help("Scrapes of endpoints sharing responses, by whether an "
+                    "earlier response was reused")
+              .Register(*registry_)),
+      shared_response_hits_(shared_responses_family_.Add({{"result", "hit"}})),
+      shared_response_coalesced_(
+          shared_responses_family_.Add({{"result", "coalesced"}})),
+      shared_response_misses_(
+          shared_responses_family_.Add({{"result", "miss"}})),
+      late_collections_family_(
+          BuildCounter()
+              .Name("exposer_late_collections_total")
+              .Help("Collectables not collected by the deadline of a scrape, "
+                    "by whether their previous result was reused")
+              .Register(*registry_)),
+      late_collections_reused_(
+          late_collections_family_.Add({{"result", "reused"}})),
+      late_collections_dropped_(
+          late_collections_family_.Add({{"result", "dropped"}})),
+      rejected_scrapes_family_(
+          BuildCounter()
+              .Name("exposer_rejected_scrapes_total")
+              .Help("Scrapes rejected instead of collecting, by whether the "
+                    "endpoint collected too recently or too often at once")
+              .Register(*registry_)),
+      rejected_too_frequent_(
+          rejected_scrapes_family_.Add({{"reason", "too_frequent"}})),
+      rejected_overloaded_(
+          rejected_scrapes_family_.Add({{"reason", "overloaded"}})),
+      phase_durations_family_(
+          BuildHistogram()
+              .Name("exposer_scrape_phase_duration_seconds")
+              .Help("Time scrapes spent in each phase, if profiled")
+              .Register(*registry_)),
+      collectable_durations_family_(
+          BuildHistogram()
+              .Name("exposer_collectable_duration_seconds")
+              .Help("Time scrapes spent on each collectable including "
+                    "serializing its metrics, if profiled")
+              .Register(*registry_)),
+      family_durations_family_(
+          BuildHistogram()
+              .Name("exposer_family_duration_seconds")
+              .Help("Time scrapes spent on each metric family including "
+                    "serializing it, if profiled")
+              .Register(*registry_)),
+      family_series_family_(
+          BuildHistogram()
+              .Name("exposer_family_series")
+              .Help("Number of time series of each metric family per scrape, "
+                    "if profiled")
+              .Register(*registry_)) {
+  RegisterCollectable(registry_, "exposer");
+  SetCompressionOptions(CompressionOptions{});
+}
+
+ScrapeHandler::~ScrapeHandler() {
+  // stop rendering in the background before the members it uses are gone
+  prerenderer_.reset();
+  // joins the collection threads, which count into the registry
+  std::atomic_store(&settings_, std::shared_ptr<const Settings>{});
+}
+
+std::shared_ptr<const ScrapeHandler::Settings> ScrapeHandler::GetSettings()
+    const {
+  return std::atomic_load(&settings_);
+}
+
+void ScrapeHandler::UpdateSettings(
+    const std::function<void(Settings&)>& update) {
+  // scrapes keep using the settings they started with, so only concurrent
+  // updates have to wait for each other
+  std::lock_guard<std::mutex> lock{settings_mutex_};
+  auto settings = std::make_shared<Settings>(*GetSettings());
+  update(*settings);
+  ResolveProfileHistograms(*settings);
+  std::atomic_store(&settings_,
+                    std::shared_ptr<const Settings>{std::move(settings)});
+}
+
+void ScrapeHandler::RegisterCollectable(
+    const std::weak_ptr<Collectable>& collectable, const std::string& name) {
+  UpdateSettings([&collectable, &name](Settings& settings) {
+    auto collectables = *settings.collectables;
+    detail::CleanupStalePointers(collectables);
+    collectables.push_back(collectable);
+    settings.collectables =
+        std::make_shared<const Collectables>(std::move(collectables));
+
+    auto names = *settings.collectable_names;
+    for (auto it = names.begin(); it != names.end();) {
+      it = it->first.expired() ? names.erase(it) : std::next(it);
+    }
+    if (!name.empty()) {
+      names[collectable] = name;
+    }
+    settings.collectable_names =
+        std::make_shared<const Settings::CollectableNames>(std::move(names));
+  });
+}
+
+void ScrapeHandler::RemoveCollectable(
+    const std::weak_ptr<Collectable>& collectable) {
+  auto locked = collectable.lock();
+  auto same_pointer = [&locked](const std::weak_ptr<Collectable>& candidate) {
+    return locked == candidate.lock();
+  };
+
+  UpdateSettings([&same_pointer, &collectable](Settings& settings) {
+    auto collectables = *settings.collectables;
+    collectables.erase(std::remove_if(std::begin(collectables),
+                                      std::end(collectables), same_pointer),
+                       std::end(collectables));
+    settings.collectables =
+        std::make_shared<const Collectables>(std::move(collectables));
+
+    if (settings.collectable_names->count(collectable) != 0) {
+      auto names = *settings.collectable_names;
+      names.erase(collectable);
+      settings.collectable_names =
+          std::make_shared<const Settings::CollectableNames>(
+              std::move(names));
+    }
+  });
+}
+
+void ScrapeHandler::SetExternalLabels(const Labels& labels) {
+  auto external_labels =
+      labels.empty() ? nullptr : std::make_shared<const Labels>(labels);
+
+  UpdateSettings([&external_labels](Settings& settings) {
+    settings.external_labels = std::move(external_labels);
+  });
+}
+
+void ScrapeHandler::RegisterSerializer(
+    std::shared_ptr<const Serializer> serializer,
+    const std::string& content_type) {
+  UpdateSettings([&serializer, &content_type](Settings& settings) {
+    settings.negotiator.Register(std::move(serializer), content_type);
+  });
+}
+
+void ScrapeHandler::SetCompressionOptions(const CompressionOptions& options) {
+  auto codecs = std::make_shared<detail::Codecs>();
+  if (options.level != 0) {
+    auto parameters = detail::GzipParameters{};
+    parameters.level = options.level;
+    parameters.memory_level = options.memory_level;
+    parameters.strategy = options.strategy;
+    // codecs not built into the library are left out
+    for (auto& codec : {detail::MakeZstdCodec(options.zstd_level),
+                        detail::MakeGzipCodec(parameters)}) {
+      if (codec) {
+        codecs->push_back(codec);
+      }
+    }
+  }
+
+  UpdateSettings([&codecs, &options](Settings& settings) {
+    settings.codecs = std::move(codecs);
+    settings.min_compressed_size = options.min_size;
+  });
+
+  auto prerenderer = std::atomic_load(&prerenderer_);
+  if (prerenderer) {
+    prerenderer->Clear();
+  }
+}
+
+void ScrapeHandler::ShareResponses(std::chrono::milliseconds max_age) {
+  auto response_cache = std::make_shared<detail::ResponseCache>(max_age);
+
+  UpdateSettings([&response_cache](Settings& settings) {
+    settings.response_cache = std::move(response_cache);
+  });
+}
+
+void ScrapeHandler::PrerenderResponses(std::chrono::milliseconds interval) {
+  std::atomic_store(&prerenderer_,
+                    std::make_shared<detail::Prerenderer>(interval));
+}
+
+void ScrapeHandler::SetCollectTimeout(std::chrono::milliseconds timeout) {
+  auto deadline_collector = std::make_shared<detail::DeadlineCollector>(
+      late_collections_reused_, late_collections_dropped_);
+
+  UpdateSettings([&deadline_collector, timeout](Settings& settings) {
+    settings.deadline_collector = std::move(deadline_collector);
+    settings.collect_timeout = timeout;
+  });
+}
+
+void ScrapeHandler::ProfileScrapes(bool enabled) {
+  UpdateSettings(
+      [enabled](Settings& settings) { settings.profile_scrapes = enabled; });
+}
+
+void ScrapeHandler::ProfileFamilies(const std::vector<std::string>& names) {
+  auto families = std::make_shared<std::vector<std::string>>(names);
+  std::sort(families->begin(), families->end());
+
+  UpdateSettings([&families](Settings& settings) {
+    settings.profiled_families = std::move(families);
+  });
+}
+
+void ScrapeHandler::LimitCollections(std::size_t max_collections,
+                                     std::chrono::milliseconds min_interval) {
+  auto admission =
+      std::make_shared<detail::ScrapeAdmission>(max_collections, min_interval);
+
+  UpdateSettings([&admission](Settings& settings) {
+    settings.admission = std::move(admission);
+  });
+}
+
+void ScrapeHandler::SetCollectionExecutor(Executor executor) {
+  UpdateSettings([&executor](Settings& settings) {
+    settings.collection_executor = std::move(executor);
+  });
+}
+
+ScrapeHandler::Status ScrapeHandler::Handle(const Request& request,
+                                            ResponseWriter& writer) {
+  const auto settings = GetSettings();
+  if (!settings->collection_executor) {
+    return Serve(request, writer);
+  }
+
+  // rendered on the executor and sent from the calling thread while it is
+  // rendered, the pipe outlives this call if the writer throws
+  auto pipe = std::make_shared<detail::ResponsePipe>(detail::kMaxPipedBytes);
+  settings->collection_executor([this, request, pipe] {
+    try {
+      pipe->Close(Serve(request, *pipe));
+    } catch (...) {
+      pipe->Fail(std::current_exception());
+    }
+  });
+  return pipe->Drain(writer);
+}
+
+ScrapeHandler::Status ScrapeHandler::Serve(const Request& request,
+                                           ResponseWriter& writer) {
+  using detail::ScrapePhase;
+  auto start_time_of_request = std::chrono::steady_clock::now();
+
+  // taken without locking, so neither concurrent scrapes nor registering
+  // collectables wait for each other
+  const auto settings = GetSettings();
+  auto prerenderer = std::atomic_load(&prerenderer_);
+  auto response_cache = settings->response_cache;
+  const auto lock_wait =
+      std::chrono::steady_clock::now() - start_time_of_request;
+
+  auto arena = arena_pool_->Acquire();
+  arena->filter.Parse(detail::NullIfEmpty(request.query_string));
+  if (!arena->filter.Empty()) {
+    // only complete responses are shared, keeping one for every filter a
+    // client makes up would grow without bound
+    prerenderer.reset();
+    response_cache.reset();
+  }
+
+  const auto& format =
+      settings->negotiator.Select(detail::NullIfEmpty(request.accept));
+  const auto& serializer = format.serializer;
+  arena->content_type = format.content_type;
+  if (!prerenderer) {
+    arena->collectables = settings->collectables;
+    arena->deadline_collector = settings->deadline_collector;
+  }
+
+  const auto codecs = settings->codecs;
+  const auto* codec = detail::SelectCodec(
+      detail::NullIfEmpty(request.accept_encoding), *codecs);
+  const auto min_size = settings->min_compressed_size;
+  const auto* external_labels = settings->external_labels.get();
+  const auto key = detail::ResponseKey(*arena, codec);
+
+  // scrapes arriving within the minimum interval are served the response
+  // of the last collection, only rejected if there is none yet
+  auto* admission = settings->admission.get();
+  const auto keep_response =
+      admission && admission->KeepsResponses() && arena->filter.Empty();
+  std::shared_ptr<const detail::CachedResponse> last_response;
+  // returns false if the last response is served instead
+  auto reject = [&](Status status) {
+    if (status == Status::TooFrequent && keep_response) {
+      last_response = admission->Last(key);
+      if (last_response) {
+        return false;
+      }
+    }
+    (status == Status::TooFrequent ? rejected_too_frequent_
+                                   : rejected_overloaded_)
+        .Increment();
+    arena_pool_->Release(std::move(arena));
+    return true;
+  };
+
+  // responses rendered in the background or shared with other scrapes do
+  // not need a collection of their own
+  std::unique_ptr<detail::AdmissionTicket> ticket;
+  if (!prerenderer && !response_cache) {
+    ticket = detail::make_unique<detail::AdmissionTicket>(admission);
+    if (ticket->Status() != Status::Ok && reject(ticket->Status())) {
+      return ticket->Status();
+    }
+  }
+
+  if (settings->profile_scrapes) {
+    arena->profile.Start();
+    arena->profile.Add(ScrapePhase::LockWait, lock_wait);
+  }
+  if (arena->deadline_collector) {
+    arena->deadline = detail::CollectDeadline(request.scrape_timeout_seconds,
+                                              start_time_of_request,
+                                              settings->collect_timeout);
+  }
+
+  std::size_t bodySize;
+  if (last_response) {
+    bodySize = detail::SendResponse(writer, *arena, *last_response);
+  } else if (prerenderer) {
+    // rendered in the background with the collectables of that time
+    auto render = [this, serializer, codecs, codec, min_size] {
+      const auto settings = GetSettings();
+      auto arena = arena_pool_->Acquire();
+      arena->collectables = settings->collectables;
+      arena->deadline_collector = settings->deadline_collector;
+      arena->deadline =
+          std::chrono::steady_clock::now() + settings->collect_timeout;
+      if (settings->profile_scrapes) {
+        arena->profile.Start();
+      }
+      auto response = detail::Render(*arena, *serializer,
+                                     settings->external_labels.get(), codec,
+                                     min_size);
+      RecordProfile(arena->profile);
+      arena_pool_->Release(std::move(arena));
+      return response;
+    };
+    const auto response = prerenderer->Get(key, render);
+    bodySize = detail::SendResponse(writer, *arena, *response);
+  } else if (response_cache) {
+    auto result = detail::ResponseCache::Result::Miss;
+    std::shared_ptr<const detail::CachedResponse> response;
+    try {
+      response = response_cache->Get(
+          key,
+          [&] {
+            detail::AdmissionTicket ticket{admission};
+            if (ticket.Status() != Status::Ok) {
+              throw detail::RejectedCollection{ticket.Status()};
+            }
+            return detail::Render(*arena, *serializer, external_labels,
+                                  codec, min_size);
+          },
+          result);
+    } catch (const detail::RejectedCollection& rejected) {
+      if (reject(rejected.status)) {
+        return rejected.status;
+      }
+      response = last_response;
+    }
+    if (!last_response) {
+      switch (result) {
+        case detail::ResponseCache::Result::Hit:
+          shared_response_hits_.Increment();
+          break;
+        case detail::ResponseCache::Result::Coalesced:
+          shared_response_coalesced_.Increment();
+          break;
+        case detail::ResponseCache::Result::Miss:
+          shared_response_misses_.Increment();
+          if (keep_response) {
+            admission->Keep(key, response);
+          }
+          break;
+      }
+    }
+    bodySize = detail::SendResponse(writer, *arena, *response);
+  } else if (keep_response) {
+    auto response = std::make_shared<const detail::CachedResponse>(
+        detail::Render(*arena, *serializer, external_labels, codec,
+                       min_size));
+    admission->Keep(key, response);
+    bodySize = detail::SendResponse(writer, *arena, *response);
+  } else {
+    bodySize = detail::StreamResponse(writer, *arena, *serializer,
+                                      external_labels, codec, min_size);
+  }
+  RecordProfile(arena->profile);
+  arena_pool_->Release(std::move(arena));
+
+  auto stop_time_of_request = std::chrono::steady_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+      stop_time_of_request - start_time_of_request);
+  request_latencies_.Observe(duration.count());
+
+  bytes_transferred_.Increment(bodySize);
+  num_scrapes_.Increment();
+  return Status::Ok;
+}
+
+ScrapeHandler::Response ScrapeHandler::Handle(const Request& request) {
+  auto response = Response{};
+  detail::StringWriter writer{response};
+  response.status = Handle(request, writer);
+  return response;
+}
+
+ScrapeHandler::Response ScrapeHandler::Serve(const Request& request) {
+  auto response = Response{};
+  detail::StringWriter writer{response};
+  response.status = Serve(request, writer);
+  return response;
+}
+
+void ScrapeHandler::HandleAsync(const Request& request,
+                                const Executor& executor,
+                                std::function<void(Response)> done) {
+  executor([this, request, done] { done(Serve(request)); });
+}
+
+void ScrapeHandler::ResolveProfileHistograms(Settings& settings) {
+  using detail::ScrapeProfile;
+  if (!settings.profile_scrapes) {
+    settings.profile_histograms.reset();
+    return;
+  }
+
+  static const char* const kPhaseNames[] = {
+      nullptr, "lock_wait", "collect", "serialize", "compress", "write"};
+  static const auto kDurationBuckets = Histogram::BucketBoundaries{
+      0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10};
+  static const auto kSeriesBuckets =
+      Histogram::BucketBoundaries{1, 10, 100, 1000, 10000, 100000};
+
+  auto histograms = std::make_shared<Settings::ProfileHistograms>();
+  for (std::size_t i = 1; i < ScrapeProfile::kPhases; ++i) {
+    histograms->phases[i] = &phase_durations_family_.Add(
+        {{"phase", kPhaseNames[i]}}, kDurationBuckets);
+  }
+  // only named collectables and listed families get series of their own, so
+  // their number stays bounded
+  for (const auto& name : *settings.collectable_names) {
+    histograms->collectables[name.first] = &collectable_durations_family_.Add(
+        {{"collectable", name.second}}, kDurationBuckets);
+  }
+  for (const auto& family : *settings.profiled_families) {
+    histograms->family_durations[family] =
+        &family_durations_family_.Add({{"family", family}}, kDurationBuckets);
+    histograms->family_series[family] =
+        &family_series_family_.Add({{"family", family}}, kSeriesBuckets);
+  }
+  settings.profile_histograms = std::move(histograms);
+}
+
+void ScrapeHandler::RecordProfile(detail::ScrapeProfile& profile) {
+  using detail::ScrapePhase;
+  using detail::ScrapeProfile;
+  if (!profile.Enabled()) {
+    return;
+  }
+  profile.Stop();
+
+  // profiling may have been disabled since the scrape started
+  const auto settings = GetSettings();
+  const auto histograms = settings->profile_histograms;
+  if (!histograms) {
+    return;
+  }
+
+  auto seconds = [](ScrapeProfile::Clock::duration duration) {
+    return std::chrono::duration<double>{duration}.count();
+  };
+
+  for (std::size_t i = 1; i < ScrapeProfile::kPhases; ++i) {
+    if (profile.Entered(static_cast<ScrapePhase>(i))) {
+      histograms->phases[i]->Observe(
+          seconds(profile.Duration(static_cast<ScrapePhase>(i))));
+    }
+  }
+  for (const auto& collectable : profile.collectables) {
+    const auto histogram =
+        histograms->collectables.find(collectable.collectable);
+    if (histogram != histograms->collectables.end()) {
+      histogram->second->Observe(seconds(collectable.duration));
+    }
+  }
+  for (const auto& family : profile.families) {
+    const auto duration = histograms->family_durations.find(family.name);
+    if (duration == histograms->family_durations.end()) {
+      continue;
+    }
+    duration->second->Observe(seconds(family.duration));
+    histograms->family_series.at(family.name)
+        ->Observe(static_cast<double>(family.series));
+  }
+}
+
+}  // namespace prometheus
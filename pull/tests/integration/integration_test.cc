@@ -2,17 +2,29 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "prometheus/collectable.h"
 #include "prometheus/counter.h"
 #include "prometheus/detail/future_std.h"
 #include "prometheus/exposer.h"
 #include "prometheus/family.h"
+#include "prometheus/metric_family.h"
 #include "prometheus/registry.h"
 
 namespace prometheus {
@@ -166,6 +178,292 @@ TEST_F(IntegrationTest, acceptOptionalCompression) {
   EXPECT_THAT(metrics.body, HasSubstr(counter_name));
 }
 
+TEST_F(IntegrationTest, shouldStreamResponsesLargerThanAChunk) {
+  auto registry = std::make_shared<Registry>();
+  auto& family = BuildCounter().Name("example_total").Register(*registry);
+  const std::size_t series = 10000;
+  for (std::size_t i = 0; i < series; ++i) {
+    family.Add({{"id", std::to_string(i)}}).Increment();
+  }
+  exposer_->RegisterCollectable(registry, default_metrics_path_);
+
+  std::vector<Response> responses{FetchMetrics(default_metrics_path_)};
+  // encodings not compiled in are answered uncompressed
+  for (const auto* encoding : {"gzip", "zstd"}) {
+    fetchPrePerform_ = [encoding](CURL* curl) {
+      curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, encoding);
+    };
+    responses.push_back(FetchMetrics(default_metrics_path_));
+  }
+
+  for (const auto& metrics : responses) {
+    ASSERT_EQ(metrics.code, 200);
+    EXPECT_GT(metrics.body.size(), 64 * 1024U);
+    EXPECT_THAT(metrics.body, HasSubstr("example_total{id=\"0\"} 1\n"));
+    EXPECT_THAT(metrics.body, HasSubstr("example_total{id=\"9999\"} 1\n"));
+  }
+}
+
+TEST_F(IntegrationTest, shouldNotCompressSmallResponses) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+  auto options = CompressionOptions{};
+  options.level = 1;
+  options.min_size = 16 * 1024;
+  exposer_->SetCompressionOptions(options, default_metrics_path_);
+
+  fetchPrePerform_ = [](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip");
+    curl_easy_setopt(curl, CURLOPT_HTTP_CONTENT_DECODING, 0L);
+  };
+  const auto small = FetchMetrics(default_metrics_path_);
+  ASSERT_EQ(small.code, 200);
+  EXPECT_THAT(small.body, HasSubstr(counter_name + " 1\n"));
+
+  auto& family = BuildCounter().Name("large_total").Register(*registry);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    family.Add({{"id", std::to_string(i)}}).Increment();
+  }
+  fetchPrePerform_ = [](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip");
+  };
+  const auto large = FetchMetrics(default_metrics_path_);
+  ASSERT_EQ(large.code, 200);
+  EXPECT_THAT(large.body, HasSubstr("large_total{id=\"999\"} 1\n"));
+}
+
+TEST_F(IntegrationTest, shouldShareResponses) {
+  auto registry = std::make_shared<Registry>();
+  auto& counter = BuildCounter()
+                      .Name("example_total")
+                      .Register(*registry)
+                      .Add({});
+  exposer_->RegisterCollectable(registry, default_metrics_path_);
+  exposer_->ShareResponses(std::chrono::hours{1}, default_metrics_path_);
+
+  counter.Increment();
+  const auto first = FetchMetrics(default_metrics_path_);
+  counter.Increment();
+  const auto second = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(first.code, 200);
+  ASSERT_EQ(second.code, 200);
+  EXPECT_THAT(second.body, HasSubstr("example_total 1\n"));
+  EXPECT_EQ(second.body, first.body);
+
+  fetchPrePerform_ = [](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip");
+  };
+  const auto compressed = FetchMetrics(default_metrics_path_);
+  ASSERT_EQ(compressed.code, 200);
+  EXPECT_THAT(compressed.body, HasSubstr("example_total 2\n"));
+}
+
+TEST_F(IntegrationTest, shouldPrerenderResponses) {
+  auto registry = std::make_shared<Registry>();
+  auto& counter = BuildCounter()
+                      .Name("example_total")
+                      .Register(*registry)
+                      .Add({});
+  exposer_->RegisterCollectable(registry, default_metrics_path_);
+  exposer_->PrerenderResponses(std::chrono::hours{1}, default_metrics_path_);
+
+  counter.Increment();
+  const auto first = FetchMetrics(default_metrics_path_);
+  counter.Increment();
+  const auto second = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(first.code, 200);
+  ASSERT_EQ(second.code, 200);
+  EXPECT_THAT(second.body, HasSubstr("example_total 1\n"));
+  EXPECT_EQ(second.body, first.body);
+
+  fetchPrePerform_ = [](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip");
+  };
+  const auto compressed = FetchMetrics(default_metrics_path_);
+  ASSERT_EQ(compressed.code, 200);
+  EXPECT_THAT(compressed.body, HasSubstr("example_total 2\n"));
+}
+
+class BlockingCollectable : public Collectable {
+ public:
+  std::vector<MetricFamily> Collect() const override {
+    started_ = true;
+    while (blocked_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return {};
+  }
+
+  std::atomic<bool> blocked_{true};
+  mutable std::atomic<bool> started_{false};
+};
+
+TEST_F(IntegrationTest, shouldLeaveOutLateCollectables) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+  auto blocking = std::make_shared<BlockingCollectable>();
+  exposer_->RegisterCollectable(blocking, default_metrics_path_);
+  exposer_->SetCollectTimeout(std::chrono::hours{1}, default_metrics_path_);
+
+  curl_slist header{
+      const_cast<char*>("X-Prometheus-Scrape-Timeout-Seconds: 0.05"),
+      nullptr};
+  fetchPrePerform_ = [&header](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, &header);
+  };
+  const auto metrics = FetchMetrics(default_metrics_path_);
+  blocking->blocked_ = false;
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr(counter_name + " 1\n"));
+}
+
+TEST_F(IntegrationTest, shouldRegisterCollectablesWhileScraping) {
+  auto blocking = std::make_shared<BlockingCollectable>();
+  exposer_->RegisterCollectable(blocking, default_metrics_path_);
+
+  Response blocked;
+  std::thread scrape{[&] { blocked = FetchMetrics(default_metrics_path_); }};
+  while (!blocking->started_) {
+    std::this_thread::yield();
+  }
+
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+  exposer_->RemoveCollectable(blocking, default_metrics_path_);
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  blocking->blocked_ = false;
+  scrape.join();
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr(counter_name + " 1\n"));
+  ASSERT_EQ(blocked.code, 200);
+  EXPECT_THAT(blocked.body, Not(HasSubstr(counter_name)));
+}
+
+TEST_F(IntegrationTest, shouldRejectScrapesExceedingLimits) {
+  auto blocking = std::make_shared<BlockingCollectable>();
+  exposer_->RegisterCollectable(blocking, default_metrics_path_);
+  exposer_->LimitCollections(1, std::chrono::milliseconds{0},
+                             default_metrics_path_);
+
+  Response blocked;
+  std::thread scrape{[&] { blocked = FetchMetrics(default_metrics_path_); }};
+  while (!blocking->started_) {
+    std::this_thread::yield();
+  }
+  const auto overloaded = FetchMetrics(default_metrics_path_);
+  blocking->blocked_ = false;
+  scrape.join();
+
+  EXPECT_EQ(overloaded.code, 503);
+  EXPECT_EQ(blocked.code, 200);
+
+  exposer_->LimitCollections(0, std::chrono::hours{1}, default_metrics_path_);
+  EXPECT_EQ(FetchMetrics(default_metrics_path_).code, 200);
+  EXPECT_EQ(FetchMetrics(default_metrics_path_).code, 200);
+  EXPECT_EQ(FetchMetrics(default_metrics_path_ + "?name[]=other").code, 429);
+}
+
+TEST_F(IntegrationTest, shouldProfileScrapes) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+  auto named = std::make_shared<Registry>();
+  BuildCounter().Name("other_total").Register(*named).Add({});
+  exposer_->RegisterCollectable(named, default_metrics_path_, "other");
+  exposer_->ProfileScrapes(true, default_metrics_path_);
+  exposer_->ProfileFamilies({counter_name}, default_metrics_path_);
+
+  FetchMetrics(default_metrics_path_);
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body,
+              HasSubstr("exposer_scrape_phase_duration_seconds_count{"
+                        "phase=\"collect\"}"));
+  EXPECT_THAT(metrics.body,
+              HasSubstr("exposer_family_series_sum{family=\"" +
+                        counter_name + "\"} 1\n"));
+  EXPECT_THAT(metrics.body,
+              Not(HasSubstr("exposer_family_series_sum{family=\"other_total")));
+  EXPECT_THAT(metrics.body,
+              HasSubstr("exposer_collectable_duration_seconds_count{"
+                        "collectable=\"other\"} 1\n"));
+  EXPECT_THAT(metrics.body,
+              Not(HasSubstr("exposer_collectable_duration_seconds_count{"
+                            "collectable=\"0\"}")));
+}
+
+TEST_F(IntegrationTest, shouldServeSelectedFamilies) {
+  auto registry = RegisterSomeCounter("example_total", default_metrics_path_);
+  BuildCounter().Name("other_total").Register(*registry).Add({});
+
+  const auto metrics =
+      FetchMetrics(default_metrics_path_ + "?name[]=other_total");
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr("other_total 0\n"));
+  EXPECT_THAT(metrics.body, Not(HasSubstr("example_total")));
+  EXPECT_THAT(metrics.body, Not(HasSubstr("exposer_scrapes_total")));
+}
+
+TEST_F(IntegrationTest, shouldAddExternalLabels) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+
+  exposer_->SetExternalLabels({{"instance", "a"}}, default_metrics_path_);
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr(counter_name + "{instance=\"a\"} 1"));
+}
+
+TEST_F(IntegrationTest, shouldServeProtobufIfAccepted) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+
+  const auto headers = std::shared_ptr<curl_slist>(
+      curl_slist_append(nullptr,
+                        "Accept: application/vnd.google.protobuf;"
+                        "proto=io.prometheus.client.MetricFamily;"
+                        "encoding=delimited;q=0.7,text/plain;q=0.3"),
+      curl_slist_free_all);
+  fetchPrePerform_ = [&headers](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers.get());
+  };
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.contentType,
+              HasSubstr("application/vnd.google.protobuf"));
+  EXPECT_THAT(metrics.body, HasSubstr(counter_name));
+  EXPECT_THAT(metrics.body, Not(HasSubstr("# TYPE")));
+}
+
+TEST_F(IntegrationTest, shouldServeOpenMetricsIfAccepted) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+
+  const auto headers = std::shared_ptr<curl_slist>(
+      curl_slist_append(nullptr,
+                        "Accept: application/openmetrics-text;"
+                        "version=1.0.0;q=0.5,text/plain;q=0.3"),
+      curl_slist_free_all);
+  fetchPrePerform_ = [&headers](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers.get());
+  };
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.contentType, HasSubstr("application/openmetrics-text"));
+  EXPECT_THAT(metrics.body, HasSubstr("# TYPE example counter"));
+  EXPECT_THAT(metrics.body, HasSubstr("example_created"));
+  EXPECT_THAT(metrics.body, EndsWith("# EOF\n"));
+}
+
 TEST_F(IntegrationTest, shouldDealWithExpiredCollectables) {
   const std::string first_counter_name = "first_total";
   const std::string second_counter_name = "second_total";
@@ -313,5 +611,157 @@ TEST_F(BasicAuthIntegrationTest, shouldRejectMalformedBasicAuth) {
   ASSERT_EQ(metrics.code, 401);
 }
 
+
+#ifdef __linux__
+class EpollIntegrationTest : public IntegrationTest {
+ public:
+  void SetUp() override {
+    exposer_ =
+        detail::make_unique<Exposer>("127.0.0.1:0", ExposerBackend::Epoll);
+    auto ports = exposer_->GetListeningPorts();
+    base_url_ = std::string("http://127.0.0.1:") + std::to_string(ports.at(0));
+  }
+};
+
+TEST_F(EpollIntegrationTest, exposeSingleCounter) {
+  const std::string counter_name = "example_total";
+  auto registry = RegisterSomeCounter(counter_name, default_metrics_path_);
+
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr(counter_name));
+  EXPECT_GE(FetchMetrics("/unknown").code, 400);
+}
+
+TEST_F(EpollIntegrationTest, shouldStreamCompressedResponses) {
+  auto registry = std::make_shared<Registry>();
+  auto& family = BuildCounter().Name("example_total").Register(*registry);
+  for (std::size_t i = 0; i < 10000; ++i) {
+    family.Add({{"id", std::to_string(i)}}).Increment();
+  }
+  exposer_->RegisterCollectable(registry, default_metrics_path_);
+
+  fetchPrePerform_ = [](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+  };
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr("example_total{id=\"9999\"} 1\n"));
+}
+
+TEST_F(EpollIntegrationTest, shouldKeepConnectionsAlive) {
+  auto registry = RegisterSomeCounter("example_total", default_metrics_path_);
+
+  // the handle performing the request is reused for further requests
+  std::string body;
+  long connects = 0;
+  fetchPrePerform_ = [&body, &connects](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_EQ(curl_easy_perform(curl), CURLE_OK);
+      long count = 0;
+      curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &count);
+      connects += count;
+    }
+  };
+  const auto metrics = FetchMetrics(default_metrics_path_);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(body, HasSubstr("example_total"));
+  EXPECT_EQ(connects, 1);
+}
+
+TEST_F(EpollIntegrationTest, shouldAuthenticate) {
+  auto registry = RegisterSomeCounter("example_total", default_metrics_path_);
+  exposer_->RegisterAuth(
+      [](const std::string& user, const std::string& password) {
+        return user == "test_user" && password == "test_password";
+      },
+      "Some Auth Realm", default_metrics_path_);
+
+  EXPECT_EQ(FetchMetrics(default_metrics_path_).code, 401);
+
+  fetchPrePerform_ = [](CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+    curl_easy_setopt(curl, CURLOPT_USERNAME, "test_user");
+    curl_easy_setopt(curl, CURLOPT_PASSWORD, "test_password");
+  };
+  EXPECT_EQ(FetchMetrics(default_metrics_path_).code, 200);
+}
+
+class UnixSocketIntegrationTest : public IntegrationTest {
+ public:
+  void SetUp() override { base_url_ = "http://localhost"; }
+
+  // Scrapes the exposer listening on the socket
+  Response FetchOverSocket(const std::string& socket, bool abstract) {
+    exposer_ = detail::make_unique<Exposer>(
+        "unix:" + std::string{abstract ? "@" : ""} + socket,
+        ExposerBackend::Epoll);
+    auto registry = RegisterSomeCounter("example_total", default_metrics_path_);
+
+    fetchPrePerform_ = [&socket, abstract](CURL* curl) {
+      curl_easy_setopt(curl,
+                       abstract ? CURLOPT_ABSTRACT_UNIX_SOCKET
+                                : CURLOPT_UNIX_SOCKET_PATH,
+                       socket.c_str());
+    };
+    return FetchMetrics(default_metrics_path_);
+  }
+
+  const std::string socket_ = "prometheus-cpp-test-" +
+                              std::to_string(::getpid()) + ".sock";
+};
+
+TEST_F(UnixSocketIntegrationTest, shouldServeOnUnixDomainSocket) {
+  const auto path = "/tmp/" + socket_;
+  const auto metrics = FetchOverSocket(path, false);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr("example_total"));
+  EXPECT_TRUE(exposer_->GetListeningPorts().empty());
+
+  // the socket file is removed with the exposer
+  exposer_.reset();
+  EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+
+TEST_F(UnixSocketIntegrationTest, shouldNotReplaceSocketInUse) {
+  const auto path = "/tmp/" + socket_;
+  ASSERT_EQ(FetchOverSocket(path, false).code, 200);
+
+  EXPECT_THROW(Exposer("unix:" + path, ExposerBackend::Epoll),
+               std::runtime_error);
+  EXPECT_EQ(FetchMetrics(default_metrics_path_).code, 200);
+}
+
+TEST_F(UnixSocketIntegrationTest, shouldReplaceStaleSocket) {
+  const auto path = "/tmp/" + socket_;
+  {
+    // a socket file left behind without a listener
+    const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(),
+                 sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::bind(fd, reinterpret_cast<sockaddr*>(&address),
+                     sizeof(address)),
+              0);
+    ::close(fd);
+  }
+
+  EXPECT_EQ(FetchOverSocket(path, false).code, 200);
+}
+
+TEST_F(UnixSocketIntegrationTest, shouldServeOnAbstractUnixDomainSocket) {
+  const auto metrics = FetchOverSocket(socket_, true);
+
+  ASSERT_EQ(metrics.code, 200);
+  EXPECT_THAT(metrics.body, HasSubstr("example_total"));
+}
+#endif
+
 }  // namespace
 }  // namespace prometheus
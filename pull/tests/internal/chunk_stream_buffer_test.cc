@@ -0,0 +1,68 @@
+#include "detail/chunk_stream_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace prometheus {
+namespace {
+
+class ChunkStreamBufferTest : public testing::Test {
+ protected:
+  detail::ChunkStreamBuffer::ChunkWriter Writer() {
+    return [this](const char* data, std::size_t size) {
+      chunks_.emplace_back(data, size);
+      return !fail_;
+    };
+  }
+
+  std::vector<char> buffer_ = std::vector<char>(4);
+  std::vector<std::string> chunks_;
+  bool fail_ = false;
+};
+
+TEST_F(ChunkStreamBufferTest, shouldWriteChunksOfBufferSize) {
+  detail::ChunkStreamBuffer chunks{Writer(), buffer_};
+  std::ostream out{&chunks};
+
+  out << "ab" << "cdef" << 'g';
+  EXPECT_EQ(chunks_, (std::vector<std::string>{"abcd"}));
+
+  EXPECT_TRUE(chunks.Flush());
+  EXPECT_EQ(chunks_, (std::vector<std::string>{"abcd", "efg"}));
+  EXPECT_EQ(chunks.BytesWritten(), 7U);
+}
+
+TEST_F(ChunkStreamBufferTest, shouldPassOnLargeWritesDirectly) {
+  detail::ChunkStreamBuffer chunks{Writer(), buffer_};
+  std::ostream out{&chunks};
+
+  out << "a" << "bcdefghij";
+  EXPECT_EQ(chunks_, (std::vector<std::string>{"abcd", "efghij"}));
+}
+
+TEST_F(ChunkStreamBufferTest, shouldNotFlushEmptyBuffer) {
+  detail::ChunkStreamBuffer chunks{Writer(), buffer_};
+  EXPECT_TRUE(chunks.Flush());
+  EXPECT_TRUE(chunks_.empty());
+}
+
+TEST_F(ChunkStreamBufferTest, shouldStopWritingAfterError) {
+  detail::ChunkStreamBuffer chunks{Writer(), buffer_};
+  std::ostream out{&chunks};
+
+  fail_ = true;
+  out << "abcdefghij";
+  EXPECT_TRUE(out.bad());
+  out.clear();
+  out << "klmnopqrstuvwxyz";
+
+  EXPECT_FALSE(chunks.Flush());
+  EXPECT_EQ(chunks_.size(), 1U);
+}
+
+}  // namespace
+}  // namespace prometheus
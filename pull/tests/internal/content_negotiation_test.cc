@@ -0,0 +1,93 @@
+#include "detail/content_negotiation.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "prometheus/openmetrics_serializer.h"
+#include "prometheus/protobuf_serializer.h"
+#include "prometheus/text_serializer.h"
+
+namespace prometheus {
+namespace {
+
+class ContentNegotiationTest : public testing::Test {
+ protected:
+  std::string Select(const char* accept) const {
+    return negotiator_.Select(accept).content_type;
+  }
+
+  detail::ContentNegotiator negotiator_;
+};
+
+TEST_F(ContentNegotiationTest, shouldFallBackToText) {
+  EXPECT_EQ(Select(nullptr), TextSerializer::kContentType);
+  EXPECT_EQ(Select(""), TextSerializer::kContentType);
+  EXPECT_EQ(Select("application/json"), TextSerializer::kContentType);
+  EXPECT_EQ(Select("application/openmetrics-text;q=0"),
+            TextSerializer::kContentType);
+}
+
+// Accept headers as sent by Prometheus depending on its configuration
+TEST_F(ContentNegotiationTest, shouldSelectFormatOfPrometheus) {
+  EXPECT_EQ(Select("application/vnd.google.protobuf;"
+                   "proto=io.prometheus.client.MetricFamily;"
+                   "encoding=delimited;q=0.7,text/plain;version=0.0.4;q=0.3,"
+                   "*/*;q=0.1"),
+            ProtobufSerializer::kContentType);
+  EXPECT_EQ(Select("application/openmetrics-text;version=1.0.0,"
+                   "application/openmetrics-text;version=0.0.1;q=0.75,"
+                   "text/plain;version=0.0.4;q=0.5,*/*;q=0.1"),
+            OpenMetricsSerializer::kContentType);
+  EXPECT_EQ(Select("text/plain;version=0.0.4;q=0.5,*/*;q=0.1"),
+            TextSerializer::kContentType);
+}
+
+TEST_F(ContentNegotiationTest, shouldPreferHigherQuality) {
+  EXPECT_EQ(Select("text/plain;q=0.5, application/openmetrics-text;q=0.51"),
+            OpenMetricsSerializer::kContentType);
+  EXPECT_EQ(Select("TEXT/Plain; Q=1, application/openmetrics-text;q=0.999"),
+            TextSerializer::kContentType);
+}
+
+TEST_F(ContentNegotiationTest, shouldPreferTextOnTies) {
+  EXPECT_EQ(Select("*/*"), TextSerializer::kContentType);
+  EXPECT_EQ(Select("application/openmetrics-text, text/plain"),
+            TextSerializer::kContentType);
+}
+
+TEST_F(ContentNegotiationTest, shouldUseMostSpecificRange) {
+  EXPECT_EQ(Select("*/*, application/vnd.google.protobuf;q=0"),
+            TextSerializer::kContentType);
+  EXPECT_EQ(Select("application/*;q=0.2, text/*;q=0.1"),
+            ProtobufSerializer::kContentType);
+}
+
+TEST_F(ContentNegotiationTest, shouldMatchParameters) {
+  EXPECT_EQ(Select("application/vnd.google.protobuf;encoding=text"),
+            TextSerializer::kContentType);
+  EXPECT_EQ(Select("application/openmetrics-text;version=0.0.1"),
+            TextSerializer::kContentType);
+  EXPECT_EQ(Select("application/openmetrics-text;charset=\"utf-8\""),
+            OpenMetricsSerializer::kContentType);
+}
+
+TEST_F(ContentNegotiationTest, shouldIgnoreInvalidRanges) {
+  EXPECT_EQ(Select("application/openmetrics-text;q=2, text"),
+            TextSerializer::kContentType);
+  EXPECT_EQ(Select("/plain, application/openmetrics-text"),
+            OpenMetricsSerializer::kContentType);
+}
+
+TEST_F(ContentNegotiationTest, shouldPreferRegisteredSerializer) {
+  auto serializer = std::make_shared<TextSerializer>();
+  negotiator_.Register(serializer, "text/plain; charset=utf-8");
+
+  EXPECT_EQ(negotiator_.Select("text/plain").serializer, serializer);
+  EXPECT_EQ(Select("*/*"), "text/plain; charset=utf-8");
+  EXPECT_EQ(Select(nullptr), TextSerializer::kContentType);
+}
+
+}  // namespace
+}  // namespace prometheus
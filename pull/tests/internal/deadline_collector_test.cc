@@ -0,0 +1,184 @@
+#include "detail/deadline_collector.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "prometheus/collectable.h"
+#include "prometheus/counter.h"
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+namespace {
+
+class NamedCollectable : public Collectable {
+ public:
+  explicit NamedCollectable(std::string name) : name_(std::move(name)) {}
+
+  std::vector<MetricFamily> Collect() const override {
+    ++collections_;
+    while (blocked_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    auto family = MetricFamily{};
+    family.name = name_;
+    family.type = MetricType::Untyped;
+    return {family};
+  }
+
+  void Collect(MetricSink& sink) const override {
+    if (sink.WantsFamily(name_)) {
+      Collectable::Collect(sink);
+    }
+  }
+
+  void Block() { blocked_ = true; }
+  void Unblock() { blocked_ = false; }
+  int Collections() const { return collections_; }
+
+ private:
+  const std::string name_;
+  std::atomic<bool> blocked_{false};
+  mutable std::atomic<int> collections_{0};
+};
+
+class DeadlineCollectorTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    for (const auto& collectable : collectables_) {
+      collectable->Unblock();
+    }
+  }
+
+  std::shared_ptr<NamedCollectable> Add(const std::string& name) {
+    auto collectable = std::make_shared<NamedCollectable>(name);
+    collectables_.push_back(collectable);
+    weak_collectables_.push_back(collectable);
+    return collectable;
+  }
+
+  std::vector<std::string> Collect(std::chrono::milliseconds timeout,
+                                   const char* query_string = nullptr) {
+    detail::FamilyFilter filter;
+    filter.Parse(query_string);
+    MetricFamilyCollector sink;
+    collector_.Collect(weak_collectables_, filter,
+                       detail::DeadlineCollector::Clock::now() + timeout,
+                       sink);
+
+    std::vector<std::string> names;
+    for (const auto& family : sink.TakeFamilies()) {
+      names.push_back(family.name);
+    }
+    return names;
+  }
+
+  Counter reused_;
+  Counter dropped_;
+  detail::DeadlineCollector collector_{reused_, dropped_, 2};
+  std::vector<std::shared_ptr<NamedCollectable>> collectables_;
+  std::vector<std::weak_ptr<Collectable>> weak_collectables_;
+};
+
+TEST_F(DeadlineCollectorTest, shouldCollectInOrder) {
+  Add("a");
+  Add("b");
+  Add("c");
+
+  const auto expected = std::vector<std::string>{"a", "b", "c"};
+  EXPECT_EQ(Collect(std::chrono::hours{1}), expected);
+  EXPECT_EQ(reused_.Value(), 0);
+  EXPECT_EQ(dropped_.Value(), 0);
+}
+
+TEST_F(DeadlineCollectorTest, shouldDropLateCollectable) {
+  Add("a");
+  Add("b")->Block();
+
+  const auto expected = std::vector<std::string>{"a"};
+  EXPECT_EQ(Collect(std::chrono::milliseconds{10}), expected);
+  EXPECT_EQ(dropped_.Value(), 1);
+}
+
+TEST_F(DeadlineCollectorTest, shouldReuseLastResultOfLateCollectable) {
+  Add("a");
+  auto slow = Add("b");
+  Collect(std::chrono::hours{1});
+
+  slow->Block();
+  const auto expected = std::vector<std::string>{"a", "b"};
+  EXPECT_EQ(Collect(std::chrono::milliseconds{10}), expected);
+  EXPECT_EQ(reused_.Value(), 1);
+  EXPECT_EQ(dropped_.Value(), 0);
+}
+
+TEST_F(DeadlineCollectorTest, shouldSkipExpiredCollectables) {
+  Add("a");
+  Add("b");
+  collectables_.pop_back();
+
+  const auto expected = std::vector<std::string>{"a"};
+  EXPECT_EQ(Collect(std::chrono::hours{1}), expected);
+}
+
+TEST_F(DeadlineCollectorTest, shouldNotCollectHangingCollectableAgain) {
+  Add("a");
+  auto hanging = Add("b");
+  hanging->Block();
+
+  const auto expected = std::vector<std::string>{"a"};
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(Collect(std::chrono::milliseconds{5}), expected);
+  }
+  EXPECT_EQ(hanging->Collections(), 1);
+  EXPECT_EQ(dropped_.Value(), 10);
+}
+
+TEST_F(DeadlineCollectorTest, shouldCollectOnlySelectedFamilies) {
+  auto a = Add("a");
+  auto b = Add("b");
+
+  const auto expected = std::vector<std::string>{"b"};
+  EXPECT_EQ(Collect(std::chrono::hours{1}, "name[]=b"), expected);
+  EXPECT_EQ(a->Collections(), 0);
+  EXPECT_EQ(b->Collections(), 1);
+}
+
+TEST_F(DeadlineCollectorTest, shouldNotReuseResultOfOtherFamilies) {
+  Add("a");
+  auto slow = Add("b");
+  Collect(std::chrono::hours{1});
+  Collect(std::chrono::hours{1}, "name[]=a");
+
+  // the result of the filtered scrape lacks "b", the complete one is used
+  slow->Block();
+  const auto expected = std::vector<std::string>{"a", "b"};
+  EXPECT_EQ(Collect(std::chrono::milliseconds{10}), expected);
+  EXPECT_EQ(reused_.Value(), 1);
+}
+
+TEST(DeadlineCollectorLifetimeTest, shouldNotKeepCollectablesAlive) {
+  Counter reused;
+  Counter dropped;
+  detail::DeadlineCollector collector{reused, dropped, 1};
+  auto collectable = std::make_shared<NamedCollectable>("a");
+  std::weak_ptr<Collectable> weak = collectable;
+
+  MetricFamilyCollector sink;
+  collector.Collect({weak}, detail::FamilyFilter{},
+                    detail::DeadlineCollector::Clock::now() +
+                        std::chrono::hours{1},
+                    sink);
+  collectable.reset();
+
+  EXPECT_TRUE(weak.expired());
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,240 @@
+#include "detail/epoll_server.h"
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace prometheus {
+namespace {
+
+using namespace testing;
+
+class EchoHandler : public detail::HttpHandler {
+ public:
+  bool HandleGet(detail::HttpConnection& conn) override {
+    auto query = conn.GetQueryString();
+    auto accept = conn.GetHeader("accept");
+    auto body = std::string{"query="} + (query ? query : "(none)") +
+                " accept=" + (accept ? accept : "(none)") +
+                " version=" + conn.GetHttpVersion();
+    conn.Write("HTTP/1.1 200 OK\r\nContent-Length: " +
+               std::to_string(body.size()) + "\r\n\r\n" + body);
+    return true;
+  }
+};
+
+class RejectingAuthHandler : public detail::HttpAuthHandler {
+ public:
+  bool Authorize(detail::HttpConnection& conn) override {
+    conn.Write("HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\n\r\n");
+    return false;
+  }
+};
+
+// Sends the requests over one connection and returns everything received
+// until the server closes it
+std::string Exchange(int port, const std::string& requests) {
+  const auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  std::shared_ptr<void> guard{nullptr, [fd](void*) { ::close(fd); }};
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<std::uint16_t>(port));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+          0 ||
+      ::send(fd, requests.data(), requests.size(), 0) !=
+          static_cast<ssize_t>(requests.size())) {
+    throw std::runtime_error("failed to send request");
+  }
+
+  std::string received;
+  char buffer[4096];
+  ssize_t count;
+  while ((count = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    received.append(buffer, static_cast<std::size_t>(count));
+  }
+  return received;
+}
+
+class EpollServerTest : public testing::Test {
+ protected:
+  EpollServerTest() { server_.AddHandler("/echo", handler_); }
+
+  std::string Exchange(const std::string& requests) {
+    return prometheus::Exchange(server_.GetListeningPorts().at(0), requests);
+  }
+
+  EchoHandler handler_;
+  detail::EpollServer server_{"127.0.0.1:0"};
+};
+
+TEST_F(EpollServerTest, shouldServePipelinedRequests) {
+  const auto received = Exchange(
+      "GET /echo?name[]=a HTTP/1.1\r\nAccept: text/plain\r\n\r\n"
+      "GET /echo HTTP/1.1\r\nConnection: close\r\n\r\n");
+
+  EXPECT_THAT(received, HasSubstr("query=name[]=a accept=text/plain "
+                                  "version=1.1HTTP/1.1 200 OK"));
+  EXPECT_THAT(received, EndsWith("query=(none) accept=(none) version=1.1"));
+}
+
+TEST_F(EpollServerTest, shouldCloseHttp10Connections) {
+  const auto received = Exchange(
+      "GET /echo HTTP/1.0\r\n\r\n"
+      "GET /echo HTTP/1.0\r\n\r\n");
+
+  EXPECT_THAT(received, EndsWith("version=1.0"));
+  EXPECT_EQ(received.find("HTTP/1.1 200 OK"),
+            received.rfind("HTTP/1.1 200 OK"));
+}
+
+TEST_F(EpollServerTest, shouldRejectOtherRequests) {
+  EXPECT_THAT(Exchange("POST /echo HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+                       "GET /none HTTP/1.1\r\n\r\n"
+                       "GET /echo\r\n\r\n"),
+              AllOf(StartsWith("HTTP/1.1 405 Method Not Allowed\r\n"),
+                    HasSubstr("HTTP/1.1 404 Not Found\r\n"),
+                    HasSubstr("HTTP/1.1 400 Bad Request\r\n")));
+}
+
+TEST_F(EpollServerTest, shouldRejectLargeOrInvalidBodies) {
+  EXPECT_THAT(Exchange("GET /echo HTTP/1.1\r\nContent-Length: 100000\r\n\r\n"),
+              StartsWith("HTTP/1.1 413 Payload Too Large\r\n"));
+  EXPECT_THAT(Exchange("GET /echo HTTP/1.1\r\n"
+                       "Content-Length: 18446744073709551617\r\n\r\n"),
+              StartsWith("HTTP/1.1 400 Bad Request\r\n"));
+  EXPECT_THAT(Exchange("GET /echo HTTP/1.1\r\nContent-Length: -1\r\n\r\n"),
+              StartsWith("HTTP/1.1 400 Bad Request\r\n"));
+}
+
+class LargeResponseHandler : public detail::HttpHandler {
+ public:
+  static constexpr std::size_t kSize = 16 * 1024 * 1024;
+
+  bool HandleGet(detail::HttpConnection& conn) override {
+    conn.Write("HTTP/1.1 200 OK\r\nContent-Length: " +
+               std::to_string(kSize) + "\r\n\r\n");
+    const std::string block(4096, 'x');
+    for (std::size_t written = 0; written < kSize; written += block.size()) {
+      if (!conn.Write(block)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+constexpr std::size_t LargeResponseHandler::kSize;
+
+TEST_F(EpollServerTest, shouldSendResponsesLargerThanTheBuffer) {
+  LargeResponseHandler large_handler;
+  server_.AddHandler("/large", large_handler);
+
+  const auto received =
+      Exchange("GET /large HTTP/1.1\r\nConnection: close\r\n\r\n");
+
+  EXPECT_THAT(received, StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_EQ(received.size() - received.find("\r\n\r\n") - 4,
+            LargeResponseHandler::kSize);
+  server_.RemoveHandler("/large");
+}
+
+TEST_F(EpollServerTest, shouldServeOthersWhileClientDoesNotRead) {
+  LargeResponseHandler large_handler;
+  server_.AddHandler("/large", large_handler);
+  const auto stalled = ::socket(AF_INET, SOCK_STREAM, 0);
+  std::shared_ptr<void> guard{nullptr, [stalled](void*) { ::close(stalled); }};
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port =
+      htons(static_cast<std::uint16_t>(server_.GetListeningPorts().at(0)));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const std::string request = "GET /large HTTP/1.1\r\n\r\n";
+  ASSERT_EQ(::connect(stalled, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address)),
+            0);
+  ASSERT_EQ(::send(stalled, request.data(), request.size(), 0),
+            static_cast<ssize_t>(request.size()));
+
+  auto served = std::async(std::launch::async, [this] {
+    return Exchange("GET /echo HTTP/1.1\r\nConnection: close\r\n\r\n");
+  });
+
+  ASSERT_EQ(served.wait_for(std::chrono::seconds{5}),
+            std::future_status::ready);
+  EXPECT_THAT(served.get(), StartsWith("HTTP/1.1 200 OK\r\n"));
+  guard.reset();
+  server_.RemoveHandler("/large");
+}
+
+TEST_F(EpollServerTest, shouldCloseConnectionIfUnauthorized) {
+  RejectingAuthHandler auth_handler;
+  server_.AddAuthHandler("/echo", auth_handler);
+
+  EXPECT_EQ(Exchange("GET /echo HTTP/1.1\r\n\r\nGET /echo HTTP/1.1\r\n\r\n"),
+            "HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\n\r\n");
+
+  server_.RemoveAuthHandler("/echo");
+}
+
+TEST_F(EpollServerTest, shouldRejectInvalidAddresses) {
+  EXPECT_THROW(detail::EpollServer{"localhost:80"}, std::runtime_error);
+  EXPECT_THROW(detail::EpollServer{"127.0.0.1:http"}, std::runtime_error);
+}
+
+class BlockingHandler : public detail::HttpHandler {
+ public:
+  bool HandleGet(detail::HttpConnection& conn) override {
+    released_.wait();
+    conn.Write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+    return true;
+  }
+
+  void Release() { release_.set_value(); }
+
+ private:
+  std::promise<void> release_;
+  std::shared_future<void> released_ = release_.get_future().share();
+};
+
+TEST(EpollServerExecutorTest, shouldServeOtherConnectionsWhileHandling) {
+  EchoHandler echo_handler;
+  BlockingHandler blocking_handler;
+  detail::EpollServer server{"127.0.0.1:0", [](std::function<void()> task) {
+                               std::thread{std::move(task)}.detach();
+                             }};
+  server.AddHandler("/echo", echo_handler);
+  server.AddHandler("/block", blocking_handler);
+  const auto port = server.GetListeningPorts().at(0);
+
+  auto blocked = std::async(std::launch::async, [port] {
+    return Exchange(port, "GET /block HTTP/1.1\r\nConnection: close\r\n\r\n");
+  });
+  EXPECT_THAT(Exchange(port, "GET /echo HTTP/1.1\r\nConnection: close\r\n\r\n"),
+              EndsWith("version=1.1"));
+
+  blocking_handler.Release();
+  EXPECT_THAT(blocked.get(), StartsWith("HTTP/1.1 200 OK\r\n"));
+}
+
+}  // namespace
+}  // namespace prometheus
+
+#endif
@@ -0,0 +1,75 @@
+#include "detail/family_filter.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+namespace {
+
+class FamilyFilterTest : public testing::Test {
+ protected:
+  detail::FamilyFilter filter_;
+};
+
+TEST_F(FamilyFilterTest, shouldSelectAllWithoutParameters) {
+  filter_.Parse(nullptr);
+  EXPECT_TRUE(filter_.Empty());
+  EXPECT_TRUE(filter_.Matches("up"));
+
+  filter_.Parse("debug=1&name=up");
+  EXPECT_TRUE(filter_.Empty());
+}
+
+TEST_F(FamilyFilterTest, shouldSelectByName) {
+  filter_.Parse("name[]=up&name%5B%5D=requests_total&other=1");
+
+  EXPECT_FALSE(filter_.Empty());
+  EXPECT_TRUE(filter_.Matches("up"));
+  EXPECT_TRUE(filter_.Matches("requests_total"));
+  EXPECT_FALSE(filter_.Matches("latency_seconds"));
+}
+
+TEST_F(FamilyFilterTest, shouldSelectByMatcher) {
+  filter_.Parse("match[]=up&match[]=%7B__name__%3D%22requests_total%22%7D");
+
+  EXPECT_TRUE(filter_.Matches("up"));
+  EXPECT_TRUE(filter_.Matches("requests_total"));
+  EXPECT_FALSE(filter_.Matches("latency_seconds"));
+}
+
+TEST_F(FamilyFilterTest, unsupportedMatcherShouldSelectNothing) {
+  filter_.Parse("match[]=%7Bjob%3D%22a%22%7D");
+
+  EXPECT_FALSE(filter_.Empty());
+  EXPECT_FALSE(filter_.Matches("up"));
+}
+
+TEST_F(FamilyFilterTest, sinkShouldDropOtherFamilies) {
+  filter_.Parse("name[]=up");
+  MetricFamilyCollector collector;
+  detail::FilteringSink sink{collector, filter_};
+
+  auto family = MetricFamily{};
+  family.type = MetricType::Gauge;
+  for (const auto* name : {"down", "up"}) {
+    family.name = name;
+    sink.BeginFamily(family);
+    sink.AddMetric(MetricRecord{});
+    sink.EndFamily();
+  }
+  const auto families = collector.TakeFamilies();
+
+  EXPECT_FALSE(sink.WantsFamily("down"));
+  EXPECT_TRUE(sink.WantsFamily("up"));
+  ASSERT_EQ(families.size(), 1U);
+  EXPECT_EQ(families[0].name, "up");
+  EXPECT_EQ(families[0].metric.size(), 1U);
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,53 @@
+#include "detail/prerenderer.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace prometheus {
+namespace {
+
+class PrerendererTest : public testing::Test {
+ protected:
+  detail::Prerenderer::Render Render() {
+    return [this] {
+      auto response = detail::CachedResponse{};
+      response.body = std::to_string(++rendered_);
+      return response;
+    };
+  }
+
+  std::atomic<int> rendered_{0};
+};
+
+TEST_F(PrerendererTest, shouldRenderNewKeysRightAway) {
+  detail::Prerenderer prerenderer{std::chrono::hours{1}};
+
+  EXPECT_EQ(prerenderer.Get("text", Render())->body, "1");
+  EXPECT_EQ(prerenderer.Get("text", Render())->body, "1");
+  EXPECT_EQ(prerenderer.Get("text;gzip", Render())->body, "2");
+}
+
+TEST_F(PrerendererTest, shouldRenderInTheBackground) {
+  detail::Prerenderer prerenderer{std::chrono::milliseconds{1}};
+
+  EXPECT_EQ(prerenderer.Get("text", Render())->body, "1");
+  while (rendered_ < 3) {
+    std::this_thread::yield();
+  }
+  EXPECT_NE(prerenderer.Get("text", Render())->body, "1");
+}
+
+TEST_F(PrerendererTest, shouldRenderAgainAfterClear) {
+  detail::Prerenderer prerenderer{std::chrono::hours{1}};
+
+  prerenderer.Get("text", Render());
+  prerenderer.Clear();
+  EXPECT_EQ(prerenderer.Get("text", Render())->body, "2");
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,92 @@
+#include "detail/response_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace prometheus {
+namespace {
+
+using Result = detail::ResponseCache::Result;
+
+class ResponseCacheTest : public testing::Test {
+ protected:
+  detail::ResponseCache::Producer Producer(const std::string& body) {
+    return [this, body] {
+      ++produced_;
+      auto response = detail::CachedResponse{};
+      response.body = body;
+      return response;
+    };
+  }
+
+  std::atomic<int> produced_{0};
+  Result result_ = Result::Miss;
+};
+
+TEST_F(ResponseCacheTest, shouldServeFreshResponses) {
+  detail::ResponseCache cache{std::chrono::hours{1}};
+
+  EXPECT_EQ(cache.Get("text", Producer("a"), result_)->body, "a");
+  EXPECT_EQ(result_, Result::Miss);
+  EXPECT_EQ(cache.Get("text", Producer("b"), result_)->body, "a");
+  EXPECT_EQ(result_, Result::Hit);
+  EXPECT_EQ(cache.Get("text;gzip", Producer("c"), result_)->body, "c");
+  EXPECT_EQ(result_, Result::Miss);
+  EXPECT_EQ(produced_, 2);
+}
+
+TEST_F(ResponseCacheTest, shouldNotServeStaleResponses) {
+  detail::ResponseCache cache{std::chrono::milliseconds{0}};
+
+  cache.Get("text", Producer("a"), result_);
+  std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  EXPECT_EQ(cache.Get("text", Producer("b"), result_)->body, "b");
+  EXPECT_EQ(result_, Result::Miss);
+}
+
+TEST_F(ResponseCacheTest, shouldCoalesceConcurrentRequests) {
+  detail::ResponseCache cache{std::chrono::milliseconds{0}};
+  auto slow = [this] {
+    // give the other scrapes time to start waiting
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    return Producer("a")();
+  };
+
+  std::vector<Result> results(4);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&cache, &slow, &result] {
+      EXPECT_EQ(cache.Get("text", slow, result)->body, "a");
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(produced_, 1);
+  EXPECT_EQ(std::count(results.begin(), results.end(), Result::Miss), 1);
+  EXPECT_EQ(std::count(results.begin(), results.end(), Result::Coalesced), 3);
+}
+
+TEST_F(ResponseCacheTest, shouldRetryAfterFailure) {
+  detail::ResponseCache cache{std::chrono::hours{1}};
+
+  EXPECT_THROW(cache.Get("text",
+                         []() -> detail::CachedResponse {
+                           throw std::runtime_error("failed");
+                         },
+                         result_),
+               std::runtime_error);
+  EXPECT_EQ(cache.Get("text", Producer("a"), result_)->body, "a");
+  EXPECT_EQ(result_, Result::Miss);
+}
+
+}  // namespace
+}  // namespace prometheus
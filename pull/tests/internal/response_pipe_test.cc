@@ -0,0 +1,94 @@
+#include "detail/response_pipe.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace prometheus {
+namespace {
+
+class RecordingWriter : public ScrapeHandler::ResponseWriter {
+ public:
+  void Begin(const std::string& content_type,
+             const std::string& content_encoding,
+             const std::size_t* content_length) override {
+    content_type_ = content_type;
+    content_encoding_ = content_encoding;
+    chunked_ = content_length == nullptr;
+  }
+
+  bool Write(const char* data, std::size_t size) override {
+    body_.append(data, size);
+    return !fail_;
+  }
+
+  std::string content_type_;
+  std::string content_encoding_;
+  bool chunked_ = false;
+  std::string body_;
+  bool fail_ = false;
+};
+
+TEST(ResponsePipeTest, shouldForwardResponseWhileRendered) {
+  detail::ResponsePipe pipe{4};
+  RecordingWriter writer;
+
+  std::thread renderer{[&pipe] {
+    pipe.Begin("text/plain", "gzip", nullptr);
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(pipe.Write("abc", 3));
+    }
+    pipe.Close(ScrapeHandler::Status::Ok);
+  }};
+
+  EXPECT_EQ(pipe.Drain(writer), ScrapeHandler::Status::Ok);
+  renderer.join();
+  EXPECT_EQ(writer.content_type_, "text/plain");
+  EXPECT_EQ(writer.content_encoding_, "gzip");
+  EXPECT_TRUE(writer.chunked_);
+  EXPECT_EQ(writer.body_.size(), 30U);
+}
+
+TEST(ResponsePipeTest, shouldStopRenderingOnceWriterFails) {
+  detail::ResponsePipe pipe{4};
+  RecordingWriter writer;
+  writer.fail_ = true;
+
+  std::thread renderer{[&pipe] {
+    auto written = 0;
+    for (int i = 0; i < 10 && pipe.Write("abc", 3); ++i) {
+      ++written;
+    }
+    EXPECT_LT(written, 10);
+    pipe.Close(ScrapeHandler::Status::Ok);
+  }};
+
+  pipe.Drain(writer);
+  renderer.join();
+}
+
+TEST(ResponsePipeTest, shouldPassOnRejectedScrapes) {
+  detail::ResponsePipe pipe{4};
+  RecordingWriter writer;
+
+  pipe.Close(ScrapeHandler::Status::Overloaded);
+
+  EXPECT_EQ(pipe.Drain(writer), ScrapeHandler::Status::Overloaded);
+  EXPECT_TRUE(writer.content_type_.empty());
+}
+
+TEST(ResponsePipeTest, shouldRethrowRenderingErrors) {
+  detail::ResponsePipe pipe{4};
+  RecordingWriter writer;
+
+  pipe.Fail(std::make_exception_ptr(std::runtime_error{"collect failed"}));
+
+  EXPECT_THROW(pipe.Drain(writer), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,57 @@
+#include "detail/scrape_admission.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace prometheus {
+namespace {
+
+using Result = detail::ScrapeAdmission::Result;
+
+TEST(ScrapeAdmissionTest, shouldAdmitEverythingWithoutLimits) {
+  detail::ScrapeAdmission admission{0, std::chrono::milliseconds{0}};
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(admission.Acquire(), Result::Admitted);
+  }
+}
+
+TEST(ScrapeAdmissionTest, shouldLimitConcurrentCollections) {
+  detail::ScrapeAdmission admission{2, std::chrono::milliseconds{0}};
+
+  EXPECT_EQ(admission.Acquire(), Result::Admitted);
+  EXPECT_EQ(admission.Acquire(), Result::Admitted);
+  EXPECT_EQ(admission.Acquire(), Result::Overloaded);
+
+  admission.Release();
+  EXPECT_EQ(admission.Acquire(), Result::Admitted);
+}
+
+TEST(ScrapeAdmissionTest, shouldEnforceMinimumInterval) {
+  detail::ScrapeAdmission admission{0, std::chrono::milliseconds{50}};
+
+  EXPECT_EQ(admission.Acquire(), Result::Admitted);
+  admission.Release();
+  EXPECT_EQ(admission.Acquire(), Result::TooFrequent);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds{60});
+  EXPECT_EQ(admission.Acquire(), Result::Admitted);
+}
+
+TEST(ScrapeAdmissionTest, shouldKeepLastResponses) {
+  detail::ScrapeAdmission admission{0, std::chrono::milliseconds{50}};
+  auto response = std::make_shared<const detail::CachedResponse>(
+      detail::CachedResponse{"body", "gzip"});
+
+  admission.Keep("text/plain;gzip", response);
+
+  EXPECT_TRUE(admission.KeepsResponses());
+  EXPECT_EQ(admission.Last("text/plain;gzip"), response);
+  EXPECT_EQ(admission.Last("text/plain"), nullptr);
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,97 @@
+#include "detail/scrape_profile.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include "prometheus/metric_family.h"
+#include "prometheus/metric_record.h"
+#include "prometheus/metric_sink.h"
+
+namespace prometheus {
+namespace {
+
+using detail::ScrapePhase;
+using detail::ScrapeProfile;
+
+class ScrapeProfileTest : public testing::Test {
+ protected:
+  static void Sleep() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+  }
+
+  ScrapeProfile profile_;
+};
+
+TEST_F(ScrapeProfileTest, shouldAttributeTimeToInnermostPhase) {
+  profile_.Start();
+  {
+    ScrapeProfile::Scope collect{profile_, ScrapePhase::Collect};
+    Sleep();
+    {
+      ScrapeProfile::Scope write{profile_, ScrapePhase::Write};
+      Sleep();
+    }
+  }
+  profile_.Stop();
+
+  EXPECT_TRUE(profile_.Entered(ScrapePhase::Collect));
+  EXPECT_TRUE(profile_.Entered(ScrapePhase::Write));
+  EXPECT_FALSE(profile_.Entered(ScrapePhase::Compress));
+  EXPECT_GE(profile_.Duration(ScrapePhase::Collect),
+            std::chrono::milliseconds{2});
+  EXPECT_GE(profile_.Duration(ScrapePhase::Write),
+            std::chrono::milliseconds{2});
+}
+
+TEST_F(ScrapeProfileTest, shouldNotMeasureUnlessStarted) {
+  {
+    ScrapeProfile::Scope collect{profile_, ScrapePhase::Collect};
+    Sleep();
+  }
+  profile_.Add(ScrapePhase::LockWait, std::chrono::seconds{1});
+
+  EXPECT_FALSE(profile_.Entered(ScrapePhase::Collect));
+  EXPECT_FALSE(profile_.Entered(ScrapePhase::LockWait));
+}
+
+TEST_F(ScrapeProfileTest, sinkShouldRecordFamilies) {
+  MetricFamilyCollector collector;
+  detail::ProfilingSink sink{collector, profile_};
+  auto family = MetricFamily{};
+  family.name = "requests_total";
+  family.type = MetricType::Counter;
+  auto record = MetricRecord{};
+
+  profile_.Start();
+  sink.BeginFamily(family);
+  sink.AddMetric(record);
+  sink.AddMetric(record);
+  sink.EndFamily();
+  profile_.Stop();
+
+  ASSERT_EQ(profile_.families.size(), 1U);
+  EXPECT_EQ(profile_.families[0].name, "requests_total");
+  EXPECT_EQ(profile_.families[0].series, 2U);
+  EXPECT_TRUE(profile_.Entered(ScrapePhase::Serialize));
+  EXPECT_EQ(collector.TakeFamilies().at(0).metric.size(), 2U);
+}
+
+TEST_F(ScrapeProfileTest, streamBufferShouldForward) {
+  std::ostringstream out;
+  detail::ProfilingStreamBuffer buffer{*out.rdbuf(), profile_,
+                                       ScrapePhase::Compress};
+  std::ostream stream{&buffer};
+
+  profile_.Start();
+  stream << "abc" << 'd';
+  profile_.Stop();
+
+  EXPECT_EQ(out.str(), "abcd");
+  EXPECT_TRUE(profile_.Entered(ScrapePhase::Compress));
+}
+
+}  // namespace
+}  // namespace prometheus
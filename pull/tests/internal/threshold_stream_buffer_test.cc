@@ -0,0 +1,69 @@
+#include "detail/threshold_stream_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+namespace prometheus {
+namespace {
+
+class ThresholdStreamBufferTest : public testing::Test {
+ protected:
+  detail::ThresholdStreamBuffer::Target Target() {
+    return [this](bool complete, std::size_t size) -> std::streambuf& {
+      ++calls_;
+      complete_ = complete;
+      size_ = size;
+      return *out_.rdbuf();
+    };
+  }
+
+  std::string buffer_;
+  std::ostringstream out_;
+  int calls_ = 0;
+  bool complete_ = false;
+  std::size_t size_ = 0;
+};
+
+TEST_F(ThresholdStreamBufferTest, shouldHoldBackSmallContent) {
+  detail::ThresholdStreamBuffer threshold{8, buffer_, Target()};
+  std::ostream{&threshold} << "1234" << '5' << "678";
+  EXPECT_EQ(calls_, 0);
+  EXPECT_EQ(out_.str(), "");
+
+  ASSERT_TRUE(threshold.Finish());
+  EXPECT_EQ(calls_, 1);
+  EXPECT_TRUE(complete_);
+  EXPECT_EQ(size_, 8U);
+  EXPECT_EQ(out_.str(), "12345678");
+}
+
+TEST_F(ThresholdStreamBufferTest, shouldPassOnLargeContent) {
+  detail::ThresholdStreamBuffer threshold{8, buffer_, Target()};
+  std::ostream out{&threshold};
+  out << "12345678" << '9';
+  EXPECT_EQ(calls_, 1);
+  EXPECT_FALSE(complete_);
+  EXPECT_EQ(size_, 9U);
+  EXPECT_EQ(out_.str(), "123456789");
+
+  out << "abc";
+  ASSERT_TRUE(threshold.Finish());
+  EXPECT_EQ(calls_, 1);
+  EXPECT_EQ(out_.str(), "123456789abc");
+}
+
+TEST_F(ThresholdStreamBufferTest, shouldPassOnEmptyContent) {
+  detail::ThresholdStreamBuffer threshold{8, buffer_, Target()};
+  ASSERT_TRUE(threshold.Finish());
+  EXPECT_EQ(calls_, 1);
+  EXPECT_TRUE(complete_);
+  EXPECT_EQ(size_, 0U);
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -25,5 +25,19 @@ TEST(ExposerTest, invalidExternalServer) {
   EXPECT_THROW(Exposer(std::shared_ptr<CivetServer>(nullptr)), std::invalid_argument);
 }
 
+#ifdef __linux__
+TEST(ExposerTest, listenOnDistinctPortsWithEpoll) {
+  Exposer firstExposer{"0.0.0.0:0", ExposerBackend::Epoll};
+  Exposer secondExposer{"127.0.0.1:0, 127.0.0.1:0", ExposerBackend::Epoll};
+
+  ASSERT_EQ(1u, firstExposer.GetListeningPorts().size());
+  ASSERT_EQ(2u, secondExposer.GetListeningPorts().size());
+  EXPECT_NE(firstExposer.GetListeningPorts(),
+            secondExposer.GetListeningPorts());
+  EXPECT_THROW(Exposer("0.0.0.0:invalid", ExposerBackend::Epoll),
+               std::runtime_error);
+}
+#endif
+
 }  // namespace
 }  // namespace prometheus
@@ -0,0 +1,218 @@
+#include "prometheus/scrape_handler.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "prometheus/collection_executor.h"
+#include "prometheus/compression_options.h"
+#include "prometheus/counter.h"
+#include "prometheus/family.h"
+#include "prometheus/registry.h"
+#include "prometheus/text_serializer.h"
+
+namespace prometheus {
+namespace {
+
+using namespace testing;
+
+class RecordingWriter : public ScrapeHandler::ResponseWriter {
+ public:
+  void Begin(const std::string& type, const std::string& encoding,
+             const std::size_t* length) override {
+    ++begun;
+    content_type = type;
+    content_encoding = encoding;
+    has_length = length != nullptr;
+  }
+
+  bool Write(const char* data, std::size_t size) override {
+    ++writes;
+    body.append(data, size);
+    return true;
+  }
+
+  int begun = 0;
+  int writes = 0;
+  std::string content_type;
+  std::string content_encoding;
+  bool has_length = false;
+  std::string body;
+};
+
+class ScrapeHandlerTest : public testing::Test {
+ protected:
+  ScrapeHandlerTest() {
+    auto& family = BuildCounter().Name("requests_total").Register(*registry_);
+    for (int i = 0; i < 5000; ++i) {
+      family.Add({{"id", std::to_string(i)}}).Increment();
+    }
+    handler_.RegisterCollectable(registry_);
+  }
+
+  std::shared_ptr<Registry> registry_ = std::make_shared<Registry>();
+  ScrapeHandler handler_;
+};
+
+TEST_F(ScrapeHandlerTest, shouldReturnWholeResponse) {
+  const auto response = handler_.Handle(ScrapeHandler::Request{});
+
+  EXPECT_EQ(response.content_type, TextSerializer::kContentType);
+  EXPECT_EQ(response.content_encoding, "");
+  EXPECT_THAT(response.body, HasSubstr("requests_total{id=\"999\"} 1\n"));
+  EXPECT_THAT(response.body, HasSubstr("exposer_scrapes_total"));
+}
+
+TEST_F(ScrapeHandlerTest, shouldStreamResponseInChunks) {
+  RecordingWriter writer;
+  handler_.Handle(ScrapeHandler::Request{}, writer);
+
+  EXPECT_EQ(writer.begun, 1);
+  EXPECT_FALSE(writer.has_length);
+  EXPECT_GT(writer.writes, 1);
+  EXPECT_THAT(writer.body, HasSubstr("requests_total{id=\"999\"} 1\n"));
+}
+
+TEST_F(ScrapeHandlerTest, shouldNegotiateFormatAndSelectFamilies) {
+  auto request = ScrapeHandler::Request{};
+  request.accept = "application/openmetrics-text";
+  request.query_string = "name[]=requests_total";
+  const auto response = handler_.Handle(request);
+
+  EXPECT_THAT(response.content_type, HasSubstr("openmetrics"));
+  EXPECT_THAT(response.body, HasSubstr("requests_total{id=\"0\"} 1\n"));
+  EXPECT_THAT(response.body, Not(HasSubstr("exposer_scrapes_total")));
+}
+
+TEST_F(ScrapeHandlerTest, shouldSendSmallResponsesWithLength) {
+  auto options = CompressionOptions{};
+  options.min_size = 1024 * 1024;
+  handler_.SetCompressionOptions(options);
+
+  auto request = ScrapeHandler::Request{};
+  request.accept_encoding = "gzip, zstd";
+  RecordingWriter writer;
+  handler_.Handle(request, writer);
+
+  EXPECT_EQ(writer.content_encoding, "");
+  EXPECT_TRUE(writer.has_length);
+}
+
+TEST_F(ScrapeHandlerTest, shouldServeLastResponseWithinMinimumInterval) {
+  handler_.LimitCollections(0, std::chrono::hours{1});
+  auto& counter =
+      BuildCounter().Name("limited_total").Register(*registry_).Add({});
+  auto openmetrics = ScrapeHandler::Request{};
+  openmetrics.accept = "application/openmetrics-text";
+  auto filtered = ScrapeHandler::Request{};
+  filtered.query_string = "name[]=limited_total";
+
+  const auto collected = handler_.Handle(ScrapeHandler::Request{});
+  counter.Increment();
+  const auto last = handler_.Handle(ScrapeHandler::Request{});
+  const auto rejected = handler_.Handle(openmetrics);
+  const auto rejected_filtered = handler_.Handle(filtered);
+
+  EXPECT_EQ(collected.status, ScrapeHandler::Status::Ok);
+  EXPECT_EQ(last.status, ScrapeHandler::Status::Ok);
+  EXPECT_EQ(last.body, collected.body);
+  EXPECT_THAT(last.body, HasSubstr("limited_total 0\n"));
+  EXPECT_EQ(rejected.status, ScrapeHandler::Status::TooFrequent);
+  EXPECT_EQ(rejected.body, "");
+  EXPECT_EQ(rejected_filtered.status, ScrapeHandler::Status::TooFrequent);
+}
+
+TEST_F(ScrapeHandlerTest, shouldServeLastSharedResponseWithinInterval) {
+  handler_.LimitCollections(0, std::chrono::hours{1});
+  handler_.ShareResponses(std::chrono::milliseconds{0});
+
+  const auto collected = handler_.Handle(ScrapeHandler::Request{});
+  const auto last = handler_.Handle(ScrapeHandler::Request{});
+
+  EXPECT_EQ(collected.status, ScrapeHandler::Status::Ok);
+  EXPECT_EQ(last.status, ScrapeHandler::Status::Ok);
+  EXPECT_EQ(last.body, collected.body);
+}
+
+TEST_F(ScrapeHandlerTest, shouldNotShareFilteredResponses) {
+  handler_.ShareResponses(std::chrono::hours{1});
+  auto& counter =
+      BuildCounter().Name("filtered_total").Register(*registry_).Add({});
+
+  for (int i = 0; i < 100; ++i) {
+    counter.Increment();
+    auto request = ScrapeHandler::Request{};
+    request.query_string =
+        "name[]=filtered_total&name[]=other_" + std::to_string(i);
+    EXPECT_THAT(handler_.Handle(request).body,
+                HasSubstr("filtered_total " + std::to_string(i + 1) + "\n"));
+  }
+
+  // none of the filtered scrapes left a shared response behind
+  auto request = ScrapeHandler::Request{};
+  request.query_string = "name[]=exposer_shared_responses_total";
+  const auto response = handler_.Handle(request);
+  EXPECT_THAT(response.body,
+              HasSubstr("exposer_shared_responses_total{result=\"miss\"} 0"));
+}
+
+TEST_F(ScrapeHandlerTest, shouldNotPrerenderFilteredResponses) {
+  handler_.PrerenderResponses(std::chrono::hours{1});
+  auto& counter =
+      BuildCounter().Name("filtered_total").Register(*registry_).Add({});
+  auto request = ScrapeHandler::Request{};
+  request.query_string = "name[]=filtered_total";
+
+  for (int i = 1; i <= 3; ++i) {
+    counter.Increment();
+    EXPECT_THAT(handler_.Handle(request).body,
+                HasSubstr("filtered_total " + std::to_string(i) + "\n"));
+  }
+}
+
+TEST_F(ScrapeHandlerTest, shouldRenderOnCollectionExecutor) {
+  CollectionExecutor executor;
+  handler_.SetCollectionExecutor(executor.AsExecutor());
+
+  RecordingWriter writer;
+  EXPECT_EQ(handler_.Handle(ScrapeHandler::Request{}, writer),
+            ScrapeHandler::Status::Ok);
+
+  // streamed from the executor, not buffered as a whole
+  EXPECT_EQ(writer.begun, 1);
+  EXPECT_FALSE(writer.has_length);
+  EXPECT_THAT(writer.body, HasSubstr("requests_total{id=\"999\"} 1\n"));
+  handler_.SetCollectionExecutor(nullptr);
+}
+
+TEST_F(ScrapeHandlerTest, shouldHandleScrapesOnExecutor) {
+  std::vector<std::function<void()>> tasks;
+  auto executor = [&tasks](std::function<void()> task) {
+    tasks.push_back(std::move(task));
+  };
+  std::vector<ScrapeHandler::Response> responses;
+  auto done = [&responses](ScrapeHandler::Response response) {
+    responses.push_back(std::move(response));
+  };
+
+  handler_.HandleAsync(ScrapeHandler::Request{}, executor, done);
+
+  ASSERT_EQ(tasks.size(), 1U);
+  EXPECT_TRUE(responses.empty());
+
+  tasks.front()();
+
+  ASSERT_EQ(responses.size(), 1U);
+  EXPECT_THAT(responses.front().body,
+              HasSubstr("requests_total{id=\"999\"} 1\n"));
+}
+
+}  // namespace
+}  // namespace prometheus
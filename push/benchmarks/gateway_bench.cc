@@ -0,0 +1,203 @@
+#include <arpa/inet.h>
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "prometheus/counter.h"
+#include "prometheus/family.h"
+#include "prometheus/gateway.h"
+#include "prometheus/registry.h"
+
+namespace {
+
+// Stands in for a pushgateway on the loopback interface. Every request is
+// answered with "200 OK" after the delay, which stands for the round trip
+// to a remote gateway. Connections are kept alive and served by a thread
+// each.
+class StandInGateway {
+ public:
+  explicit StandInGateway(std::chrono::microseconds delay) : delay_(delay) {
+    listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (listener_ < 0 ||
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), length) !=
+            0 ||
+        ::listen(listener_, SOMAXCONN) != 0 ||
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address),
+                      &length) != 0) {
+      throw std::runtime_error("cannot listen on the loopback interface");
+    }
+    port_ = ntohs(address.sin_port);
+    threads_.emplace_back([this] { Accept(); });
+  }
+
+  ~StandInGateway() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+      for (auto fd : connections_) {
+        ::shutdown(fd, SHUT_RDWR);
+      }
+    }
+    ::shutdown(listener_, SHUT_RDWR);
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    ::close(listener_);
+  }
+
+  StandInGateway(const StandInGateway&) = delete;
+  StandInGateway& operator=(const StandInGateway&) = delete;
+
+  std::string Url() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+  }
+
+  int Connections() const { return accepted_; }
+
+ private:
+  void Accept() {
+    for (;;) {
+      const auto fd = ::accept(listener_, nullptr, nullptr);
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (fd < 0 || stopping_) {
+        if (fd >= 0) {
+          ::close(fd);
+        }
+        return;
+      }
+      ++accepted_;
+      connections_.push_back(fd);
+      threads_.emplace_back([this, fd] { Serve(fd); });
+    }
+  }
+
+  void Serve(int fd) {
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    static const char kResponse[] =
+        "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    std::string input;
+    char buffer[16 * 1024];
+    for (;;) {
+      const auto head_end = input.find("\r\n\r\n");
+      if (head_end == std::string::npos) {
+        const auto count = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (count <= 0) {
+          break;
+        }
+        input.append(buffer, static_cast<std::size_t>(count));
+        continue;
+      }
+
+      std::size_t body_size = 0;
+      const auto header = FindHeader(input, head_end, "content-length:");
+      if (header != std::string::npos) {
+        body_size = std::strtoul(input.c_str() + header, nullptr, 10);
+      }
+      const auto request_size = head_end + 4 + body_size;
+      while (input.size() < request_size) {
+        const auto count = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (count <= 0) {
+          ::close(fd);
+          return;
+        }
+        input.append(buffer, static_cast<std::size_t>(count));
+      }
+      input.erase(0, request_size);
+
+      std::this_thread::sleep_for(delay_);
+      if (::send(fd, kResponse, sizeof(kResponse) - 1, MSG_NOSIGNAL) < 0) {
+        break;
+      }
+    }
+    ::close(fd);
+  }
+
+  // Returns where the value of the header starts, npos if not sent
+  static std::size_t FindHeader(const std::string& input, std::size_t end,
+                                const char* name) {
+    const auto size = std::char_traits<char>::length(name);
+    for (auto pos = input.find("\r\n"); pos < end;
+         pos = input.find("\r\n", pos + 2)) {
+      if (::strncasecmp(input.c_str() + pos + 2, name, size) == 0) {
+        return pos + 2 + size;
+      }
+    }
+    return std::string::npos;
+  }
+
+  const std::chrono::microseconds delay_;
+  int listener_ = -1;
+  int port_ = 0;
+  std::atomic<int> accepted_{0};
+  std::mutex mutex_;
+  bool stopping_ = false;
+  std::vector<int> connections_;
+  std::vector<std::thread> threads_;
+};
+
+// Pushes a registry per collectable, each with 100 series, to a gateway
+// answering after 200us
+void PushToGateway(benchmark::State& state, bool async) {
+  StandInGateway stand_in{std::chrono::microseconds{200}};
+  prometheus::Gateway gateway{stand_in.Url(), std::function<void(CURL*)>{},
+                              "benchmark"};
+  std::vector<std::shared_ptr<prometheus::Registry>> registries;
+  for (auto i = 0; i < state.range(0); ++i) {
+    auto registry = std::make_shared<prometheus::Registry>();
+    auto& family =
+        prometheus::BuildCounter().Name("requests_total").Register(*registry);
+    for (auto j = 0; j < 100; ++j) {
+      family.Add({{"id", std::to_string(j)}}).Increment();
+    }
+    const auto labels = prometheus::Labels{{"shard", std::to_string(i)}};
+    gateway.RegisterCollectable(registry, &labels);
+    registries.push_back(std::move(registry));
+  }
+
+  for (auto _ : state) {
+    const auto status = async ? gateway.AsyncPush().get() : gateway.Push();
+    if (status != 200) {
+      state.SkipWithError("push failed");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["connections"] = stand_in.Connections();
+}
+
+}  // namespace
+
+static void BM_Gateway_Push(benchmark::State& state) {
+  PushToGateway(state, false);
+}
+BENCHMARK(BM_Gateway_Push)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+
+static void BM_Gateway_AsyncPush(benchmark::State& state) {
+  PushToGateway(state, true);
+}
+BENCHMARK(BM_Gateway_AsyncPush)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->UseRealTime();
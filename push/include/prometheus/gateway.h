@@ -12,16 +12,20 @@
 #include <vector>
 
 #include "prometheus/collectable.h"
+#include "prometheus/collection_executor.h"
 #include "prometheus/detail/http_method.h"
 #include "prometheus/detail/push_export.h"
 #include "prometheus/labels.h"
+#include "prometheus/periodic_push_options.h"
 
 
 namespace prometheus {
 
 namespace detail {
+class Codec;
 class CurlWrapper;
-}
+class PeriodicPusher;
+}  // namespace detail
 
 class PROMETHEUS_CPP_PUSH_EXPORT Gateway {
  public:
@@ -78,22 +82,73 @@ class PROMETHEUS_CPP_PUSH_EXPORT Gateway {
   /// \return true on success, otherwise false
   bool AddHttpHeader(const std::string& header);
 
+  /// \brief Compresses pushed metrics.
+  ///
+  /// The push gateway accepts gzip compressed metrics.
+  ///
+  /// \param encoding "gzip", "zstd" or empty to send metrics uncompressed.
+  /// \return false if the encoding is not supported by this build, i.e., it
+  /// was built without ENABLE_COMPRESSION or ENABLE_ZSTD respectively.
+  bool SetContentEncoding(const std::string& encoding);
+
+  /// \brief Collects, serializes and compresses metrics on the executor.
+  ///
+  /// E.g., CollectionExecutor::AsExecutor() of threads pinned to
+  /// housekeeping cores with a low priority. Push() waits for the
+  /// serialized metrics and sends them from its own thread, AsyncPush()
+  /// returns right away. nullptr serializes on the pushing thread again,
+  /// respectively on the thread sending the asynchronous pushes.
+  void SetCollectionExecutor(Executor executor);
+
+  /// \brief Pushes the registered collectables in the background.
+  ///
+  /// A background thread pushes every interval with a random jitter. A push
+  /// still in flight when the next one is due is not overlapped, the missed
+  /// pushes are coalesced into the next one. Failed pushes are retried with
+  /// an exponentially growing wait. Set a timeout for slow gateways, see
+  /// the constructor. The pushes are measured by gateway_pushes_total and
+  /// gateway_push_duration_seconds, which are pushed as well with the
+  /// additional grouping label component="gateway". Replaces earlier
+  /// periodic pushing.
+  void StartPeriodicPush(const PeriodicPushOptions& options);
+
+  /// \brief Stops pushing in the background, waiting for a push in flight.
+  void StopPeriodicPush();
+
  private:
   std::string jobUri_;
   std::string labels_;
-  std::unique_ptr<detail::CurlWrapper> curlWrapper_;
+  // shared with the asynchronous pushes running on an executor
+  std::shared_ptr<detail::CurlWrapper> curlWrapper_;
   std::mutex mutex_;
+  std::shared_ptr<const detail::Codec> codec_;
+  Executor collection_executor_;
 
   using CollectableEntry = std::pair<std::weak_ptr<Collectable>, std::string>;
   std::vector<CollectableEntry> collectables_;
 
   std::string getUri(const CollectableEntry& collectable) const;
 
+  // what a push works on, taken under mutex_ so neither collecting nor
+  // sending holds it
+  struct PushSnapshot {
+    std::vector<std::pair<std::shared_ptr<Collectable>, std::string>>
+        collectables;
+    std::shared_ptr<const detail::Codec> codec;
+    Executor executor;
+  };
+
+  PushSnapshot snapshot();
+
   int push(detail::HttpMethod method);
 
   std::future<int> async_push(detail::HttpMethod method);
 
   static void CleanupStalePointers(std::vector<CollectableEntry>& collectables);
+
+  std::mutex periodic_pusher_mutex_;
+  // last, so it stops before the members its pushes use are destroyed
+  std::unique_ptr<detail::PeriodicPusher> periodic_pusher_;
 };
 
 }  // namespace prometheus
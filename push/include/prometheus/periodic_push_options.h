@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+namespace prometheus {
+
+/// \brief Settings for pushing in the background, see
+/// Gateway::StartPeriodicPush().
+struct PeriodicPushOptions {
+  /// Time between the starts of two pushes.
+  std::chrono::milliseconds interval = std::chrono::seconds{15};
+
+  /// Fraction of the interval each wait is randomly shortened or stretched
+  /// by, from 0 to 1, so many instances do not push at the same time.
+  double jitter = 0.1;
+
+  /// Longest wait after failed pushes. The wait doubles with each
+  /// consecutive failure, starting at the interval.
+  std::chrono::milliseconds max_backoff = std::chrono::minutes{5};
+
+  /// Pushes with PushAdd() instead of Push(), i.e., only replaces the
+  /// metrics with the same names.
+  bool push_add = false;
+};
+
+}  // namespace prometheus
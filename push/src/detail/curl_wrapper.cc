@@ -1,6 +1,13 @@
 #include "curl_wrapper.h"
 
+#include <algorithm>
+#include <future>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "prometheus/detail/future_std.h"
 
 namespace prometheus {
 namespace detail {
@@ -8,6 +15,31 @@ namespace detail {
 static const char CONTENT_TYPE[] =
     "Content-Type: text/plain; version=0.0.4; charset=utf-8";
 
+// connections kept open to the gateway, further requests wait for one
+static const long kMaxConnections = 8;
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+// curl_multi_wakeup() interrupts the wait for new requests
+static const int kPollTimeoutMs = 1000;
+#else
+// without curl_multi_wakeup(), requests arriving while others are in flight
+// wait for the next poll, idle threads wait on a condition variable instead
+static const int kPollTimeoutMs = 10;
+#endif
+
+struct CurlWrapper::Request {
+  ~Request() { curl_slist_free_all(headers); }
+
+  HttpMethod method;
+  std::string uri;
+  std::string body;
+  // copy of the shared headers, so adding headers does not race with
+  // requests in flight
+  curl_slist* headers = nullptr;
+  Callback done;
+  CURL* curl = nullptr;
+};
+
 CurlWrapper::CurlWrapper(std::function<void(CURL*)> presetupCurl)
     : presetupCurl_(presetupCurl) {
   /* In windows, this will init the winsock stuff */
@@ -16,86 +48,236 @@ CurlWrapper::CurlWrapper(std::function<void(CURL*)> presetupCurl)
     throw std::runtime_error("Cannot initialize global curl!");
   }
 
-  curl_ = curl_easy_init();
-  if (!curl_) {
+  multi_ = curl_multi_init();
+  if (!multi_) {
     curl_global_cleanup();
-    throw std::runtime_error("Cannot initialize easy curl!");
-  }
-
-  if (presetupCurl_) {
-    presetupCurl_(curl_);  
+    throw std::runtime_error("Cannot initialize multi curl!");
   }
+  curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, kMaxConnections);
+  curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, kMaxConnections);
 
   optHttpHeader_ = curl_slist_append(nullptr, CONTENT_TYPE);
   if (!optHttpHeader_) {
+    curl_multi_cleanup(multi_);
+    curl_global_cleanup();
     throw std::runtime_error("Cannot append the header of the content type");
   }
 }
 
 CurlWrapper::~CurlWrapper() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  Wakeup();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  for (auto curl : idle_handles_) {
+    curl_easy_cleanup(curl);
+  }
+  curl_multi_cleanup(multi_);
   curl_slist_free_all(optHttpHeader_);
-  curl_easy_cleanup(curl_);
   curl_global_cleanup();
 }
 
 int CurlWrapper::performHttpRequest(HttpMethod method, const std::string& uri,
-                                    const std::string& body) {
-  std::lock_guard<std::mutex> l(mutex_);
+                                    std::string body,
+                                    const char* content_encoding) {
+  auto status = std::make_shared<std::promise<int>>();
+  auto result = status->get_future();
+  performHttpRequestAsync(method, uri, std::move(body), content_encoding,
+                          [status](int code) { status->set_value(code); });
+  return result.get();
+}
 
-  curl_easy_reset(curl_);
-  curl_easy_setopt(curl_, CURLOPT_URL, uri.c_str());
+void CurlWrapper::performHttpRequestAsync(HttpMethod method,
+                                          const std::string& uri,
+                                          std::string body,
+                                          const char* content_encoding,
+                                          Callback done) {
+  auto request = detail::make_unique<Request>();
+  request->method = method;
+  request->uri = uri;
+  request->body = std::move(body);
+  request->done = std::move(done);
+  if (content_encoding) {
+    const auto header = std::string{"Content-Encoding: "} + content_encoding;
+    request->headers = curl_slist_append(nullptr, header.c_str());
+  }
 
-  curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, optHttpHeader_);
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto header = optHttpHeader_; header; header = header->next) {
+      request->headers = curl_slist_append(request->headers, header->data);
+    }
+    queued_.push_back(std::move(request));
+    EnsureRunning();
+  }
+  Wakeup();
+}
+
+void CurlWrapper::post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    tasks_.push_back(std::move(task));
+    EnsureRunning();
+  }
+  Wakeup();
+}
+
+bool CurlWrapper::addHttpHeader(const std::string& header) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto updated_header = curl_slist_append(optHttpHeader_, header.c_str());
+  if (!updated_header) {
+    return false;
+  }
+
+  optHttpHeader_ = updated_header;
+  return true;
+}
+
+// Starts the thread, mutex_ has to be held
+void CurlWrapper::EnsureRunning() {
+  if (!thread_.joinable()) {
+    thread_ = std::thread{&CurlWrapper::Run, this};
+  }
+}
+
+void CurlWrapper::Run() {
+  for (;;) {
+    std::vector<std::function<void()>> tasks;
+    std::vector<std::unique_ptr<Request>> queued;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      // nothing to poll while no request is in flight
+      wakeup_.wait(lock, [this] {
+        return stopping_ || !tasks_.empty() || !queued_.empty() ||
+               !running_.empty();
+      });
+      tasks.swap(tasks_);
+      queued.swap(queued_);
+      if (stopping_ && tasks.empty() && queued.empty() && running_.empty()) {
+        return;
+      }
+    }
+    if (!tasks.empty()) {
+      for (auto& task : tasks) {
+        task();
+      }
+      // starts the requests of the tasks right away
+      std::lock_guard<std::mutex> lock{mutex_};
+      std::move(queued_.begin(), queued_.end(), std::back_inserter(queued));
+      queued_.clear();
+    }
+    for (auto& request : queued) {
+      Start(std::move(request));
+    }
+
+    int running = 0;
+    curl_multi_perform(multi_, &running);
+    int pending = 0;
+    while (auto message = curl_multi_info_read(multi_, &pending)) {
+      if (message->msg == CURLMSG_DONE) {
+        Finish(message->easy_handle, message->data.result);
+      }
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_poll(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+#else
+    curl_multi_wait(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+#endif
+  }
+}
+
+void CurlWrapper::Wakeup() {
+  wakeup_.notify_one();
+#if LIBCURL_VERSION_NUM >= 0x074400
+  curl_multi_wakeup(multi_);
+#endif
+}
+
+void CurlWrapper::Start(std::unique_ptr<Request> request) {
+  CURL* curl = nullptr;
+  if (idle_handles_.empty()) {
+    curl = curl_easy_init();
+  } else {
+    curl = idle_handles_.back();
+    idle_handles_.pop_back();
+  }
+  if (!curl || !request->headers) {
+    if (curl) {
+      idle_handles_.push_back(curl);
+    }
+    request->done(-CURLE_OUT_OF_MEMORY);
+    return;
+  }
+
+  request->curl = curl;
+  curl_easy_setopt(curl, CURLOPT_URL, request->uri.c_str());
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request->headers);
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
   if (presetupCurl_) {
-    presetupCurl_(curl_);  
+    presetupCurl_(curl);
   }
 
-  if (!body.empty()) {
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, body.size());
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body.data());
+  if (!request->body.empty()) {
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(request->body.size()));
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->body.data());
   } else {
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, 0L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
   }
 
-  switch (method) {
+  switch (request->method) {
     case HttpMethod::Post:
-      curl_easy_setopt(curl_, CURLOPT_POST, 1L);
+      curl_easy_setopt(curl, CURLOPT_POST, 1L);
       break;
 
     case HttpMethod::Put:
-      curl_easy_setopt(curl_, CURLOPT_NOBODY, 0L);
-      curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "PUT");
+      curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
       break;
 
     case HttpMethod::Delete:
-      curl_easy_setopt(curl_, CURLOPT_HTTPGET, 0L);
-      curl_easy_setopt(curl_, CURLOPT_NOBODY, 0L);
-      curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
+      curl_easy_setopt(curl, CURLOPT_HTTPGET, 0L);
+      curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
       break;
   }
 
-  auto curl_error = curl_easy_perform(curl_);
-
-  long response_code;
-  curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response_code);
-
-  if (curl_error != CURLE_OK) {
-    return -curl_error;
+  if (curl_multi_add_handle(multi_, curl) != CURLM_OK) {
+    curl_easy_reset(curl);
+    idle_handles_.push_back(curl);
+    request->done(-CURLE_FAILED_INIT);
+    return;
   }
-
-  return response_code;
+  running_.push_back(std::move(request));
 }
 
-bool CurlWrapper::addHttpHeader(const std::string& header) {
-  std::lock_guard<std::mutex> lock{mutex_};
-  auto updated_header = curl_slist_append(optHttpHeader_, header.c_str());
-  if (!updated_header) {
-    return false;
+void CurlWrapper::Finish(CURL* curl, CURLcode result) {
+  auto it = std::find_if(running_.begin(), running_.end(),
+                         [curl](const std::unique_ptr<Request>& request) {
+                           return request->curl == curl;
+                         });
+  if (it == running_.end()) {
+    return;
   }
+  auto request = std::move(*it);
+  running_.erase(it);
 
-  optHttpHeader_ = updated_header;
-  return true;
+  long response_code = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+  curl_multi_remove_handle(multi_, curl);
+  // the connection stays in the cache of the multi handle
+  curl_easy_reset(curl);
+  idle_handles_.push_back(curl);
+
+  request->done(result == CURLE_OK ? static_cast<int>(response_code)
+                                   : -static_cast<int>(result));
 }
 
 }  // namespace detail
@@ -1,16 +1,31 @@
 #include <curl/curl.h>
 
+#include <condition_variable>
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "prometheus/detail/http_method.h"
 
 namespace prometheus {
 namespace detail {
 
+/// \brief Performs the HTTP requests of a Gateway with curl multi.
+///
+/// A single thread runs the requests of all callers concurrently. It is
+/// started by the first request and sleeps while none is in flight. Easy
+/// handles are pooled and the multi handle keeps their connections alive,
+/// so repeated pushes to the same gateway reuse their connections.
 class CurlWrapper {
  public:
+  /// \brief Called with the HTTP status code of a request, or the negated
+  /// curl error code if it failed.
+  using Callback = std::function<void(int)>;
+
   CurlWrapper(std::function<void(CURL*)> presetupCurl);
 
   CurlWrapper(const CurlWrapper&) = delete;
@@ -18,17 +33,56 @@ class CurlWrapper {
   CurlWrapper& operator=(const CurlWrapper&) = delete;
   CurlWrapper& operator=(CurlWrapper&&) = delete;
 
+  /// \brief Waits for the requests in flight.
   ~CurlWrapper();
 
+  /// \brief Performs the request, blocking until it is done.
   int performHttpRequest(HttpMethod method, const std::string& uri,
-                         const std::string& body = {});
+                         std::string body = {},
+                         const char* content_encoding = nullptr);
+
+  /// \brief Starts the request and returns immediately.
+  ///
+  /// \param done Called on the thread of the wrapper once the request is
+  /// done, it must not block.
+  void performHttpRequestAsync(HttpMethod method, const std::string& uri,
+                               std::string body, const char* content_encoding,
+                               Callback done);
+
+  /// \brief Runs the task on the thread of the wrapper and returns
+  /// immediately.
+  ///
+  /// E.g., to prepare the bodies of requests off the calling thread. The
+  /// task delays the requests in flight, it must not block. Tasks posted
+  /// before the wrapper is destroyed still run.
+  void post(std::function<void()> task);
+
   bool addHttpHeader(const std::string& header);
 
  private:
-  CURL* curl_;
+  struct Request;
+
+  void EnsureRunning();
+  void Run();
+  void Wakeup();
+  void Start(std::unique_ptr<Request> request);
+  void Finish(CURL* curl, CURLcode result);
+
+  CURLM* multi_;
   std::mutex mutex_;
   curl_slist* optHttpHeader_;
   std::function<void(CURL*)> presetupCurl_;
+  // signals the thread of the wrapper while it is idle
+  std::condition_variable wakeup_;
+  // requests not yet handed to the multi handle
+  std::vector<std::unique_ptr<Request>> queued_;
+  std::vector<std::function<void()>> tasks_;
+  // only used by the thread of the wrapper
+  std::vector<std::unique_ptr<Request>> running_;
+  std::vector<CURL*> idle_handles_;
+  bool stopping_ = false;
+  // started with the first request or task
+  std::thread thread_;
 };
 
 }  // namespace detail
@@ -0,0 +1,107 @@
+#include "periodic_pusher.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace prometheus {
+namespace detail {
+
+PeriodicPusher::PeriodicPusher(std::function<int()> push,
+                               const PeriodicPushOptions& options)
+    : push_(std::move(push)),
+      options_(options),
+      registry_(std::make_shared<Registry>()),
+      pushes_family_(BuildCounter()
+                         .Name("gateway_pushes_total")
+                         .Help("Periodic pushes by whether they succeeded, "
+                               "or were coalesced into the next push "
+                               "because the previous one was in flight")
+                         .Register(*registry_)),
+      succeeded_(pushes_family_.Add({{"result", "success"}})),
+      failed_(pushes_family_.Add({{"result", "failure"}})),
+      coalesced_(pushes_family_.Add({{"result", "coalesced"}})),
+      duration_(BuildHistogram()
+                    .Name("gateway_push_duration_seconds")
+                    .Help("Duration of periodic pushes")
+                    .Register(*registry_)
+                    .Add({}, Histogram::BucketBoundaries{
+                                 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 30})),
+      random_(std::random_device{}()) {
+  thread_ = std::thread{&PeriodicPusher::Run, this};
+}
+
+PeriodicPusher::~PeriodicPusher() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  stop_.notify_all();
+  thread_.join();
+}
+
+std::shared_ptr<Registry> PeriodicPusher::GetRegistry() const {
+  return registry_;
+}
+
+PeriodicPusher::Clock::duration PeriodicPusher::Backoff(
+    Clock::duration interval, Clock::duration max_backoff,
+    std::size_t failures) {
+  const auto limit = std::max(interval, max_backoff);
+  auto wait = interval;
+  for (std::size_t i = 0; i < failures && wait < limit; ++i) {
+    wait *= 2;
+  }
+  return std::min(wait, limit);
+}
+
+PeriodicPusher::Clock::duration PeriodicPusher::Jitter(Clock::duration wait) {
+  const auto jitter = std::min(std::max(options_.jitter, 0.0), 1.0);
+  if (jitter == 0) {
+    return wait;
+  }
+  std::uniform_real_distribution<double> factor{1 - jitter, 1 + jitter};
+  return std::max(
+      std::chrono::duration_cast<Clock::duration>(wait * factor(random_)),
+      Clock::duration{std::chrono::milliseconds{1}});
+}
+
+void PeriodicPusher::Run() {
+  const Clock::duration interval =
+      std::max(options_.interval, std::chrono::milliseconds{1});
+  std::size_t failures = 0;
+  auto next = Clock::now();
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (!stop_.wait_until(lock, next, [this] { return stopping_; })) {
+    lock.unlock();
+    const auto start = Clock::now();
+    auto status_code = 0;
+    try {
+      status_code = push_();
+    } catch (...) {
+      // e.g., a collectable failed, counted like a failed request, whatever
+      // it threw, so pushing goes on
+    }
+    const auto end = Clock::now();
+    duration_.Observe(std::chrono::duration<double>{end - start}.count());
+
+    if (status_code >= 100 && status_code < 400) {
+      succeeded_.Increment();
+      failures = 0;
+    } else {
+      failed_.Increment();
+      ++failures;
+    }
+
+    // ticks passing during the push are coalesced into the next one
+    const auto wait =
+        Jitter(Backoff(interval, options_.max_backoff, failures));
+    const auto missed = (end - start) / wait;
+    coalesced_.Increment(static_cast<double>(missed));
+    next = start + (missed + 1) * wait;
+    lock.lock();
+  }
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "prometheus/counter.h"
+#include "prometheus/detail/push_export.h"
+#include "prometheus/family.h"
+#include "prometheus/histogram.h"
+#include "prometheus/periodic_push_options.h"
+#include "prometheus/registry.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Pushes on a background thread.
+///
+/// Pushes never overlap: ticks passing while a push is in flight are
+/// coalesced into the next push, so a slow gateway does not pile up
+/// requests. Failed pushes back off exponentially. Metrics about the
+/// pushes are kept in a registry of their own.
+class PROMETHEUS_CPP_PUSH_EXPORT PeriodicPusher {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// \param push Pushes and returns the HTTP status code, or a negative
+  /// curl error code.
+  PeriodicPusher(std::function<int()> push, const PeriodicPushOptions& options);
+
+  /// \brief Stops pushing, waiting for a push in flight.
+  ~PeriodicPusher();
+
+  PeriodicPusher(const PeriodicPusher&) = delete;
+  PeriodicPusher(PeriodicPusher&&) = delete;
+  PeriodicPusher& operator=(const PeriodicPusher&) = delete;
+  PeriodicPusher& operator=(PeriodicPusher&&) = delete;
+
+  /// \brief Returns the registry of the metrics about the pushes.
+  std::shared_ptr<Registry> GetRegistry() const;
+
+  /// \brief Returns the wait after the given number of consecutive
+  /// failures, without jitter.
+  static Clock::duration Backoff(Clock::duration interval,
+                                 Clock::duration max_backoff,
+                                 std::size_t failures);
+
+ private:
+  void Run();
+  Clock::duration Jitter(Clock::duration wait);
+
+  const std::function<int()> push_;
+  const PeriodicPushOptions options_;
+  std::shared_ptr<Registry> registry_;
+  Family<Counter>& pushes_family_;
+  Counter& succeeded_;
+  Counter& failed_;
+  Counter& coalesced_;
+  Histogram& duration_;
+  std::mt19937 random_;
+  std::mutex mutex_;
+  std::condition_variable stop_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace detail
+}  // namespace prometheus
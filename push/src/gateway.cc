@@ -2,16 +2,28 @@
 #include "prometheus/gateway.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <future>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <ostream>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "detail/curl_wrapper.h"
 #include "detail/label_encoder.h"
+#include "detail/periodic_pusher.h"
+#include "prometheus/detail/content_codec.h"
 #include "prometheus/detail/future_std.h"
-#include "prometheus/metric_family.h"  // IWYU pragma: keep
+#include "prometheus/detail/gzip_codec.h"
+#include "prometheus/detail/zstd_codec.h"
+#include "prometheus/metric_sink.h"
+#include "prometheus/serializer.h"
 #include "prometheus/text_serializer.h"
 
 // IWYU pragma: no_include <system_error>
@@ -48,6 +60,78 @@ std::string concatenate(const std::string& host, const std::string& port) {
   ss << host << ":" << port;
   return ss.str();
 }
+
+// Finishes the sink only if collecting did not throw
+void collectInto(std::ostream& out, const Serializer& serializer,
+                 Collectable& collectable) {
+  auto sink = serializer.MakeSink(out);
+  collectable.Collect(*sink);
+  sink->Finish();
+}
+
+// Serializes the metrics, compressed while collecting if there is a codec.
+// content_encoding is set to the name of the codec if compressing succeeded.
+std::string serialize(Collectable& collectable, const detail::Codec* codec,
+                      const char*& content_encoding) {
+  const auto serializer = TextSerializer{};
+  std::ostringstream body;
+  std::vector<char> buffer;
+  std::unique_ptr<detail::Encoder> encoder;
+  if (codec) {
+    buffer.resize(16 * 1024);
+    encoder = codec->MakeEncoder(*body.rdbuf(), buffer);
+  }
+
+  if (!encoder || !encoder->Good()) {
+    collectInto(body, serializer, collectable);
+    content_encoding = nullptr;
+    return body.str();
+  }
+
+  {
+    std::ostream out{encoder.get()};
+    collectInto(out, serializer, collectable);
+  }
+  content_encoding = encoder->Finish() ? codec->Name() : nullptr;
+  if (!content_encoding) {
+    // start over uncompressed
+    body.str({});
+    collectInto(body, serializer, collectable);
+  }
+  return body.str();
+}
+
+// Serializes on the executor if there is one
+std::string serializeOn(const Executor& executor, Collectable& collectable,
+                        const detail::Codec* codec,
+                        const char*& content_encoding) {
+  if (!executor) {
+    return serialize(collectable, codec, content_encoding);
+  }
+
+  std::promise<std::string> serialized;
+  auto result = serialized.get_future();
+  executor([&] {
+    try {
+      serialized.set_value(serialize(collectable, codec, content_encoding));
+    } catch (...) {
+      serialized.set_exception(std::current_exception());
+    }
+  });
+  return result.get();
+}
+
+// Performs the request on the thread of the curl wrapper
+std::future<int> asyncRequest(detail::CurlWrapper& curlWrapper,
+                              detail::HttpMethod method,
+                              const std::string& uri) {
+  auto status = std::make_shared<std::promise<int>>();
+  auto result = status->get_future();
+  curlWrapper.performHttpRequestAsync(
+      method, uri, {}, nullptr,
+      [status](int status_code) { status->set_value(status_code); });
+  return result;
+}
 }  // namespace
 
 Gateway::Gateway(const std::string& host, const std::string& port,
@@ -65,7 +149,7 @@ Gateway::Gateway(const std::string& host, const std::string& port,
 Gateway::Gateway(const std::string& url,
                  std::function<void(CURL*)> presetupCurl,
                  const std::string& jobname, const Labels& labels) {
-  curlWrapper_ = detail::make_unique<detail::CurlWrapper>(presetupCurl);
+  curlWrapper_ = std::make_shared<detail::CurlWrapper>(presetupCurl);
 
   std::stringstream jobUriStream;
   jobUriStream << url;
@@ -118,20 +202,31 @@ int Gateway::Push() { return push(detail::HttpMethod::Post); }
 
 int Gateway::PushAdd() { return push(detail::HttpMethod::Put); }
 
-int Gateway::push(detail::HttpMethod method) {
-  const auto serializer = TextSerializer{};
-
+Gateway::PushSnapshot Gateway::snapshot() {
+  auto pushed = PushSnapshot{};
   std::lock_guard<std::mutex> lock{mutex_};
   for (auto& wcollectable : collectables_) {
     auto collectable = wcollectable.first.lock();
-    if (!collectable) {
-      continue;
+    if (collectable) {
+      pushed.collectables.emplace_back(std::move(collectable),
+                                       getUri(wcollectable));
     }
+  }
+  pushed.codec = codec_;
+  pushed.executor = collection_executor_;
+  return pushed;
+}
 
-    auto metrics = collectable->Collect();
-    auto body = serializer.Serialize(metrics);
-    auto uri = getUri(wcollectable);
-    auto status_code = curlWrapper_->performHttpRequest(method, uri, body);
+int Gateway::push(detail::HttpMethod method) {
+  // the executor may be busy with a push of its own, so waiting for it must
+  // not block other threads registering collectables or pushing
+  const auto pushed = snapshot();
+  for (const auto& collectable : pushed.collectables) {
+    const char* content_encoding;
+    auto body = serializeOn(pushed.executor, *collectable.first,
+                            pushed.codec.get(), content_encoding);
+    auto status_code = curlWrapper_->performHttpRequest(
+        method, collectable.second, std::move(body), content_encoding);
 
     if (status_code < 100 || status_code >= 400) {
       return status_code;
@@ -150,40 +245,72 @@ std::future<int> Gateway::AsyncPushAdd() {
 }
 
 std::future<int> Gateway::async_push(detail::HttpMethod method) {
-  const auto serializer = TextSerializer{};
-  std::vector<std::future<int>> futures;
-
-  std::lock_guard<std::mutex> lock{mutex_};
-  for (auto& wcollectable : collectables_) {
-    auto collectable = wcollectable.first.lock();
-    if (!collectable) {
-      continue;
+  // completed by the last request, the requests run concurrently on the
+  // thread of the curl wrapper
+  struct Pushes {
+    std::mutex mutex;
+    std::promise<int> promise;
+    // one more while requests are started, so early ones cannot complete
+    // the push
+    std::size_t pending = 1;
+    int final_status_code = 200;
+    // thrown by a collectable, rethrown by the future
+    std::exception_ptr error;
+  };
+  auto pushes = std::make_shared<Pushes>();
+  auto result = pushes->promise.get_future();
+  auto done = [pushes](int status_code) {
+    std::lock_guard<std::mutex> lock{pushes->mutex};
+    if (status_code < 100 || status_code >= 400) {
+      pushes->final_status_code = status_code;
     }
-
-    auto metrics = collectable->Collect();
-    auto body = std::make_shared<std::string>(serializer.Serialize(metrics));
-    auto uri = getUri(wcollectable);
-
-    futures.push_back(std::async(std::launch::async, [method, uri, body, this] {
-      return curlWrapper_->performHttpRequest(method, uri, *body);
-    }));
-  }
-
-  const auto reduceFutures = [](std::vector<std::future<int>> lfutures) {
-    auto final_status_code = 200;
-
-    for (auto& future : lfutures) {
-      auto status_code = future.get();
-
-      if (status_code < 100 || status_code >= 400) {
-        final_status_code = status_code;
+    if (--pushes->pending == 0) {
+      if (pushes->error) {
+        pushes->promise.set_exception(pushes->error);
+      } else {
+        pushes->promise.set_value(pushes->final_status_code);
       }
     }
+  };
 
-    return final_status_code;
+  // only the live collectables are taken under the lock, collecting and
+  // serializing them neither blocks the caller nor other pushes
+  const auto pushed = snapshot();
+
+  auto push_all = [pushes, done, pushed,
+                   method](detail::CurlWrapper& curlWrapper) {
+    for (const auto& collectable : pushed.collectables) {
+      const char* content_encoding;
+      std::string body;
+      try {
+        body = serialize(*collectable.first, pushed.codec.get(),
+                         content_encoding);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{pushes->mutex};
+        pushes->error = std::current_exception();
+        break;
+      }
+      {
+        std::lock_guard<std::mutex> lock{pushes->mutex};
+        ++pushes->pending;
+      }
+      curlWrapper.performHttpRequestAsync(method, collectable.second,
+                                          std::move(body), content_encoding,
+                                          done);
+    }
+    done(200);
   };
 
-  return std::async(std::launch::async, reduceFutures, std::move(futures));
+  if (pushed.executor) {
+    // keeps the wrapper alive if the gateway is destroyed first
+    std::shared_ptr<detail::CurlWrapper> curlWrapper = curlWrapper_;
+    pushed.executor([push_all, curlWrapper] { push_all(*curlWrapper); });
+  } else {
+    // the wrapper runs the tasks posted to it before it is destroyed
+    auto* curlWrapper = curlWrapper_.get();
+    curlWrapper->post([push_all, curlWrapper] { push_all(*curlWrapper); });
+  }
+  return result;
 }
 
 int Gateway::Delete() {
@@ -191,7 +318,7 @@ int Gateway::Delete() {
 }
 
 std::future<int> Gateway::AsyncDelete() {
-  return std::async(std::launch::async, [&] { return Delete(); });
+  return asyncRequest(*curlWrapper_, detail::HttpMethod::Delete, jobUri_);
 }
 
 int Gateway::DeleteForInstance() {
@@ -200,7 +327,8 @@ int Gateway::DeleteForInstance() {
 }
 
 std::future<int> Gateway::AsyncDeleteForInstance() {
-  return std::async(std::launch::async, [&] { return DeleteForInstance(); });
+  return asyncRequest(*curlWrapper_, detail::HttpMethod::Delete,
+                      jobUri_ + labels_);
 }
 
 void Gateway::CleanupStalePointers(
@@ -217,4 +345,43 @@ bool Gateway::AddHttpHeader(const std::string& header) {
   return curlWrapper_->addHttpHeader(header);
 }
 
+bool Gateway::SetContentEncoding(const std::string& encoding) {
+  std::shared_ptr<const detail::Codec> codec;
+  if (encoding == "gzip") {
+    codec = detail::MakeGzipCodec();
+  } else if (encoding == "zstd") {
+    codec = detail::MakeZstdCodec();
+  }
+  if (!codec && !encoding.empty()) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  codec_ = std::move(codec);
+  return true;
+}
+
+void Gateway::StartPeriodicPush(const PeriodicPushOptions& options) {
+  const auto method = options.push_add ? detail::HttpMethod::Put
+                                       : detail::HttpMethod::Post;
+  std::lock_guard<std::mutex> lock{periodic_pusher_mutex_};
+  periodic_pusher_.reset();
+  periodic_pusher_ = detail::make_unique<detail::PeriodicPusher>(
+      [this, method] { return push(method); }, options);
+  // a group of its own, so pushing it does not replace the application's
+  // metrics
+  const auto labels = Labels{{"component", "gateway"}};
+  RegisterCollectable(periodic_pusher_->GetRegistry(), &labels);
+}
+
+void Gateway::StopPeriodicPush() {
+  std::lock_guard<std::mutex> lock{periodic_pusher_mutex_};
+  periodic_pusher_.reset();
+}
+
+void Gateway::SetCollectionExecutor(Executor executor) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  collection_executor_ = std::move(executor);
+}
+
 }  // namespace prometheus
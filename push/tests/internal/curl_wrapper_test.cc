@@ -0,0 +1,175 @@
+#include "detail/curl_wrapper.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace prometheus {
+namespace {
+
+// Answers requests without a body once the expected number of them
+// arrived, so requests only succeed if they are performed concurrently
+class RendezvousServer {
+ public:
+  explicit RendezvousServer(int expected) : expected_(expected) {
+    listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (listener_ < 0 ||
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), length) !=
+            0 ||
+        ::listen(listener_, SOMAXCONN) != 0 ||
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address),
+                      &length) != 0) {
+      throw std::runtime_error("cannot listen on the loopback interface");
+    }
+    url_ = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+    threads_.emplace_back([this] { Accept(); });
+  }
+
+  ~RendezvousServer() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      for (auto fd : connections_) {
+        ::shutdown(fd, SHUT_RDWR);
+      }
+    }
+    ::shutdown(listener_, SHUT_RDWR);
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    ::close(listener_);
+  }
+
+  const std::string& Url() const { return url_; }
+
+  int Connections() const { return accepted_; }
+
+ private:
+  void Accept() {
+    for (;;) {
+      const auto fd = ::accept(listener_, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      std::lock_guard<std::mutex> lock{mutex_};
+      ++accepted_;
+      connections_.push_back(fd);
+      threads_.emplace_back([this, fd] { Serve(fd); });
+    }
+  }
+
+  void Serve(int fd) {
+    static const char kResponse[] =
+        "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    std::string input;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+      input.append(buffer, static_cast<std::size_t>(count));
+      while (input.find("\r\n\r\n") != std::string::npos) {
+        input.erase(0, input.find("\r\n\r\n") + 4);
+        {
+          std::unique_lock<std::mutex> lock{mutex_};
+          ++arrived_;
+          arrived_all_.notify_all();
+          arrived_all_.wait_for(lock, std::chrono::seconds{5},
+                                [this] { return arrived_ >= expected_; });
+        }
+        ::send(fd, kResponse, sizeof(kResponse) - 1, MSG_NOSIGNAL);
+      }
+    }
+    ::close(fd);
+  }
+
+  const int expected_;
+  int listener_ = -1;
+  std::string url_;
+  std::atomic<int> accepted_{0};
+  std::mutex mutex_;
+  std::condition_variable arrived_all_;
+  int arrived_ = 0;
+  std::vector<int> connections_;
+  std::vector<std::thread> threads_;
+};
+
+TEST(CurlWrapperTest, shouldPerformRequestsConcurrently) {
+  RendezvousServer server{4};
+  detail::CurlWrapper curl{nullptr};
+
+  std::vector<std::future<int>> responses;
+  for (int i = 0; i < 4; ++i) {
+    auto status = std::make_shared<std::promise<int>>();
+    responses.push_back(status->get_future());
+    curl.performHttpRequestAsync(
+        detail::HttpMethod::Delete, server.Url() + "/metrics", {}, nullptr,
+        [status](int code) { status->set_value(code); });
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (auto& response : responses) {
+    EXPECT_EQ(response.get(), 200);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{5});
+}
+
+TEST(CurlWrapperTest, shouldReuseConnections) {
+  RendezvousServer server{1};
+  detail::CurlWrapper curl{nullptr};
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(curl.performHttpRequest(detail::HttpMethod::Post,
+                                      server.Url() + "/metrics", "body"),
+              200);
+  }
+  EXPECT_EQ(server.Connections(), 1);
+}
+
+TEST(CurlWrapperTest, shouldRunPostedTasksBeforeTheirRequests) {
+  RendezvousServer server{1};
+  detail::CurlWrapper curl{nullptr};
+  auto status = std::make_shared<std::promise<int>>();
+  auto response = status->get_future();
+  std::thread::id task_thread;
+
+  curl.post([&curl, &server, &task_thread, status] {
+    task_thread = std::this_thread::get_id();
+    curl.performHttpRequestAsync(
+        detail::HttpMethod::Post, server.Url() + "/metrics", "body", nullptr,
+        [status](int code) { status->set_value(code); });
+  });
+
+  EXPECT_EQ(response.get(), 200);
+  EXPECT_NE(task_thread, std::this_thread::get_id());
+}
+
+TEST(CurlWrapperTest, shouldReportConnectionErrors) {
+  detail::CurlWrapper curl{nullptr};
+
+  EXPECT_LT(curl.performHttpRequest(detail::HttpMethod::Delete,
+                                    "http://127.0.0.1:1/metrics"),
+            0);
+}
+
+}  // namespace
+}  // namespace prometheus
+
+#endif
@@ -0,0 +1,133 @@
+#include "detail/periodic_pusher.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "prometheus/collectable.h"
+#include "prometheus/metric_family.h"
+
+namespace prometheus {
+namespace {
+
+using Clock = detail::PeriodicPusher::Clock;
+using std::chrono::milliseconds;
+
+PeriodicPushOptions Every(milliseconds interval) {
+  auto options = PeriodicPushOptions{};
+  options.interval = interval;
+  options.jitter = 0;
+  return options;
+}
+
+// Waits up to a few seconds for the condition
+template <typename Condition>
+bool Eventually(Condition condition) {
+  const auto deadline = Clock::now() + std::chrono::seconds{5};
+  while (!condition()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(milliseconds{1});
+  }
+  return true;
+}
+
+double CountPushes(const Registry& registry, const std::string& result) {
+  for (const auto& family : registry.Collect()) {
+    if (family.name != "gateway_pushes_total") {
+      continue;
+    }
+    for (const auto& metric : family.metric) {
+      if (metric.label.at(0).value == result) {
+        return metric.counter.value;
+      }
+    }
+  }
+  return -1;
+}
+
+TEST(PeriodicPusherTest, shouldPushPeriodically) {
+  std::atomic<int> pushes{0};
+  auto push = [&pushes] {
+    ++pushes;
+    return 200;
+  };
+  detail::PeriodicPusher pusher{push, Every(milliseconds{5})};
+
+  EXPECT_TRUE(Eventually([&pushes] { return pushes >= 3; }));
+  EXPECT_TRUE(Eventually([&pusher] {
+    return CountPushes(*pusher.GetRegistry(), "success") >= 3;
+  }));
+}
+
+TEST(PeriodicPusherTest, shouldCoalescePushesInFlight) {
+  std::atomic<int> in_flight{0};
+  std::atomic<int> max_in_flight{0};
+  std::atomic<int> pushes{0};
+  auto push = [&] {
+    max_in_flight = std::max(max_in_flight.load(), ++in_flight);
+    std::this_thread::sleep_for(milliseconds{20});
+    --in_flight;
+    ++pushes;
+    return 200;
+  };
+  detail::PeriodicPusher pusher{push, Every(milliseconds{1})};
+
+  EXPECT_TRUE(Eventually([&pushes] { return pushes >= 3; }));
+  EXPECT_EQ(max_in_flight, 1);
+  EXPECT_GT(CountPushes(*pusher.GetRegistry(), "coalesced"), 0);
+}
+
+TEST(PeriodicPusherTest, shouldCountFailures) {
+  detail::PeriodicPusher pusher{[] { return 503; }, Every(milliseconds{1})};
+
+  EXPECT_TRUE(Eventually([&pusher] {
+    return CountPushes(*pusher.GetRegistry(), "failure") >= 1;
+  }));
+  EXPECT_EQ(CountPushes(*pusher.GetRegistry(), "success"), 0);
+}
+
+// Throws something not derived from std::exception
+class ThrowingCollectable : public Collectable {
+ public:
+  std::vector<MetricFamily> Collect() const override { throw 42; }
+};
+
+TEST(PeriodicPusherTest, shouldCountThrowingPushesAsFailures) {
+  ThrowingCollectable collectable;
+  std::atomic<int> pushes{0};
+  auto push = [&] {
+    ++pushes;
+    collectable.Collect();
+    return 200;
+  };
+  detail::PeriodicPusher pusher{push, Every(milliseconds{1})};
+
+  EXPECT_TRUE(Eventually([&pushes] { return pushes >= 2; }));
+  EXPECT_TRUE(Eventually([&pusher] {
+    return CountPushes(*pusher.GetRegistry(), "failure") >= 1;
+  }));
+  EXPECT_EQ(CountPushes(*pusher.GetRegistry(), "success"), 0);
+}
+
+TEST(PeriodicPusherTest, shouldBackOffExponentially) {
+  const auto backoff = [](std::size_t failures) {
+    return detail::PeriodicPusher::Backoff(milliseconds{100},
+                                           milliseconds{1000}, failures);
+  };
+
+  EXPECT_EQ(backoff(0), milliseconds{100});
+  EXPECT_EQ(backoff(1), milliseconds{200});
+  EXPECT_EQ(backoff(3), milliseconds{800});
+  EXPECT_EQ(backoff(4), milliseconds{1000});
+  EXPECT_EQ(backoff(1000), milliseconds{1000});
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Stream buffer compressing its content into another stream buffer.
+///
+/// Data is compressed as it arrives and passed on whenever the output buffer
+/// is full, so neither the uncompressed nor the compressed content is held in
+/// memory as a whole.
+class Encoder : public std::streambuf {
+ public:
+  /// \brief Returns false if the compressor could not be initialized or
+  /// writing failed.
+  virtual bool Good() const = 0;
+
+  /// \brief Compresses the remaining data and ends the compressed stream.
+  ///
+  /// \return False if compressing or writing failed.
+  virtual bool Finish() = 0;
+};
+
+/// \brief Content coding of HTTP bodies, e.g., gzip.
+class Codec {
+ public:
+  virtual ~Codec() = default;
+
+  /// \brief Name of the coding in Accept-Encoding and Content-Encoding.
+  virtual const char* Name() const = 0;
+
+  /// \param out Receives the compressed data.
+  /// \param buffer Memory for compressed data before it is passed on.
+  virtual std::unique_ptr<Encoder> MakeEncoder(
+      std::streambuf& out, std::vector<char>& buffer) const = 0;
+};
+
+/// \brief Codecs in order of preference.
+using Codecs = std::vector<std::shared_ptr<const Codec>>;
+
+/// \brief Picks the codec of a response from the Accept-Encoding header.
+///
+/// Each codec gets the q-value of its coding or, if not listed, of "*". The
+/// codec with the highest q-value wins, ties go to the preferred codec.
+///
+/// \param accept_encoding Value of the header, nullptr if there is none.
+/// \return nullptr if the response should not be compressed.
+const Codec* SelectCodec(const char* accept_encoding, const Codecs& codecs);
+
+}  // namespace detail
+}  // namespace prometheus
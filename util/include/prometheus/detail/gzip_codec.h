@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+
+#include "prometheus/detail/content_codec.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Parameters of deflateInit2().
+struct GzipParameters {
+  /// Z_DEFAULT_COMPRESSION
+  int level = -1;
+  int memory_level = 9;
+  /// Z_DEFAULT_STRATEGY
+  int strategy = 0;
+};
+
+/// \brief Returns the gzip coding, compressing with zlib.
+///
+/// Setting up zlib's state costs more than compressing a small response, so
+/// each thread keeps its state and resets it for the next stream with the
+/// same parameters.
+///
+/// \return nullptr if the library was built without zlib.
+std::shared_ptr<const Codec> MakeGzipCodec(
+    const GzipParameters& parameters = GzipParameters{});
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace prometheus {
+namespace detail {
+
+// Helpers for parsing the values of HTTP headers like Accept and
+// Accept-Encoding as defined by RFC 7231
+
+// q-values in thousandths, so they compare exactly
+const int kMaxQuality = 1000;
+
+inline std::string Trim(const std::string& value) {
+  const auto first = value.find_first_not_of(" \t");
+  if (first == std::string::npos) {
+    return {};
+  }
+  const auto last = value.find_last_not_of(" \t");
+  return value.substr(first, last - first + 1);
+}
+
+inline std::string ToLower(std::string value) {
+  for (auto& c : value) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+  }
+  return value;
+}
+
+inline std::vector<std::string> Split(const std::string& value,
+                                      char separator) {
+  std::vector<std::string> parts;
+  std::size_t first = 0;
+  for (;;) {
+    const auto last = value.find(separator, first);
+    if (last == std::string::npos) {
+      parts.push_back(value.substr(first));
+      return parts;
+    }
+    parts.push_back(value.substr(first, last - first));
+    first = last + 1;
+  }
+}
+
+// Parses a qvalue, returns -1 if it is invalid
+inline int ParseQuality(const std::string& value) {
+  if (value.empty() || (value[0] != '0' && value[0] != '1')) {
+    return -1;
+  }
+  auto quality = (value[0] - '0') * kMaxQuality;
+  if (value.size() > 1) {
+    if (value[1] != '.' || value.size() > 5) {
+      return -1;
+    }
+    auto scale = kMaxQuality / 10;
+    for (std::size_t i = 2; i < value.size(); ++i, scale /= 10) {
+      if (value[i] < '0' || value[i] > '9') {
+        return -1;
+      }
+      quality += (value[i] - '0') * scale;
+    }
+  }
+  return quality > kMaxQuality ? -1 : quality;
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <memory>
+
+#include "prometheus/detail/content_codec.h"
+
+namespace prometheus {
+namespace detail {
+
+/// \brief Returns the zstd coding as defined by RFC 8878.
+///
+/// Like the gzip coding, each thread keeps its compression context and
+/// resets it for the next stream.
+///
+/// \param level Compression level, 0 for the zstd default.
+/// \return nullptr if the library was built without zstd.
+std::shared_ptr<const Codec> MakeZstdCodec(int level = 0);
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,59 @@
+#include "prometheus/detail/content_codec.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "prometheus/detail/http_header.h"
+
+namespace prometheus {
+namespace detail {
+
+const Codec* SelectCodec(const char* accept_encoding, const Codecs& codecs) {
+  if (!accept_encoding || codecs.empty()) {
+    return nullptr;
+  }
+
+  struct Coding {
+    std::string name;
+    int quality;
+  };
+  std::vector<Coding> codings;
+  for (const auto& text : Split(accept_encoding, ',')) {
+    const auto parts = Split(text, ';');
+    auto coding = Coding{ToLower(Trim(parts[0])), kMaxQuality};
+    for (std::size_t i = 1; i < parts.size(); ++i) {
+      const auto parameter = Trim(parts[i]);
+      if (parameter.size() > 2 && ToLower(parameter.substr(0, 2)) == "q=") {
+        coding.quality = ParseQuality(Trim(parameter.substr(2)));
+      }
+    }
+    if (coding.quality >= 0) {
+      codings.push_back(std::move(coding));
+    }
+  }
+
+  const Codec* best = nullptr;
+  auto best_quality = 0;
+  for (const auto& codec : codecs) {
+    auto quality = 0;
+    auto listed = false;
+    for (const auto& coding : codings) {
+      if (coding.name == codec->Name()) {
+        quality = coding.quality;
+        listed = true;
+      } else if (coding.name == "*" && !listed) {
+        quality = coding.quality;
+      }
+    }
+    // codecs are ordered by preference, so only a higher quality wins
+    if (quality > best_quality) {
+      best = codec.get();
+      best_quality = quality;
+    }
+  }
+  return best;
+}
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,203 @@
+#include "prometheus/detail/gzip_codec.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+
+#include <cstddef>
+#include <limits>
+#include <streambuf>
+#include <vector>
+#endif
+
+namespace prometheus {
+namespace detail {
+
+#ifdef HAVE_ZLIB
+namespace {
+
+// Stream buffer compressing its content with gzip
+class GzipStreamBuffer : public Encoder {
+ public:
+  GzipStreamBuffer(std::streambuf& out, std::vector<char>& buffer,
+                   const GzipParameters& parameters)
+      : out_(out),
+        buffer_(buffer),
+        stream_(ThreadState::Get().Acquire(parameters)),
+        own_stream_() {
+    if (!stream_ && Init(own_stream_, parameters)) {
+      stream_ = &own_stream_;
+    }
+    good_ = stream_ && !buffer_.empty();
+  }
+
+  ~GzipStreamBuffer() override {
+    if (stream_ && !ThreadState::Get().Release(stream_)) {
+      deflateEnd(stream_);
+    }
+  }
+
+  GzipStreamBuffer(const GzipStreamBuffer&) = delete;
+  GzipStreamBuffer& operator=(const GzipStreamBuffer&) = delete;
+
+  bool Good() const override { return good_; }
+
+  bool Finish() override { return Deflate(nullptr, 0, Z_FINISH); }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+    }
+    const auto c = traits_type::to_char_type(ch);
+    return Deflate(&c, 1, Z_NO_FLUSH) ? ch : traits_type::eof();
+  }
+
+  std::streamsize xsputn(const char_type* s, std::streamsize count) override {
+    return Deflate(s, static_cast<std::size_t>(count), Z_NO_FLUSH) ? count
+                                                                   : 0;
+  }
+
+ private:
+  static bool Init(z_stream& stream, const GzipParameters& parameters) {
+    const auto windowBits = 16 + MAX_WBITS;  // gzip header and trailer
+    stream = z_stream{};
+    return deflateInit2(&stream, parameters.level, Z_DEFLATED, windowBits,
+                        parameters.memory_level, parameters.strategy) == Z_OK;
+  }
+
+  // Deflate state of a thread, reset and reused by consecutive streams
+  class ThreadState {
+   public:
+    static ThreadState& Get() {
+      thread_local ThreadState state;
+      return state;
+    }
+
+    ThreadState() = default;
+    ThreadState(const ThreadState&) = delete;
+    ThreadState& operator=(const ThreadState&) = delete;
+
+    ~ThreadState() {
+      if (initialized_) {
+        deflateEnd(&stream_);
+      }
+    }
+
+    // Returns nullptr if the state is in use or cannot be initialized
+    z_stream* Acquire(const GzipParameters& parameters) {
+      if (in_use_) {
+        return nullptr;
+      }
+
+      const auto same_parameters =
+          parameters.level == parameters_.level &&
+          parameters.memory_level == parameters_.memory_level &&
+          parameters.strategy == parameters_.strategy;
+      if (!initialized_ || !same_parameters ||
+          deflateReset(&stream_) != Z_OK) {
+        if (initialized_) {
+          deflateEnd(&stream_);
+        }
+        initialized_ = Init(stream_, parameters);
+        parameters_ = parameters;
+      }
+      if (!initialized_) {
+        return nullptr;
+      }
+
+      in_use_ = true;
+      return &stream_;
+    }
+
+    bool Release(z_stream* stream) {
+      if (stream != &stream_) {
+        return false;
+      }
+      in_use_ = false;
+      return true;
+    }
+
+   private:
+    z_stream stream_;
+    GzipParameters parameters_;
+    bool initialized_ = false;
+    bool in_use_ = false;
+  };
+
+  bool Deflate(const char* data, std::size_t size, int flush) {
+    if (!good_) {
+      return false;
+    }
+
+    // zlib counts in uInt, larger inputs are compressed piecewise
+    const std::size_t kMaxInput = std::numeric_limits<uInt>::max();
+    do {
+      const auto input = size < kMaxInput ? size : kMaxInput;
+      const auto piece_flush = input == size ? flush : Z_NO_FLUSH;
+      stream_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+      stream_->avail_in = static_cast<uInt>(input);
+      data += input;
+      size -= input;
+
+      int ret;
+      do {
+        stream_->next_out = reinterpret_cast<Bytef*>(buffer_.data());
+        stream_->avail_out = static_cast<uInt>(buffer_.size());
+        ret = deflate(stream_, piece_flush);
+        if (ret == Z_STREAM_ERROR) {
+          good_ = false;
+          return false;
+        }
+
+        const auto produced =
+            static_cast<std::streamsize>(buffer_.size() - stream_->avail_out);
+        if (produced != 0 &&
+            out_.sputn(buffer_.data(), produced) != produced) {
+          good_ = false;
+          return false;
+        }
+      } while (stream_->avail_out == 0 ||
+               (piece_flush == Z_FINISH && ret != Z_STREAM_END));
+    } while (size != 0);
+
+    return true;
+  }
+
+  std::streambuf& out_;
+  std::vector<char>& buffer_;
+  z_stream* stream_;
+  // used if the state of the thread is already taken
+  z_stream own_stream_;
+  bool good_;
+};
+
+class GzipCodec : public Codec {
+ public:
+  explicit GzipCodec(const GzipParameters& parameters)
+      : parameters_(parameters) {}
+
+  const char* Name() const override { return "gzip"; }
+
+  std::unique_ptr<Encoder> MakeEncoder(
+      std::streambuf& out, std::vector<char>& buffer) const override {
+    return std::unique_ptr<Encoder>{
+        new GzipStreamBuffer{out, buffer, parameters_}};
+  }
+
+ private:
+  const GzipParameters parameters_;
+};
+
+}  // namespace
+
+std::shared_ptr<const Codec> MakeGzipCodec(const GzipParameters& parameters) {
+  return std::make_shared<GzipCodec>(parameters);
+}
+#else
+std::shared_ptr<const Codec> MakeGzipCodec(const GzipParameters&) {
+  return nullptr;
+}
+#endif
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,156 @@
+#include "prometheus/detail/zstd_codec.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+#endif
+
+namespace prometheus {
+namespace detail {
+
+#ifdef HAVE_ZSTD
+namespace {
+
+// Stream buffer compressing its content with zstd
+class ZstdStreamBuffer : public Encoder {
+ public:
+  ZstdStreamBuffer(std::streambuf& out, std::vector<char>& buffer, int level)
+      : out_(out), buffer_(buffer), context_(ThreadState::Get().Acquire()) {
+    if (!context_) {
+      own_context_ = ZSTD_createCCtx();
+      context_ = own_context_;
+    }
+    good_ = context_ && !buffer_.empty() &&
+            !ZSTD_isError(ZSTD_CCtx_setParameter(
+                context_, ZSTD_c_compressionLevel, level));
+  }
+
+  ~ZstdStreamBuffer() override {
+    if (own_context_) {
+      ZSTD_freeCCtx(own_context_);
+    } else if (context_) {
+      ThreadState::Get().Release();
+    }
+  }
+
+  ZstdStreamBuffer(const ZstdStreamBuffer&) = delete;
+  ZstdStreamBuffer& operator=(const ZstdStreamBuffer&) = delete;
+
+  bool Good() const override { return good_; }
+
+  bool Finish() override { return Compress(nullptr, 0, ZSTD_e_end); }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+    }
+    const auto c = traits_type::to_char_type(ch);
+    return Compress(&c, 1, ZSTD_e_continue) ? ch : traits_type::eof();
+  }
+
+  std::streamsize xsputn(const char_type* s, std::streamsize count) override {
+    return Compress(s, static_cast<std::size_t>(count), ZSTD_e_continue)
+               ? count
+               : 0;
+  }
+
+ private:
+  // Compression context of a thread, reset and reused by consecutive streams
+  class ThreadState {
+   public:
+    static ThreadState& Get() {
+      thread_local ThreadState state;
+      return state;
+    }
+
+    ThreadState() = default;
+    ThreadState(const ThreadState&) = delete;
+    ThreadState& operator=(const ThreadState&) = delete;
+
+    ~ThreadState() { ZSTD_freeCCtx(context_); }
+
+    // Returns nullptr if the context is in use or cannot be created
+    ZSTD_CCtx* Acquire() {
+      if (in_use_) {
+        return nullptr;
+      }
+      if (!context_) {
+        context_ = ZSTD_createCCtx();
+      } else {
+        ZSTD_CCtx_reset(context_, ZSTD_reset_session_only);
+      }
+      in_use_ = context_ != nullptr;
+      return context_;
+    }
+
+    void Release() { in_use_ = false; }
+
+   private:
+    ZSTD_CCtx* context_ = nullptr;
+    bool in_use_ = false;
+  };
+
+  bool Compress(const char* data, std::size_t size, ZSTD_EndDirective mode) {
+    if (!good_) {
+      return false;
+    }
+
+    auto input = ZSTD_inBuffer{data, size, 0};
+    std::size_t remaining;
+    do {
+      auto output = ZSTD_outBuffer{buffer_.data(), buffer_.size(), 0};
+      remaining = ZSTD_compressStream2(context_, &output, &input, mode);
+      if (ZSTD_isError(remaining)) {
+        good_ = false;
+        return false;
+      }
+
+      const auto produced = static_cast<std::streamsize>(output.pos);
+      if (produced != 0 &&
+          out_.sputn(buffer_.data(), produced) != produced) {
+        good_ = false;
+        return false;
+      }
+    } while (mode == ZSTD_e_end ? remaining != 0 : input.pos != input.size);
+
+    return true;
+  }
+
+  std::streambuf& out_;
+  std::vector<char>& buffer_;
+  ZSTD_CCtx* context_;
+  // used if the context of the thread is already taken
+  ZSTD_CCtx* own_context_ = nullptr;
+  bool good_;
+};
+
+class ZstdCodec : public Codec {
+ public:
+  explicit ZstdCodec(int level) : level_(level) {}
+
+  const char* Name() const override { return "zstd"; }
+
+  std::unique_ptr<Encoder> MakeEncoder(
+      std::streambuf& out, std::vector<char>& buffer) const override {
+    return std::unique_ptr<Encoder>{new ZstdStreamBuffer{out, buffer, level_}};
+  }
+
+ private:
+  const int level_;
+};
+
+}  // namespace
+
+std::shared_ptr<const Codec> MakeZstdCodec(int level) {
+  return std::make_shared<ZstdCodec>(level);
+}
+#else
+std::shared_ptr<const Codec> MakeZstdCodec(int) { return nullptr; }
+#endif
+
+}  // namespace detail
+}  // namespace prometheus
@@ -0,0 +1,76 @@
+#include "prometheus/detail/content_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace prometheus {
+namespace {
+
+class FakeCodec : public detail::Codec {
+ public:
+  explicit FakeCodec(const char* name) : name_(name) {}
+
+  const char* Name() const override { return name_; }
+
+  std::unique_ptr<detail::Encoder> MakeEncoder(
+      std::streambuf&, std::vector<char>&) const override {
+    return nullptr;
+  }
+
+ private:
+  const char* name_;
+};
+
+class ContentCodecTest : public testing::Test {
+ protected:
+  std::string Select(const char* accept_encoding) const {
+    const auto codec = detail::SelectCodec(accept_encoding, codecs_);
+    return codec ? codec->Name() : "identity";
+  }
+
+  detail::Codecs codecs_{std::make_shared<FakeCodec>("zstd"),
+                         std::make_shared<FakeCodec>("gzip")};
+};
+
+TEST_F(ContentCodecTest, shouldNotCompressUnlessAccepted) {
+  EXPECT_EQ(Select(nullptr), "identity");
+  EXPECT_EQ(Select(""), "identity");
+  EXPECT_EQ(Select("identity"), "identity");
+  EXPECT_EQ(Select("br, deflate"), "identity");
+  EXPECT_EQ(Select("gzip;q=0, zstd;q=0"), "identity");
+  EXPECT_EQ(detail::SelectCodec("gzip", {}), nullptr);
+}
+
+TEST_F(ContentCodecTest, shouldMatchWholeCodingNames) {
+  EXPECT_EQ(Select("x-gzip"), "identity");
+  EXPECT_EQ(Select("GZip"), "gzip");
+  EXPECT_EQ(Select("deflate, gzip"), "gzip");
+}
+
+TEST_F(ContentCodecTest, shouldPreferHigherQuality) {
+  EXPECT_EQ(Select("zstd;q=0.5, gzip"), "gzip");
+  EXPECT_EQ(Select("gzip;q=0.5, zstd;q=0.6"), "zstd");
+  EXPECT_EQ(Select("gzip, zstd;q=0"), "gzip");
+}
+
+TEST_F(ContentCodecTest, shouldPreferFirstCodecOnTies) {
+  EXPECT_EQ(Select("gzip, zstd"), "zstd");
+  EXPECT_EQ(Select("*"), "zstd");
+}
+
+TEST_F(ContentCodecTest, shouldUseWildcardForUnlistedCodings) {
+  EXPECT_EQ(Select("zstd;q=0, *"), "gzip");
+  EXPECT_EQ(Select("*;q=0.1, gzip;q=0.2"), "gzip");
+}
+
+TEST_F(ContentCodecTest, shouldIgnoreInvalidQuality) {
+  EXPECT_EQ(Select("zstd;q=2, gzip"), "gzip");
+  EXPECT_EQ(Select("zstd;q=x"), "identity");
+}
+
+}  // namespace
+}  // namespace prometheus
@@ -0,0 +1,115 @@
+#include "prometheus/detail/gzip_codec.h"
+
+#include <gtest/gtest.h>
+
+#ifdef HAVE_ZLIB
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace prometheus {
+namespace {
+
+std::string Decompress(const std::string& input) {
+  auto zs = z_stream{};
+  EXPECT_EQ(inflateInit2(&zs, 16 + MAX_WBITS), Z_OK);
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  zs.avail_in = static_cast<uInt>(input.size());
+
+  std::string output;
+  int ret;
+  do {
+    char buffer[1024];
+    zs.next_out = reinterpret_cast<Bytef*>(buffer);
+    zs.avail_out = sizeof(buffer);
+    ret = inflate(&zs, Z_NO_FLUSH);
+    output.append(buffer, sizeof(buffer) - zs.avail_out);
+  } while (ret == Z_OK);
+  inflateEnd(&zs);
+
+  EXPECT_EQ(ret, Z_STREAM_END);
+  return output;
+}
+
+std::unique_ptr<detail::Encoder> MakeEncoder(
+    std::stringstream& compressed, std::vector<char>& buffer,
+    const detail::GzipParameters& parameters = detail::GzipParameters{}) {
+  return detail::MakeGzipCodec(parameters)->MakeEncoder(*compressed.rdbuf(),
+                                                        buffer);
+}
+
+TEST(GzipCodecTest, shouldCompressStreamedData) {
+  std::stringstream compressed;
+  std::vector<char> buffer(16);
+  auto gzip = MakeEncoder(compressed, buffer);
+  ASSERT_TRUE(gzip->Good());
+
+  std::ostream out{gzip.get()};
+  std::string expected;
+  for (std::size_t i = 0; i < 10000; ++i) {
+    const auto line = "metric{id=\"" + std::to_string(i) + "\"} 1\n";
+    out << line;
+    expected += line;
+  }
+  out << '#';
+  expected += '#';
+  ASSERT_TRUE(gzip->Finish());
+
+  EXPECT_LT(compressed.str().size(), expected.size() / 4);
+  EXPECT_EQ(Decompress(compressed.str()), expected);
+}
+
+TEST(GzipCodecTest, shouldCompressEmptyData) {
+  std::stringstream compressed;
+  std::vector<char> buffer(16);
+  ASSERT_TRUE(MakeEncoder(compressed, buffer)->Finish());
+
+  EXPECT_EQ(Decompress(compressed.str()), "");
+}
+
+// Consecutive streams on a thread share the deflate state, nested streams
+// need their own
+TEST(GzipCodecTest, shouldCompressConsecutiveAndNestedStreams) {
+  auto parameters = detail::GzipParameters{};
+  std::vector<char> buffer(16);
+  for (auto level : {1, 9, 9, Z_NO_COMPRESSION}) {
+    parameters.level = level;
+    std::stringstream outer_compressed;
+    std::stringstream inner_compressed;
+    auto outer = MakeEncoder(outer_compressed, buffer, parameters);
+    {
+      auto inner = MakeEncoder(inner_compressed, buffer, parameters);
+      std::ostream{inner.get()} << "inner";
+      ASSERT_TRUE(inner->Finish());
+    }
+    std::ostream{outer.get()} << "outer";
+    ASSERT_TRUE(outer->Finish());
+
+    EXPECT_EQ(Decompress(outer_compressed.str()), "outer");
+    EXPECT_EQ(Decompress(inner_compressed.str()), "inner");
+  }
+}
+
+TEST(GzipCodecTest, shouldBeNamedGzip) {
+  EXPECT_STREQ(detail::MakeGzipCodec()->Name(), "gzip");
+}
+
+TEST(GzipCodecTest, shouldFailOnInvalidParameters) {
+  auto parameters = detail::GzipParameters{};
+  parameters.memory_level = 10;
+  std::stringstream compressed;
+  std::vector<char> buffer(16);
+
+  EXPECT_FALSE(MakeEncoder(compressed, buffer, parameters)->Good());
+}
+
+}  // namespace
+}  // namespace prometheus
+
+#endif
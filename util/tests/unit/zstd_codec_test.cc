@@ -0,0 +1,83 @@
+#include "prometheus/detail/zstd_codec.h"
+
+#include <gtest/gtest.h>
+
+#ifdef HAVE_ZSTD
+
+#include <zstd.h>
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace prometheus {
+namespace {
+
+std::string Decompress(const std::string& input) {
+  auto context = std::shared_ptr<ZSTD_DCtx>(ZSTD_createDCtx(), ZSTD_freeDCtx);
+  auto in = ZSTD_inBuffer{input.data(), input.size(), 0};
+
+  std::string output;
+  std::size_t ret;
+  do {
+    char buffer[1024];
+    auto out = ZSTD_outBuffer{buffer, sizeof(buffer), 0};
+    ret = ZSTD_decompressStream(context.get(), &out, &in);
+    EXPECT_FALSE(ZSTD_isError(ret));
+    output.append(buffer, out.pos);
+  } while (ret != 0 && !ZSTD_isError(ret));
+
+  EXPECT_EQ(in.pos, input.size());
+  return output;
+}
+
+TEST(ZstdCodecTest, shouldCompressStreamedData) {
+  const auto codec = detail::MakeZstdCodec();
+  std::stringstream compressed;
+  std::vector<char> buffer(16);
+  auto zstd = codec->MakeEncoder(*compressed.rdbuf(), buffer);
+  ASSERT_TRUE(zstd->Good());
+
+  std::ostream out{zstd.get()};
+  std::string expected;
+  for (std::size_t i = 0; i < 10000; ++i) {
+    const auto line = "metric{id=\"" + std::to_string(i) + "\"} 1\n";
+    out << line;
+    expected += line;
+  }
+  out << '#';
+  expected += '#';
+  ASSERT_TRUE(zstd->Finish());
+
+  EXPECT_STREQ(codec->Name(), "zstd");
+  EXPECT_LT(compressed.str().size(), expected.size() / 4);
+  EXPECT_EQ(Decompress(compressed.str()), expected);
+}
+
+TEST(ZstdCodecTest, shouldCompressConsecutiveAndNestedStreams) {
+  std::vector<char> buffer(16);
+  for (auto level : {1, 19, 19, 0}) {
+    const auto codec = detail::MakeZstdCodec(level);
+    std::stringstream outer_compressed;
+    std::stringstream inner_compressed;
+    auto outer = codec->MakeEncoder(*outer_compressed.rdbuf(), buffer);
+    {
+      auto inner = codec->MakeEncoder(*inner_compressed.rdbuf(), buffer);
+      std::ostream{inner.get()} << "inner";
+      ASSERT_TRUE(inner->Finish());
+    }
+    std::ostream{outer.get()} << "outer";
+    ASSERT_TRUE(outer->Finish());
+
+    EXPECT_EQ(Decompress(outer_compressed.str()), "outer");
+    EXPECT_EQ(Decompress(inner_compressed.str()), "inner");
+  }
+}
+
+}  // namespace
+}  // namespace prometheus
+
+#endif